@@ -0,0 +1,196 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Read-mostly map from hashes to objects owned elsewhere, for caches which are hit far more often than they grow.
+ *        Lookups never lock: they probe an open addressing table published with an atomic pointer, so any number of
+ *        threads can look up concurrently with a writer. A lookup racing with the insertion of its key may miss, the
+ *        caller then takes its slow path, which finds the object under its lock.
+ *        Insertions must be serialized by the caller. A table which fills up is replaced by a larger copy, the old one
+ *        is kept alive until clear, as lookups may still be probing it.
+ */
+template <class T>
+class ConcurrentLookupTable
+{
+  public:
+	ConcurrentLookupTable() = default;
+
+	ConcurrentLookupTable(const ConcurrentLookupTable &) = delete;
+
+	ConcurrentLookupTable(ConcurrentLookupTable &&) = delete;
+
+	ConcurrentLookupTable &operator=(const ConcurrentLookupTable &) = delete;
+
+	ConcurrentLookupTable &operator=(ConcurrentLookupTable &&) = delete;
+
+	/**
+	 * @brief Looks an object up, safe to call concurrently with any call but clear
+	 * @return The object of the key, nullptr if it is not found
+	 */
+	T *find(size_t key) const
+	{
+		const Table *table = current.load(std::memory_order_acquire);
+		if (!table)
+		{
+			return nullptr;
+		}
+
+		for (size_t index = table->get_first_index(key);; index = (index + 1) & table->mask)
+		{
+			auto &slot  = table->slots[index];
+			T    *value = slot.value.load(std::memory_order_acquire);
+
+			// Keys are written once, before the value which publishes them
+			if (!value)
+			{
+				return nullptr;
+			}
+
+			if (slot.key == key)
+			{
+				return value;
+			}
+		}
+	}
+
+	/**
+	 * @brief Inserts an object, or replaces the object of the key
+	 *        The calls must be serialized, but they can run concurrently with find
+	 */
+	void insert(size_t key, T *value)
+	{
+		Table *table = current.load(std::memory_order_relaxed);
+
+		// Half full at most, so that probing stays short and always reaches an empty slot
+		if (!table || (count + 1) * 2 > table->mask + 1)
+		{
+			table = grow(table);
+		}
+
+		if (table->insert(key, value))
+		{
+			count++;
+		}
+	}
+
+	/**
+	 * @brief Removes every object, must not run concurrently with any other call
+	 */
+	void clear()
+	{
+		current.store(nullptr, std::memory_order_relaxed);
+		tables.clear();
+		count = 0;
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+
+  private:
+	struct Slot
+	{
+		size_t key{0};
+
+		std::atomic<T *> value{nullptr};
+	};
+
+	struct Table
+	{
+		explicit Table(size_t capacity) :
+		    mask{capacity - 1},
+		    slots{new Slot[capacity]}
+		{
+		}
+
+		size_t get_first_index(size_t key) const
+		{
+			// The keys already are hashes, mixing them spreads the ones which only differ in their high bits
+			uint64_t mixed = static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ull;
+			return static_cast<size_t>(mixed >> 32) & mask;
+		}
+
+		/**
+		 * @return Whether the key was not in the table yet
+		 */
+		bool insert(size_t key, T *value)
+		{
+			for (size_t index = get_first_index(key);; index = (index + 1) & mask)
+			{
+				auto &slot = slots[index];
+				if (!slot.value.load(std::memory_order_relaxed))
+				{
+					slot.key = key;
+					slot.value.store(value, std::memory_order_release);
+					return true;
+				}
+
+				if (slot.key == key)
+				{
+					slot.value.store(value, std::memory_order_release);
+					return false;
+				}
+			}
+		}
+
+		size_t mask;
+
+		std::unique_ptr<Slot[]> slots;
+	};
+
+	Table *grow(Table *table)
+	{
+		size_t capacity = table ? (table->mask + 1) * 2 : 64;
+
+		auto new_table = std::make_unique<Table>(capacity);
+		if (table)
+		{
+			for (size_t index = 0; index <= table->mask; index++)
+			{
+				auto &slot = table->slots[index];
+				if (T *value = slot.value.load(std::memory_order_relaxed))
+				{
+					new_table->insert(slot.key, value);
+				}
+			}
+		}
+
+		table = new_table.get();
+		tables.push_back(std::move(new_table));
+		current.store(table, std::memory_order_release);
+		return table;
+	}
+
+	std::atomic<Table *> current{nullptr};
+
+	/// Current table last, preceded by the ones it replaced
+	std::vector<std::unique_ptr<Table>> tables;
+
+	size_t count{0};
+};
+}        // namespace vkb
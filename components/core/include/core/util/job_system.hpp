@@ -0,0 +1,199 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vkb
+{
+/**
+ * @brief Counts the jobs of a group which have not completed yet.
+ *        A counter is waited on with JobSystem::wait, which rethrows the first exception thrown by the jobs.
+ *        It must outlive its jobs, and cannot be reused before it is waited on.
+ */
+class JobCounter
+{
+  public:
+	JobCounter() = default;
+
+	JobCounter(const JobCounter &) = delete;
+
+	JobCounter &operator=(const JobCounter &) = delete;
+
+	bool is_done() const;
+
+  private:
+	friend class JobSystem;
+
+	std::atomic<uint32_t> pending{0};
+
+	std::mutex exception_mutex;
+
+	std::exception_ptr exception;
+};
+
+/**
+ * @brief Work-stealing scheduler shared by the whole process.
+ *        Every worker owns a deque, it runs its newest jobs first and steals the oldest jobs of the others
+ *        when it runs out. The main thread owns a deque too, which receives the jobs scheduled from threads
+ *        which are not workers. A thread waiting on a counter runs jobs until the counter completes, so that
+ *        jobs can wait on the jobs they schedule without blocking a worker.
+ *        Jobs which must run on the main thread, such as window or GPU queue access, are queued separately
+ *        and run by the main thread when it waits, or once per frame from run_main_thread_jobs.
+ */
+class JobSystem
+{
+  public:
+	using Job = std::function<void()>;
+
+	/**
+	 * @brief Gets the scheduler of the process, created on first use with one worker per hardware
+	 *        thread besides the calling thread, which becomes the main thread
+	 */
+	static JobSystem &get();
+
+	/**
+	 * @param worker_count Number of worker threads, the calling thread becomes the main thread
+	 */
+	explicit JobSystem(uint32_t worker_count);
+
+	JobSystem(const JobSystem &) = delete;
+
+	JobSystem(JobSystem &&) = delete;
+
+	~JobSystem();
+
+	JobSystem &operator=(const JobSystem &) = delete;
+
+	JobSystem &operator=(JobSystem &&) = delete;
+
+	/**
+	 * @return Number of worker threads, which run jobs concurrently with the waiting thread
+	 */
+	uint32_t get_worker_count() const;
+
+	/**
+	 * @brief Schedules a job on the deque of the calling thread
+	 * @param counter Counter of the group of the job, incremented until the job completes
+	 * @param job Job to run on any thread
+	 */
+	void schedule(JobCounter &counter, Job &&job);
+
+	/**
+	 * @brief Schedules a job which only runs on the main thread
+	 */
+	void schedule_on_main_thread(JobCounter &counter, Job &&job);
+
+	/**
+	 * @brief Runs jobs until all the jobs of the counter completed
+	 * @throws The first exception thrown by the jobs of the counter
+	 */
+	void wait(JobCounter &counter);
+
+	/**
+	 * @brief Calls func(begin, end) over ranges of [0, count) of at most grain_size elements and waits for them
+	 * @param count Number of elements
+	 * @param grain_size Largest number of elements of a range, 0 to split the elements evenly across the threads
+	 * @param func Function called concurrently with the bounds of each range
+	 */
+	void parallel_for(uint32_t count, uint32_t grain_size, const std::function<void(uint32_t, uint32_t)> &func);
+
+	/**
+	 * @brief Runs the jobs queued for the main thread, called by the main loop every frame
+	 */
+	void run_main_thread_jobs();
+
+	/**
+	 * @return Whether the calling thread is the main thread of the scheduler
+	 */
+	bool is_main_thread() const;
+
+  private:
+	struct Task
+	{
+		Job job;
+
+		JobCounter *counter;
+	};
+
+	/**
+	 * @brief Deque of jobs owned by a thread, and the thread itself for workers
+	 */
+	struct Worker
+	{
+		std::mutex mutex;
+
+		std::deque<Task> tasks;
+
+		std::thread thread;
+	};
+
+	void worker_loop(uint32_t worker_index);
+
+	/**
+	 * @brief Pops the newest job of the own deque, or steals the oldest job of another deque
+	 */
+	bool pop_task(uint32_t worker_index, Task &task);
+
+	bool pop_main_thread_task(Task &task);
+
+	void run_task(Task &task);
+
+	/**
+	 * @brief Wakes a sleeping thread to run a new job
+	 */
+	void wake_one();
+
+	/**
+	 * @return Index of the deque of the calling thread, 0 for the main thread and for threads which are not workers
+	 */
+	uint32_t get_worker_index() const;
+
+	/// Deque of the main thread first, followed by the workers
+	std::vector<std::unique_ptr<Worker>> workers;
+
+	std::thread::id main_thread_id;
+
+	std::mutex main_thread_mutex;
+
+	std::deque<Task> main_thread_tasks;
+
+	/// Jobs in the deques, and jobs queued for the main thread
+	std::atomic<uint32_t> queued_count{0};
+
+	std::atomic<uint32_t> main_thread_queued_count{0};
+
+	/// Threads sleeping on the condition, notified only when there are any
+	std::atomic<uint32_t> sleeping_count{0};
+
+	std::mutex sleep_mutex;
+
+	std::condition_variable sleep_condition;
+
+	std::atomic<bool> stopping{false};
+};
+}        // namespace vkb
@@ -0,0 +1,347 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <core/util/job_system.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+namespace vkb
+{
+namespace
+{
+// Scheduler and deque of the worker running on this thread, if any
+thread_local const JobSystem *current_job_system{nullptr};
+
+thread_local uint32_t current_worker_index{0};
+}        // namespace
+
+bool JobCounter::is_done() const
+{
+	return pending.load() == 0;
+}
+
+JobSystem &JobSystem::get()
+{
+	static JobSystem job_system{std::max(std::thread::hardware_concurrency(), 2u) - 1};
+	return job_system;
+}
+
+JobSystem::JobSystem(uint32_t worker_count) :
+    main_thread_id{std::this_thread::get_id()}
+{
+	for (uint32_t i = 0; i < worker_count + 1; i++)
+	{
+		workers.push_back(std::make_unique<Worker>());
+	}
+
+	// The deques exist before any worker may steal from them
+	for (uint32_t i = 1; i < workers.size(); i++)
+	{
+		workers[i]->thread = std::thread([this, i]() { worker_loop(i); });
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock{sleep_mutex};
+		stopping = true;
+	}
+	sleep_condition.notify_all();
+
+	for (auto &worker : workers)
+	{
+		if (worker->thread.joinable())
+		{
+			worker->thread.join();
+		}
+	}
+}
+
+uint32_t JobSystem::get_worker_count() const
+{
+	return static_cast<uint32_t>(workers.size() - 1);
+}
+
+bool JobSystem::is_main_thread() const
+{
+	return std::this_thread::get_id() == main_thread_id;
+}
+
+uint32_t JobSystem::get_worker_index() const
+{
+	return current_job_system == this ? current_worker_index : 0;
+}
+
+void JobSystem::schedule(JobCounter &counter, Job &&job)
+{
+	counter.pending++;
+
+	// Counted before it is pushed, so that the count never underflows when the job is stolen right away
+	queued_count++;
+
+	auto &worker = *workers[get_worker_index()];
+	{
+		std::lock_guard<std::mutex> lock{worker.mutex};
+		worker.tasks.push_back({std::move(job), &counter});
+	}
+
+	wake_one();
+}
+
+void JobSystem::schedule_on_main_thread(JobCounter &counter, Job &&job)
+{
+	counter.pending++;
+	main_thread_queued_count++;
+
+	{
+		std::lock_guard<std::mutex> lock{main_thread_mutex};
+		main_thread_tasks.push_back({std::move(job), &counter});
+	}
+
+	// Only the main thread can run it, waking any other thread would not do
+	if (sleeping_count > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock{sleep_mutex};
+		}
+		sleep_condition.notify_all();
+	}
+}
+
+void JobSystem::wait(JobCounter &counter)
+{
+	uint32_t worker_index = get_worker_index();
+	bool     main_thread  = is_main_thread();
+
+	while (!counter.is_done())
+	{
+		Task task;
+		if ((main_thread && pop_main_thread_task(task)) || pop_task(worker_index, task))
+		{
+			run_task(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock{sleep_mutex};
+		sleeping_count++;
+		sleep_condition.wait(lock, [this, &counter, main_thread]() {
+			return counter.is_done() || queued_count > 0 || (main_thread && main_thread_queued_count > 0);
+		});
+		sleeping_count--;
+	}
+
+	// The wake up may have been meant for a job this thread leaves behind
+	if (queued_count > 0)
+	{
+		wake_one();
+	}
+
+	std::exception_ptr exception;
+	{
+		std::lock_guard<std::mutex> lock{counter.exception_mutex};
+		std::swap(exception, counter.exception);
+	}
+
+	if (exception)
+	{
+		std::rethrow_exception(exception);
+	}
+}
+
+void JobSystem::parallel_for(uint32_t count, uint32_t grain_size, const std::function<void(uint32_t, uint32_t)> &func)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (grain_size == 0)
+	{
+		auto thread_count = static_cast<uint32_t>(workers.size());
+		grain_size        = (count + thread_count - 1) / thread_count;
+	}
+
+	if (count <= grain_size)
+	{
+		func(0, count);
+		return;
+	}
+
+	JobCounter counter;
+
+	for (uint32_t begin = grain_size; begin < count;)
+	{
+		uint32_t end = count - begin > grain_size ? begin + grain_size : count;
+		schedule(counter, [&func, begin, end]() { func(begin, end); });
+		begin = end;
+	}
+
+	// The calling thread takes the first range, and the jobs reference the function until they complete
+	try
+	{
+		func(0, grain_size);
+	}
+	catch (...)
+	{
+		try
+		{
+			wait(counter);
+		}
+		catch (...)
+		{
+		}
+		throw;
+	}
+
+	wait(counter);
+}
+
+void JobSystem::run_main_thread_jobs()
+{
+	assert(is_main_thread() && "Main thread jobs must be run by the main thread");
+
+	Task task;
+	while (pop_main_thread_task(task))
+	{
+		run_task(task);
+	}
+}
+
+void JobSystem::worker_loop(uint32_t worker_index)
+{
+	current_job_system   = this;
+	current_worker_index = worker_index;
+
+	while (true)
+	{
+		Task task;
+		if (pop_task(worker_index, task))
+		{
+			run_task(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock{sleep_mutex};
+		if (stopping)
+		{
+			break;
+		}
+
+		sleeping_count++;
+		sleep_condition.wait(lock, [this]() { return stopping || queued_count > 0; });
+		sleeping_count--;
+	}
+}
+
+bool JobSystem::pop_task(uint32_t worker_index, Task &task)
+{
+	if (queued_count == 0)
+	{
+		return false;
+	}
+
+	// Newest job of the own deque, which is likely to share data with the job that scheduled it
+	{
+		auto &worker = *workers[worker_index];
+
+		std::lock_guard<std::mutex> lock{worker.mutex};
+		if (!worker.tasks.empty())
+		{
+			task = std::move(worker.tasks.back());
+			worker.tasks.pop_back();
+			queued_count--;
+			return true;
+		}
+	}
+
+	// Oldest job of another deque, which is likely to be the largest
+	for (size_t offset = 1; offset < workers.size(); offset++)
+	{
+		auto &victim = *workers[(worker_index + offset) % workers.size()];
+
+		std::lock_guard<std::mutex> lock{victim.mutex};
+		if (!victim.tasks.empty())
+		{
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			queued_count--;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool JobSystem::pop_main_thread_task(Task &task)
+{
+	if (main_thread_queued_count == 0)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock{main_thread_mutex};
+	if (main_thread_tasks.empty())
+	{
+		return false;
+	}
+
+	task = std::move(main_thread_tasks.front());
+	main_thread_tasks.pop_front();
+	main_thread_queued_count--;
+	return true;
+}
+
+void JobSystem::run_task(Task &task)
+{
+	try
+	{
+		task.job();
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock{task.counter->exception_mutex};
+		if (!task.counter->exception)
+		{
+			task.counter->exception = std::current_exception();
+		}
+	}
+
+	// The captures are released before the waiting thread can resume
+	task.job = nullptr;
+
+	if (--task.counter->pending == 0 && sleeping_count > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock{sleep_mutex};
+		}
+		sleep_condition.notify_all();
+	}
+}
+
+void JobSystem::wake_one()
+{
+	if (sleeping_count > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock{sleep_mutex};
+		}
+		sleep_condition.notify_one();
+	}
+}
+}        // namespace vkb
@@ -0,0 +1,187 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <core/util/error.hpp>
+
+VKBP_DISABLE_WARNINGS()
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+VKBP_ENABLE_WARNINGS()
+
+#include <core/util/concurrent_lookup_table.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace vkb;
+
+namespace
+{
+// About the number of pipelines and shader modules of a scene
+constexpr size_t resource_count = 512;
+
+constexpr size_t lookups_per_thread = 1 << 16;
+
+size_t get_key(size_t index)
+{
+	// Spread like the hashes of the resource cache
+	return index * 0xC6A4A7935BD1E995ull + 1;
+}
+
+uint32_t get_thread_count()
+{
+	return std::max(std::thread::hardware_concurrency(), 2u);
+}
+
+/**
+ * @brief Looks the resources up from every thread, like threads recording command buffers concurrently
+ */
+template <class Lookup>
+size_t run_lookups(uint32_t thread_count, Lookup &&lookup)
+{
+	std::vector<size_t>      found(thread_count, 0);
+	std::vector<std::thread> threads;
+	for (uint32_t thread_index = 0; thread_index < thread_count; thread_index++)
+	{
+		threads.emplace_back([&lookup, &found, thread_index]() {
+			size_t found_count = 0;
+			for (size_t i = 0; i < lookups_per_thread; i++)
+			{
+				if (lookup(get_key((i * 7 + thread_index) % resource_count)))
+				{
+					found_count++;
+				}
+			}
+			found[thread_index] = found_count;
+		});
+	}
+
+	for (auto &thread : threads)
+	{
+		thread.join();
+	}
+
+	size_t found_count = 0;
+	for (auto count : found)
+	{
+		found_count += count;
+	}
+	return found_count;
+}
+}        // namespace
+
+TEST_CASE("vkb::ConcurrentLookupTable finds the inserted objects", "[concurrent_lookup_table]")
+{
+	std::vector<int>           values(resource_count);
+	ConcurrentLookupTable<int> table;
+
+	REQUIRE(table.find(get_key(0)) == nullptr);
+
+	for (size_t i = 0; i < resource_count; i++)
+	{
+		table.insert(get_key(i), &values[i]);
+	}
+	REQUIRE(table.size() == resource_count);
+
+	for (size_t i = 0; i < resource_count; i++)
+	{
+		REQUIRE(table.find(get_key(i)) == &values[i]);
+	}
+	REQUIRE(table.find(get_key(resource_count)) == nullptr);
+
+	// Replacing keeps a single entry
+	table.insert(get_key(0), &values[1]);
+	REQUIRE(table.size() == resource_count);
+	REQUIRE(table.find(get_key(0)) == &values[1]);
+
+	table.clear();
+	REQUIRE(table.size() == 0);
+	REQUIRE(table.find(get_key(1)) == nullptr);
+}
+
+TEST_CASE("vkb::ConcurrentLookupTable finds objects while growing", "[concurrent_lookup_table]")
+{
+	std::vector<int>           values(resource_count);
+	ConcurrentLookupTable<int> table;
+
+	// Every object is found once inserted, or missed, never mistaken for another
+	std::atomic<bool> mismatch{false};
+	std::atomic<bool> done{false};
+	std::thread       reader([&]() {
+		while (!done)
+		{
+			for (size_t i = 0; i < resource_count; i++)
+			{
+				int *value = table.find(get_key(i));
+				if (value && value != &values[i])
+				{
+					mismatch = true;
+				}
+			}
+		}
+	});
+
+	for (size_t i = 0; i < resource_count; i++)
+	{
+		table.insert(get_key(i), &values[i]);
+		REQUIRE(table.find(get_key(i)) == &values[i]);
+	}
+
+	done = true;
+	reader.join();
+	REQUIRE(!mismatch);
+}
+
+TEST_CASE("vkb::ConcurrentLookupTable compared to a locked map", "[concurrent_lookup_table][!benchmark]")
+{
+	std::vector<int> values(resource_count);
+
+	// What the resource cache did before, a lookup under the mutex of the type of resource
+	std::mutex                        mutex;
+	std::unordered_map<size_t, int *> map;
+
+	ConcurrentLookupTable<int> table;
+
+	for (size_t i = 0; i < resource_count; i++)
+	{
+		map.emplace(get_key(i), &values[i]);
+		table.insert(get_key(i), &values[i]);
+	}
+
+	for (uint32_t thread_count : {1u, get_thread_count()})
+	{
+		BENCHMARK("Locked map, " + std::to_string(thread_count) + " threads")
+		{
+			return run_lookups(thread_count, [&mutex, &map](size_t key) {
+				std::lock_guard<std::mutex> lock{mutex};
+
+				auto it = map.find(key);
+				return it != map.end() ? it->second : nullptr;
+			});
+		};
+
+		BENCHMARK("ConcurrentLookupTable, " + std::to_string(thread_count) + " threads")
+		{
+			return run_lookups(thread_count, [&table](size_t key) { return table.find(key); });
+		};
+	}
+}
@@ -0,0 +1,194 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <core/util/error.hpp>
+
+VKBP_DISABLE_WARNINGS()
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <ctpl_stl.h>
+VKBP_ENABLE_WARNINGS()
+
+#include <core/util/job_system.hpp>
+
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <vector>
+
+using namespace vkb;
+
+namespace
+{
+constexpr uint32_t small_job_count = 4096;
+
+constexpr uint32_t element_count = 1 << 20;
+
+uint64_t sum_range(uint32_t begin, uint32_t end)
+{
+	uint64_t sum = 0;
+	for (uint32_t i = begin; i < end; i++)
+	{
+		sum += static_cast<uint64_t>(i) * i % 7;
+	}
+	return sum;
+}
+
+uint64_t expected_sum()
+{
+	static const uint64_t sum = sum_range(0, element_count);
+	return sum;
+}
+}        // namespace
+
+TEST_CASE("vkb::JobSystem::parallel_for covers every element once", "[job_system]")
+{
+	JobSystem job_system{3};
+
+	for (uint32_t grain_size : {0u, 1u, 1000u, element_count})
+	{
+		std::atomic<uint64_t> sum{0};
+		job_system.parallel_for(element_count, grain_size, [&sum](uint32_t begin, uint32_t end) { sum += sum_range(begin, end); });
+		REQUIRE(sum == expected_sum());
+	}
+}
+
+TEST_CASE("vkb::JobSystem runs nested and main thread jobs", "[job_system]")
+{
+	JobSystem job_system{3};
+
+	// Jobs waiting on the jobs they schedule run them instead of blocking their worker
+	std::atomic<uint32_t> nested_count{0};
+	JobCounter            counter;
+	for (uint32_t i = 0; i < 64; i++)
+	{
+		job_system.schedule(counter, [&job_system, &nested_count]() {
+			JobCounter nested_counter;
+			for (uint32_t j = 0; j < 16; j++)
+			{
+				job_system.schedule(nested_counter, [&nested_count]() { nested_count++; });
+			}
+			job_system.wait(nested_counter);
+		});
+	}
+	job_system.wait(counter);
+	REQUIRE(nested_count == 64 * 16);
+
+	// A job scheduled on the main thread by a worker runs while the main thread waits
+	bool       ran_on_main_thread = false;
+	JobCounter worker_counter;
+	job_system.schedule(worker_counter, [&job_system, &ran_on_main_thread]() {
+		JobCounter main_thread_counter;
+		job_system.schedule_on_main_thread(main_thread_counter, [&job_system, &ran_on_main_thread]() { ran_on_main_thread = job_system.is_main_thread(); });
+		job_system.wait(main_thread_counter);
+	});
+	job_system.wait(worker_counter);
+	REQUIRE(ran_on_main_thread);
+}
+
+TEST_CASE("vkb::JobSystem::wait rethrows the exceptions of the jobs", "[job_system]")
+{
+	JobSystem job_system{3};
+
+	JobCounter counter;
+	job_system.schedule(counter, []() { throw std::runtime_error("job failed"); });
+	job_system.schedule(counter, []() {});
+	REQUIRE_THROWS_AS(job_system.wait(counter), std::runtime_error);
+	REQUIRE(counter.is_done());
+}
+
+TEST_CASE("vkb::JobSystem compared to ctpl::thread_pool", "[job_system][!benchmark]")
+{
+	auto &job_system = JobSystem::get();
+
+	// Same number of threads running jobs, the thread waiting on the job system runs jobs too
+	ctpl::thread_pool thread_pool{static_cast<int>(job_system.get_worker_count() + 1)};
+
+	BENCHMARK("ctpl small jobs")
+	{
+		std::atomic<uint32_t>          count{0};
+		std::vector<std::future<void>> futures;
+		futures.reserve(small_job_count);
+		for (uint32_t i = 0; i < small_job_count; i++)
+		{
+			futures.push_back(thread_pool.push([&count](int) { count++; }));
+		}
+		for (auto &future : futures)
+		{
+			future.get();
+		}
+		return count.load();
+	};
+
+	BENCHMARK("JobSystem small jobs")
+	{
+		std::atomic<uint32_t> count{0};
+		JobCounter            counter;
+		for (uint32_t i = 0; i < small_job_count; i++)
+		{
+			job_system.schedule(counter, [&count]() { count++; });
+		}
+		job_system.wait(counter);
+		return count.load();
+	};
+
+	BENCHMARK("ctpl parallel sum")
+	{
+		uint32_t                           range_count = static_cast<uint32_t>(thread_pool.size()) * 4;
+		std::vector<std::future<uint64_t>> futures;
+		for (uint32_t i = 0; i < range_count; i++)
+		{
+			uint32_t begin = static_cast<uint32_t>(static_cast<uint64_t>(element_count) * i / range_count);
+			uint32_t end   = static_cast<uint32_t>(static_cast<uint64_t>(element_count) * (i + 1) / range_count);
+			futures.push_back(thread_pool.push([begin, end](int) { return sum_range(begin, end); }));
+		}
+		uint64_t sum = 0;
+		for (auto &future : futures)
+		{
+			sum += future.get();
+		}
+		return sum;
+	};
+
+	BENCHMARK("JobSystem parallel sum")
+	{
+		uint32_t              grain_size = element_count / ((job_system.get_worker_count() + 1) * 4);
+		std::atomic<uint64_t> sum{0};
+		job_system.parallel_for(element_count, grain_size, [&sum](uint32_t begin, uint32_t end) { sum += sum_range(begin, end); });
+		return sum.load();
+	};
+
+	// Jobs scheduling jobs, which the pool cannot wait on from its threads without risking a deadlock
+	BENCHMARK("JobSystem nested jobs")
+	{
+		std::atomic<uint32_t> count{0};
+		JobCounter            counter;
+		for (uint32_t i = 0; i < 64; i++)
+		{
+			job_system.schedule(counter, [&job_system, &count]() {
+				JobCounter nested_counter;
+				for (uint32_t j = 0; j < 64; j++)
+				{
+					job_system.schedule(nested_counter, [&count]() { count++; });
+				}
+				job_system.wait(nested_counter);
+			});
+		}
+		job_system.wait(counter);
+		return count.load();
+	};
+}
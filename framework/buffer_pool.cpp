@@ -17,6 +17,7 @@
 
 #include "buffer_pool.h"
 
+#include <algorithm>
 #include <cstddef>
 
 #include "common/logging.h"
@@ -24,25 +25,26 @@
 
 namespace vkb
 {
-BufferBlock::BufferBlock(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) :
-    buffer{device, size, usage, memory_usage}
+VkDeviceSize get_buffer_allocation_alignment(Device &device, VkBufferUsageFlags usage)
 {
+	const auto &limits = device.get_gpu().get_properties().limits;
+
 	if (usage == VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
 	{
-		alignment = device.get_gpu().get_properties().limits.minUniformBufferOffsetAlignment;
+		return limits.minUniformBufferOffsetAlignment;
 	}
 	else if (usage == VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
 	{
-		alignment = device.get_gpu().get_properties().limits.minStorageBufferOffsetAlignment;
+		return limits.minStorageBufferOffsetAlignment;
 	}
 	else if (usage == VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT)
 	{
-		alignment = device.get_gpu().get_properties().limits.minTexelBufferOffsetAlignment;
+		return limits.minTexelBufferOffsetAlignment;
 	}
 	else if (usage == VK_BUFFER_USAGE_INDEX_BUFFER_BIT || usage == VK_BUFFER_USAGE_VERTEX_BUFFER_BIT || usage == VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
 	{
 		// Used to calculate the offset, required when allocating memory (its value should be power of 2)
-		alignment = 16;
+		return 16;
 	}
 	else
 	{
@@ -50,6 +52,12 @@ BufferBlock::BufferBlock(Device &device, VkDeviceSize size, VkBufferUsageFlags u
 	}
 }
 
+BufferBlock::BufferBlock(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) :
+    buffer{device, size, usage, memory_usage},
+    alignment{get_buffer_allocation_alignment(device, usage)}
+{
+}
+
 VkDeviceSize BufferBlock::aligned_offset() const
 {
 	return (offset + alignment - 1) & ~(alignment - 1);
@@ -131,13 +139,13 @@ BufferAllocation::BufferAllocation(core::Buffer &buffer, VkDeviceSize size, VkDe
 {
 }
 
-void BufferAllocation::update(const std::vector<uint8_t> &data, uint32_t offset)
+void BufferAllocation::update(const uint8_t *data, size_t data_size, uint32_t offset)
 {
 	assert(buffer && "Invalid buffer pointer");
 
-	if (offset + data.size() <= size)
+	if (offset + data_size <= size)
 	{
-		buffer->update(data, to_u32(base_offset) + offset);
+		buffer->update(data, data_size, to_u32(base_offset) + offset);
 	}
 	else
 	{
@@ -145,6 +153,11 @@ void BufferAllocation::update(const std::vector<uint8_t> &data, uint32_t offset)
 	}
 }
 
+void BufferAllocation::update(const std::vector<uint8_t> &data, uint32_t offset)
+{
+	update(data.data(), data.size(), offset);
+}
+
 bool BufferAllocation::empty() const
 {
 	return size == 0 || buffer == nullptr;
@@ -166,4 +179,102 @@ core::Buffer &BufferAllocation::get_buffer()
 	return *buffer;
 }
 
+BufferRing::Block::Block(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) :
+    buffer{device, size, usage, memory_usage, VMA_ALLOCATION_CREATE_MAPPED_BIT}
+{
+}
+
+BufferRing::BufferRing(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) :
+    device{device},
+    usage{usage},
+    memory_usage{memory_usage},
+    alignment{get_buffer_allocation_alignment(device, usage)}
+{
+	blocks.push_back(std::make_unique<Block>(device, size, usage, memory_usage));
+	current_block.store(blocks.back().get(), std::memory_order_relaxed);
+}
+
+BufferAllocation BufferRing::allocate(VkDeviceSize size)
+{
+	assert(size > 0 && "Allocation size must be greater than zero");
+
+	// Sizes are rounded up so that every offset handed out stays aligned
+	VkDeviceSize aligned_size = (size + alignment - 1) & ~(alignment - 1);
+
+	while (true)
+	{
+		Block       *block  = current_block.load(std::memory_order_acquire);
+		VkDeviceSize offset = block->offset.fetch_add(aligned_size, std::memory_order_relaxed);
+
+		if (offset + size <= block->buffer.get_size())
+		{
+			return BufferAllocation{block->buffer, size, offset};
+		}
+
+		grow(block, aligned_size);
+	}
+}
+
+void BufferRing::grow(Block *full_block, VkDeviceSize minimum_size)
+{
+	std::lock_guard<std::mutex> lock{grow_mutex};
+
+	if (current_block.load(std::memory_order_relaxed) != full_block)
+	{
+		return;
+	}
+
+	VkDeviceSize new_size = std::max(full_block->buffer.get_size() * 2, minimum_size);
+
+	LOGD("Growing buffer ring ({}) to {} bytes", usage, new_size);
+
+	blocks.push_back(std::make_unique<Block>(device, new_size, usage, memory_usage));
+	current_block.store(blocks.back().get(), std::memory_order_release);
+}
+
+VkDeviceSize BufferRing::get_used_size() const
+{
+	VkDeviceSize used_size = 0;
+	for (auto &block : blocks)
+	{
+		used_size += std::min(block->offset.load(std::memory_order_relaxed), block->buffer.get_size());
+	}
+	return used_size;
+}
+
+bool BufferRing::reset()
+{
+	high_watermark = std::max(high_watermark, get_used_size());
+
+	if (blocks.size() > 1)
+	{
+		// The frame fence was waited for, the chain can be released and replaced by a buffer fitting the whole frame
+		VkDeviceSize new_size = blocks.back()->buffer.get_size();
+		while (new_size < high_watermark)
+		{
+			new_size *= 2;
+		}
+
+		blocks.clear();
+		blocks.push_back(std::make_unique<Block>(device, new_size, usage, memory_usage));
+		current_block.store(blocks.back().get(), std::memory_order_relaxed);
+
+		return true;
+	}
+
+	blocks.back()->offset.store(0, std::memory_order_relaxed);
+
+	return false;
+}
+
+VkDeviceSize BufferRing::get_size() const
+{
+	return current_block.load(std::memory_order_relaxed)->buffer.get_size();
+}
+
+VkDeviceSize BufferRing::get_high_watermark() const
+{
+	return high_watermark;
+}
+
 }        // namespace vkb
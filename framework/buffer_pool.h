@@ -17,6 +17,12 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
 #include "common/helpers.h"
 #include "core/buffer.h"
 
@@ -24,6 +30,11 @@ namespace vkb
 {
 class Device;
 
+/**
+ * @return Alignment of the offsets of the allocations of a buffer usage, a power of two
+ */
+VkDeviceSize get_buffer_allocation_alignment(Device &device, VkBufferUsageFlags usage);
+
 /**
  * @brief An allocation of vulkan memory; different buffer allocations,
  *        with different offset and size, may come from the same Vulkan buffer
@@ -43,12 +54,21 @@ class BufferAllocation
 
 	BufferAllocation &operator=(BufferAllocation &&) = default;
 
+	/**
+	 * @brief Copies data into the mapped memory of the allocation, without any intermediate copy
+	 * @param data Bytes to copy
+	 * @param size Number of bytes
+	 * @param offset Offset of the bytes from the start of the allocation
+	 */
+	void update(const uint8_t *data, size_t size, uint32_t offset = 0);
+
 	void update(const std::vector<uint8_t> &data, uint32_t offset = 0);
 
 	template <class T>
 	void update(const T &value, uint32_t offset = 0)
 	{
-		update(to_bytes(value), offset);
+		static_assert(std::is_trivially_copyable<T>::value, "Buffer allocations are updated with the bytes of the value");
+		update(reinterpret_cast<const uint8_t *>(&value), sizeof(T), offset);
 	}
 
 	bool empty() const;
@@ -146,4 +166,93 @@ class BufferPool
 
 	VmaMemoryUsage memory_usage{};
 };
+
+/**
+ * @brief Linear allocator of a frame for a specific usage, over a single persistently mapped buffer.
+ *
+ * Frames are reused in turn once their fence is signaled, so the buffers of the frames form a ring
+ * over the frames in flight: the frame reset rewinds the allocator, and the GPU is done with the
+ * previous contents by then.
+ *
+ * The threads recording the frame allocate concurrently without locking, by bumping a shared offset.
+ * When the buffer is full, a larger one is chained without waiting for the GPU, and the next reset
+ * replaces the chain with a single buffer fitting the high watermark, so that a steady workload
+ * ends up allocating from one buffer.
+ */
+class BufferRing
+{
+  public:
+	BufferRing(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage = VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+	BufferRing(const BufferRing &) = delete;
+
+	BufferRing(BufferRing &&) = delete;
+
+	BufferRing &operator=(const BufferRing &) = delete;
+
+	BufferRing &operator=(BufferRing &&) = delete;
+
+	/**
+	 * @brief Allocates from the current buffer, safe to call concurrently with itself
+	 * @return A view on a portion of the current buffer, aligned for the usage
+	 */
+	BufferAllocation allocate(VkDeviceSize size);
+
+	/**
+	 * @brief Rewinds the allocator, the GPU must be done with the allocations
+	 *        Must not run concurrently with allocate
+	 * @return Whether the buffers were replaced, descriptor sets referring to them must then be released
+	 */
+	bool reset();
+
+	/**
+	 * @return Size of the current buffer
+	 */
+	VkDeviceSize get_size() const;
+
+	/**
+	 * @return Largest number of bytes allocated between two resets
+	 */
+	VkDeviceSize get_high_watermark() const;
+
+  private:
+	struct Block
+	{
+		Block(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage);
+
+		core::Buffer buffer;
+
+		/// Offset of the next allocation, it may run past the end of the buffer once it is full
+		std::atomic<VkDeviceSize> offset{0};
+	};
+
+	/**
+	 * @brief Chains a buffer after the full one, unless another thread already did
+	 */
+	void grow(Block *full_block, VkDeviceSize minimum_size);
+
+	/**
+	 * @return Number of bytes allocated from the blocks since the last reset
+	 */
+	VkDeviceSize get_used_size() const;
+
+	Device &device;
+
+	VkBufferUsageFlags usage{};
+
+	VmaMemoryUsage memory_usage{};
+
+	VkDeviceSize alignment{0};
+
+	/// Block allocations are made from, the last of blocks
+	std::atomic<Block *> current_block{nullptr};
+
+	/// Blocks chained since the last reset, they stay alive as the frame may use them
+	std::vector<std::unique_ptr<Block>> blocks;
+
+	/// Serializes the threads growing the chain
+	std::mutex grow_mutex;
+
+	VkDeviceSize high_watermark{0};
+};
 }        // namespace vkb
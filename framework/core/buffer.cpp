@@ -137,6 +137,11 @@ void Buffer::flush() const
 	vmaFlushAllocation(device->get_memory_allocator(), allocation, 0, size);
 }
 
+void Buffer::flush(VkDeviceSize offset, VkDeviceSize range_size) const
+{
+	vmaFlushAllocation(device->get_memory_allocator(), allocation, offset, range_size);
+}
+
 void Buffer::update(const std::vector<uint8_t> &data, size_t offset)
 {
 	update(data.data(), data.size(), offset);
@@ -160,13 +165,13 @@ void Buffer::update(const uint8_t *data, const size_t size, const size_t offset)
 	if (persistent)
 	{
 		std::copy(data, data + size, mapped_data + offset);
-		flush();
+		flush(offset, size);
 	}
 	else
 	{
 		map();
 		std::copy(data, data + size, mapped_data + offset);
-		flush();
+		flush(offset, size);
 		unmap();
 	}
 }
@@ -93,6 +93,11 @@ class Buffer : public VulkanResource<VkBuffer, VK_OBJECT_TYPE_BUFFER, const Devi
 	 */
 	void flush() const;
 
+	/**
+	 * @brief Flushes a range of the memory if it is HOST_VISIBLE and not HOST_COHERENT
+	 */
+	void flush(VkDeviceSize offset, VkDeviceSize size) const;
+
 	/**
 	 * @brief Maps vulkan memory if it isn't already mapped to an host visible address
 	 * @return Pointer to host visible memory
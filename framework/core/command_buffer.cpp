@@ -29,10 +29,35 @@ VKBP_ENABLE_WARNINGS()
 
 namespace vkb
 {
+namespace
+{
+/**
+ * @return Layout of an image read through a descriptor, undefined if the descriptor cannot hold an image
+ */
+VkImageLayout get_descriptor_image_layout(VkDescriptorType descriptor_type, const core::ImageView &image_view)
+{
+	switch (descriptor_type)
+	{
+		case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+			return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+			if (is_depth_format(image_view.get_format()))
+			{
+				return VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+			}
+			return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+			return VK_IMAGE_LAYOUT_GENERAL;
+		default:
+			return VK_IMAGE_LAYOUT_UNDEFINED;
+	}
+}
+}        // namespace
+
 CommandBuffer::CommandBuffer(CommandPool &command_pool, VkCommandBufferLevel level) :
     VulkanResource{VK_NULL_HANDLE, &command_pool.get_device()},
     command_pool{command_pool},
-    max_push_constants_size{device->get_gpu().get_properties().limits.maxPushConstantsSize},
+    max_push_constants_size{std::min(device->get_gpu().get_properties().limits.maxPushConstantsSize, uint32_t{push_constant_capacity})},
     level{level}
 {
 	VkCommandBufferAllocateInfo allocate_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
@@ -65,12 +90,17 @@ CommandBuffer::CommandBuffer(CommandBuffer &&other) :
     current_render_pass(std::exchange(other.current_render_pass, {})),
     pipeline_state(std::exchange(other.pipeline_state, {})),
     resource_binding_state(std::exchange(other.resource_binding_state, {})),
-    stored_push_constants(std::exchange(other.stored_push_constants, {})),
+    stored_push_constants(other.stored_push_constants),
+    stored_push_constant_size(std::exchange(other.stored_push_constant_size, {})),
     max_push_constants_size(std::exchange(other.max_push_constants_size, {})),
     last_framebuffer_extent(std::exchange(other.last_framebuffer_extent, {})),
     last_render_area_extent(std::exchange(other.last_render_area_extent, {})),
     update_after_bind(std::exchange(other.update_after_bind, {})),
-    descriptor_set_layout_binding_state(std::exchange(other.descriptor_set_layout_binding_state, {}))
+    descriptor_set_layout_binding_state(std::exchange(other.descriptor_set_layout_binding_state, {})),
+    dynamic_offsets(std::exchange(other.dynamic_offsets, {})),
+    push_descriptor_writes(std::exchange(other.push_descriptor_writes, {})),
+    push_buffer_infos(std::exchange(other.push_buffer_infos, {})),
+    push_image_infos(std::exchange(other.push_image_infos, {}))
 {}
 
 void CommandBuffer::clear(VkClearAttachment attachment, VkClearRect rect)
@@ -96,8 +126,9 @@ VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, const RenderPass
 	// Reset state
 	pipeline_state.reset();
 	resource_binding_state.reset();
-	descriptor_set_layout_binding_state.clear();
-	stored_push_constants.clear();
+	descriptor_set_layout_binding_state.fill(nullptr);
+	stored_push_constant_size = 0;
+	bound_index_buffer        = VK_NULL_HANDLE;
 
 	VkCommandBufferBeginInfo       begin_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
 	VkCommandBufferInheritanceInfo inheritance = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
@@ -115,6 +146,13 @@ VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, const RenderPass
 		inheritance.subpass     = subpass_index;
 
 		begin_info.pInheritanceInfo = &inheritance;
+
+		// Pipelines are created for the inherited subpass, with a blend state for each of its color outputs
+		pipeline_state.set_subpass_index(subpass_index);
+
+		auto blend_state = pipeline_state.get_color_blend_state();
+		blend_state.attachments.resize(current_render_pass.render_pass->get_color_output_count(subpass_index));
+		pipeline_state.set_color_blend_state(blend_state);
 	}
 
 	return vkBeginCommandBuffer(get_handle(), &begin_info);
@@ -141,7 +179,7 @@ void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const s
 	// Reset state
 	pipeline_state.reset();
 	resource_binding_state.reset();
-	descriptor_set_layout_binding_state.clear();
+	descriptor_set_layout_binding_state.fill(nullptr);
 
 	auto &render_pass = get_render_pass(render_target, load_store_infos, subpasses);
 	auto &framebuffer = get_device().get_resource_cache().request_framebuffer(render_target, render_pass);
@@ -198,10 +236,10 @@ void CommandBuffer::next_subpass()
 
 	// Reset descriptor sets
 	resource_binding_state.reset();
-	descriptor_set_layout_binding_state.clear();
+	descriptor_set_layout_binding_state.fill(nullptr);
 
 	// Clear stored push constants
-	stored_push_constants.clear();
+	stored_push_constant_size = 0;
 
 	vkCmdNextSubpass(get_handle(), VK_SUBPASS_CONTENTS_INLINE);
 }
@@ -209,6 +247,9 @@ void CommandBuffer::next_subpass()
 void CommandBuffer::execute_commands(CommandBuffer &secondary_command_buffer)
 {
 	vkCmdExecuteCommands(get_handle(), 1, &secondary_command_buffer.get_handle());
+
+	// The bindings of the primary command buffer are undefined after executing secondary ones
+	bound_index_buffer = VK_NULL_HANDLE;
 }
 
 void CommandBuffer::execute_commands(std::vector<CommandBuffer *> &secondary_command_buffers)
@@ -217,6 +258,8 @@ void CommandBuffer::execute_commands(std::vector<CommandBuffer *> &secondary_com
 	std::transform(secondary_command_buffers.begin(), secondary_command_buffers.end(), sec_cmd_buf_handles.begin(),
 	               [](const vkb::CommandBuffer *sec_cmd_buf) { return sec_cmd_buf->get_handle(); });
 	vkCmdExecuteCommands(get_handle(), to_u32(sec_cmd_buf_handles.size()), sec_cmd_buf_handles.data());
+
+	bound_index_buffer = VK_NULL_HANDLE;
 }
 
 void CommandBuffer::end_render_pass()
@@ -229,26 +272,37 @@ void CommandBuffer::bind_pipeline_layout(PipelineLayout &pipeline_layout)
 	pipeline_state.set_pipeline_layout(pipeline_layout);
 }
 
+void CommandBuffer::set_specialization_constant(uint32_t constant_id, const uint8_t *data, size_t size)
+{
+	pipeline_state.set_specialization_constant(constant_id, data, size);
+}
+
 void CommandBuffer::set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data)
 {
-	pipeline_state.set_specialization_constant(constant_id, data);
+	set_specialization_constant(constant_id, data.data(), data.size());
 }
 
-void CommandBuffer::push_constants(const std::vector<uint8_t> &values)
+void CommandBuffer::push_constants(const uint8_t *data, uint32_t size)
 {
-	uint32_t push_constant_size = to_u32(stored_push_constants.size() + values.size());
+	uint32_t push_constant_size = stored_push_constant_size + size;
 
 	if (push_constant_size > max_push_constants_size)
 	{
-		LOGE("Push constant limit of {} exceeded (pushing {} bytes for a total of {} bytes)", max_push_constants_size, values.size(), push_constant_size);
+		LOGE("Push constant limit of {} exceeded (pushing {} bytes for a total of {} bytes)", max_push_constants_size, size, push_constant_size);
 		throw std::runtime_error("Push constant limit exceeded.");
 	}
 	else
 	{
-		stored_push_constants.insert(stored_push_constants.end(), values.begin(), values.end());
+		std::copy(data, data + size, stored_push_constants.begin() + stored_push_constant_size);
+		stored_push_constant_size = push_constant_size;
 	}
 }
 
+void CommandBuffer::push_constants(const std::vector<uint8_t> &values)
+{
+	push_constants(values.data(), to_u32(values.size()));
+}
+
 void CommandBuffer::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element)
 {
 	resource_binding_state.bind_buffer(buffer, offset, range, set, binding, array_element);
@@ -271,15 +325,32 @@ void CommandBuffer::bind_input(const core::ImageView &image_view, uint32_t set,
 
 void CommandBuffer::bind_vertex_buffers(uint32_t first_binding, const std::vector<std::reference_wrapper<const vkb::core::Buffer>> &buffers, const std::vector<VkDeviceSize> &offsets)
 {
-	std::vector<VkBuffer> buffer_handles(buffers.size(), VK_NULL_HANDLE);
-	std::transform(buffers.begin(), buffers.end(), buffer_handles.begin(),
-	               [](const core::Buffer &buffer) { return buffer.get_handle(); });
-	vkCmdBindVertexBuffers(get_handle(), first_binding, to_u32(buffer_handles.size()), buffer_handles.data(), offsets.data());
+	// Bound in chunks converted on the stack, so that binding the streams of a draw does not allocate
+	constexpr size_t chunk_size = 16;
+
+	std::array<VkBuffer, chunk_size> buffer_handles;
+
+	for (size_t first = 0; first < buffers.size(); first += chunk_size)
+	{
+		size_t count = std::min(chunk_size, buffers.size() - first);
+		std::transform(buffers.begin() + first, buffers.begin() + first + count, buffer_handles.begin(),
+		               [](const core::Buffer &buffer) { return buffer.get_handle(); });
+		vkCmdBindVertexBuffers(get_handle(), first_binding + to_u32(first), to_u32(count), buffer_handles.data(), offsets.data() + first);
+	}
 }
 
 void CommandBuffer::bind_index_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkIndexType index_type)
 {
+	if (buffer.get_handle() == bound_index_buffer && offset == bound_index_offset && index_type == bound_index_type)
+	{
+		return;
+	}
+
 	vkCmdBindIndexBuffer(get_handle(), buffer.get_handle(), offset, index_type);
+
+	bound_index_buffer = buffer.get_handle();
+	bound_index_offset = offset;
+	bound_index_type   = index_type;
 }
 
 void CommandBuffer::bind_lighting(LightingState &lighting_state, uint32_t set, uint32_t binding)
@@ -524,198 +595,274 @@ void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_poi
 
 	const auto &pipeline_layout = pipeline_state.get_pipeline_layout();
 
-	std::unordered_set<uint32_t> update_descriptor_sets;
+	// Sets whose bound descriptor set layout differs from the one of the pipeline layout
+	uint32_t update_descriptor_sets = 0;
 
-	// Iterate over the shader sets to check if they have already been bound
-	// If they have, add the set so that the command buffer later updates it
-	for (auto &set_it : pipeline_layout.get_shader_sets())
+	for (uint32_t descriptor_set_id = 0; descriptor_set_id < max_bound_descriptor_sets; descriptor_set_id++)
 	{
-		uint32_t descriptor_set_id = set_it.first;
-
-		auto descriptor_set_layout_it = descriptor_set_layout_binding_state.find(descriptor_set_id);
-
-		if (descriptor_set_layout_it != descriptor_set_layout_binding_state.end())
+		auto &bound_layout = descriptor_set_layout_binding_state[descriptor_set_id];
+		if (!bound_layout)
 		{
-			if (descriptor_set_layout_it->second->get_handle() != pipeline_layout.get_descriptor_set_layout(descriptor_set_id).get_handle())
-			{
-				update_descriptor_sets.emplace(descriptor_set_id);
-			}
+			continue;
 		}
-	}
 
-	// Validate that the bound descriptor set layouts exist in the pipeline layout
-	for (auto set_it = descriptor_set_layout_binding_state.begin(); set_it != descriptor_set_layout_binding_state.end();)
-	{
-		if (!pipeline_layout.has_descriptor_set_layout(set_it->first))
+		// Validate that the bound descriptor set layouts exist in the pipeline layout
+		if (!pipeline_layout.has_descriptor_set_layout(descriptor_set_id))
 		{
-			set_it = descriptor_set_layout_binding_state.erase(set_it);
+			bound_layout = nullptr;
 		}
-		else
+		else if (bound_layout->get_handle() != pipeline_layout.get_descriptor_set_layout(descriptor_set_id).get_handle())
 		{
-			++set_it;
+			update_descriptor_sets |= 1u << descriptor_set_id;
 		}
 	}
 
 	// Check if a descriptor set needs to be created
-	if (resource_binding_state.is_dirty() || !update_descriptor_sets.empty())
+	if (!resource_binding_state.is_dirty() && update_descriptor_sets == 0)
 	{
-		resource_binding_state.clear_dirty();
+		return;
+	}
 
-		// Iterate over all of the resource sets bound by the command buffer
-		for (auto &resource_set_it : resource_binding_state.get_resource_sets())
+	resource_binding_state.clear_dirty();
+
+	auto &render_frame = *command_pool.get_render_frame();
+
+	// Iterate over all of the resource sets bound by the command buffer
+	const auto &resource_sets = resource_binding_state.get_resource_sets();
+	for (uint32_t descriptor_set_id = 0; descriptor_set_id < max_bound_descriptor_sets; descriptor_set_id++)
+	{
+		auto &resource_set = resource_sets[descriptor_set_id];
+
+		// Don't update resource set if it's not in the update list OR its state hasn't changed
+		if (resource_set.empty() || (!resource_set.is_dirty() && (update_descriptor_sets & (1u << descriptor_set_id)) == 0))
 		{
-			uint32_t descriptor_set_id = resource_set_it.first;
-			auto    &resource_set      = resource_set_it.second;
+			continue;
+		}
 
-			// Don't update resource set if it's not in the update list OR its state hasn't changed
-			if (!resource_set.is_dirty() && (update_descriptor_sets.find(descriptor_set_id) == update_descriptor_sets.end()))
-			{
-				continue;
-			}
+		// Clear dirty flag for resource set
+		resource_binding_state.clear_dirty(descriptor_set_id);
 
-			// Clear dirty flag for resource set
-			resource_binding_state.clear_dirty(descriptor_set_id);
+		// Skip resource set if a descriptor set layout doesn't exist for it
+		if (!pipeline_layout.has_descriptor_set_layout(descriptor_set_id))
+		{
+			continue;
+		}
 
-			// Skip resource set if a descriptor set layout doesn't exist for it
-			if (!pipeline_layout.has_descriptor_set_layout(descriptor_set_id))
-			{
-				continue;
-			}
+		auto &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(descriptor_set_id);
+
+		// Make descriptor set layout bound for current set
+		descriptor_set_layout_binding_state[descriptor_set_id] = &descriptor_set_layout;
+
+		// Pushed resources are written into the command buffer, no descriptor set is hashed nor looked up
+		if (descriptor_set_layout.is_push_descriptor())
+		{
+			push_descriptor_set(pipeline_bind_point, pipeline_layout, descriptor_set_layout, resource_set);
+			continue;
+		}
+
+		// The hash of the bindings is maintained as they are bound, the infos are only built for new descriptor sets
+		size_t descriptor_set_hash = resource_set.get_hash();
 
-			auto &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(descriptor_set_id);
+		dynamic_offsets.clear();
 
-			// Make descriptor set layout bound for current set
-			descriptor_set_layout_binding_state[descriptor_set_id] = &descriptor_set_layout;
+		// Dynamic offsets are given when binding the descriptor set, they are removed from the hash
+		// so that a single descriptor set serves every offset of the per-draw uniforms
+		if (descriptor_set_layout.has_dynamic_bindings())
+		{
+			resource_set.for_each_binding([&](uint32_t binding_index, uint32_t array_element, const ResourceInfo &resource_info) {
+				if (resource_info.buffer != nullptr && descriptor_set_layout.is_dynamic_binding(binding_index))
+				{
+					dynamic_offsets.push_back(to_u32(resource_info.offset));
+
+					descriptor_set_hash ^= ResourceSet::hash_offset(binding_index, array_element, resource_info.offset);
+				}
+			});
+		}
+
+		hash_combine(descriptor_set_hash, descriptor_set_layout.get_handle());
+
+		VkDescriptorSet descriptor_set_handle = render_frame.find_descriptor_set(descriptor_set_hash, command_pool.get_thread_index());
 
+		if (descriptor_set_handle == VK_NULL_HANDLE)
+		{
 			BindingMap<VkDescriptorBufferInfo> buffer_infos;
 			BindingMap<VkDescriptorImageInfo>  image_infos;
 
-			std::vector<uint32_t> dynamic_offsets;
-
 			// Iterate over all resource bindings
-			for (auto &binding_it : resource_set.get_resource_bindings())
-			{
-				auto  binding_index     = binding_it.first;
-				auto &binding_resources = binding_it.second;
-
+			resource_set.for_each_binding([&](uint32_t binding_index, uint32_t array_element, const ResourceInfo &resource_info) {
 				// Check if binding exists in the pipeline layout
-				if (auto binding_info = descriptor_set_layout.get_layout_binding(binding_index))
+				auto binding_info = descriptor_set_layout.get_layout_binding(binding_index);
+				if (!binding_info)
 				{
-					// Iterate over all binding resources
-					for (auto &element_it : binding_resources)
-					{
-						auto  array_element = element_it.first;
-						auto &resource_info = element_it.second;
+					return;
+				}
 
-						// Pointer references
-						auto &buffer     = resource_info.buffer;
-						auto &sampler    = resource_info.sampler;
-						auto &image_view = resource_info.image_view;
+				// Pointer references
+				auto &buffer     = resource_info.buffer;
+				auto &sampler    = resource_info.sampler;
+				auto &image_view = resource_info.image_view;
 
-						// Get buffer info
-						if (buffer != nullptr && is_buffer_descriptor_type(binding_info->descriptorType))
-						{
-							VkDescriptorBufferInfo buffer_info{};
+				// Get buffer info
+				if (buffer != nullptr && is_buffer_descriptor_type(binding_info->descriptorType))
+				{
+					VkDescriptorBufferInfo buffer_info{};
 
-							buffer_info.buffer = resource_info.buffer->get_handle();
-							buffer_info.offset = resource_info.offset;
-							buffer_info.range  = resource_info.range;
+					buffer_info.buffer = resource_info.buffer->get_handle();
+					buffer_info.offset = resource_info.offset;
+					buffer_info.range  = resource_info.range;
 
-							if (is_dynamic_buffer_descriptor_type(binding_info->descriptorType))
-							{
-								dynamic_offsets.push_back(to_u32(buffer_info.offset));
+					// The offset is given when binding the descriptor set
+					if (is_dynamic_buffer_descriptor_type(binding_info->descriptorType))
+					{
+						buffer_info.offset = 0;
+					}
 
-								buffer_info.offset = 0;
-							}
+					buffer_infos[binding_index][array_element] = buffer_info;
+				}
 
-							buffer_infos[binding_index][array_element] = buffer_info;
-						}
+				// Get image info
+				else if (image_view != nullptr || sampler != nullptr)
+				{
+					// Can be null for input attachments
+					VkDescriptorImageInfo image_info{};
+					image_info.sampler   = sampler ? sampler->get_handle() : VK_NULL_HANDLE;
+					image_info.imageView = image_view->get_handle();
 
-						// Get image info
-						else if (image_view != nullptr || sampler != nullptr)
+					if (image_view != nullptr)
+					{
+						// Add image layout info based on descriptor type
+						image_info.imageLayout = get_descriptor_image_layout(binding_info->descriptorType, *image_view);
+						if (image_info.imageLayout == VK_IMAGE_LAYOUT_UNDEFINED)
 						{
-							// Can be null for input attachments
-							VkDescriptorImageInfo image_info{};
-							image_info.sampler   = sampler ? sampler->get_handle() : VK_NULL_HANDLE;
-							image_info.imageView = image_view->get_handle();
-
-							if (image_view != nullptr)
-							{
-								// Add image layout info based on descriptor type
-								switch (binding_info->descriptorType)
-								{
-									case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-										image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-										break;
-									case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-										if (is_depth_format(image_view->get_format()))
-										{
-											image_info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
-										}
-										else
-										{
-											image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-										}
-										break;
-									case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-										image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-										break;
-
-									default:
-										continue;
-								}
-							}
-
-							image_infos[binding_index][array_element] = image_info;
+							return;
 						}
 					}
 
-					assert((!update_after_bind ||
-					        (buffer_infos.count(binding_index) > 0 || (image_infos.count(binding_index) > 0))) &&
-					       "binding index with no buffer or image infos can't be checked for adding to bindings_to_update");
+					image_infos[binding_index][array_element] = image_info;
 				}
-			}
 
-			VkDescriptorSet descriptor_set_handle =
-			    command_pool.get_render_frame()->request_descriptor_set(descriptor_set_layout,
+				assert((!update_after_bind ||
+				        (buffer_infos.count(binding_index) > 0 || (image_infos.count(binding_index) > 0))) &&
+				       "binding index with no buffer or image infos can't be checked for adding to bindings_to_update");
+			});
+
+			descriptor_set_handle = render_frame.request_descriptor_set(descriptor_set_layout,
+			                                                            descriptor_set_hash,
 			                                                            buffer_infos,
 			                                                            image_infos,
 			                                                            update_after_bind,
 			                                                            command_pool.get_thread_index());
+		}
 
-			// Bind descriptor set
-			vkCmdBindDescriptorSets(get_handle(),
-			                        pipeline_bind_point,
-			                        pipeline_layout.get_handle(),
-			                        descriptor_set_id,
-			                        1, &descriptor_set_handle,
-			                        to_u32(dynamic_offsets.size()),
-			                        dynamic_offsets.data());
+		// Bind descriptor set
+		vkCmdBindDescriptorSets(get_handle(),
+		                        pipeline_bind_point,
+		                        pipeline_layout.get_handle(),
+		                        descriptor_set_id,
+		                        1, &descriptor_set_handle,
+		                        to_u32(dynamic_offsets.size()),
+		                        dynamic_offsets.data());
+	}
+}
+
+void CommandBuffer::push_descriptor_set(VkPipelineBindPoint pipeline_bind_point, const PipelineLayout &pipeline_layout, const DescriptorSetLayout &descriptor_set_layout, const ResourceSet &resource_set)
+{
+	push_descriptor_writes.clear();
+	push_buffer_infos.clear();
+	push_image_infos.clear();
+
+	resource_set.for_each_binding([&](uint32_t binding_index, uint32_t array_element, const ResourceInfo &resource_info) {
+		auto binding_info = descriptor_set_layout.find_layout_binding(binding_index);
+		if (!binding_info)
+		{
+			return;
+		}
+
+		if (resource_info.buffer != nullptr && is_buffer_descriptor_type(binding_info->descriptorType))
+		{
+			// Push descriptor sets have no dynamic buffers, the offset is written in the descriptor
+			VkDescriptorBufferInfo buffer_info{};
+			buffer_info.buffer = resource_info.buffer->get_handle();
+			buffer_info.offset = resource_info.offset;
+			buffer_info.range  = resource_info.range;
+
+			push_buffer_infos.push_back(buffer_info);
+		}
+		else if (resource_info.image_view != nullptr || resource_info.sampler != nullptr)
+		{
+			VkDescriptorImageInfo image_info{};
+			image_info.sampler = resource_info.sampler ? resource_info.sampler->get_handle() : VK_NULL_HANDLE;
+
+			if (resource_info.image_view != nullptr)
+			{
+				image_info.imageView   = resource_info.image_view->get_handle();
+				image_info.imageLayout = get_descriptor_image_layout(binding_info->descriptorType, *resource_info.image_view);
+				if (image_info.imageLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+				{
+					return;
+				}
+			}
+
+			push_image_infos.push_back(image_info);
+		}
+		else
+		{
+			return;
+		}
+
+		VkWriteDescriptorSet write{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+		write.dstBinding      = binding_index;
+		write.dstArrayElement = array_element;
+		write.descriptorCount = 1;
+		write.descriptorType  = binding_info->descriptorType;
+
+		push_descriptor_writes.push_back(write);
+	});
+
+	// The infos are pointed to once all gathered, as their storage may grow meanwhile
+	size_t buffer_index = 0;
+	size_t image_index  = 0;
+	for (auto &write : push_descriptor_writes)
+	{
+		if (is_buffer_descriptor_type(write.descriptorType))
+		{
+			write.pBufferInfo = &push_buffer_infos[buffer_index++];
+		}
+		else
+		{
+			write.pImageInfo = &push_image_infos[image_index++];
 		}
 	}
+
+	vkCmdPushDescriptorSetKHR(get_handle(),
+	                          pipeline_bind_point,
+	                          pipeline_layout.get_handle(),
+	                          descriptor_set_layout.get_index(),
+	                          to_u32(push_descriptor_writes.size()),
+	                          push_descriptor_writes.data());
 }
 
 void CommandBuffer::flush_push_constants()
 {
-	if (stored_push_constants.empty())
+	if (stored_push_constant_size == 0)
 	{
 		return;
 	}
 
 	const PipelineLayout &pipeline_layout = pipeline_state.get_pipeline_layout();
 
-	VkShaderStageFlags shader_stage = pipeline_layout.get_push_constant_range_stage(to_u32(stored_push_constants.size()));
+	VkShaderStageFlags shader_stage = pipeline_layout.get_push_constant_range_stage(stored_push_constant_size);
 
 	if (shader_stage)
 	{
-		vkCmdPushConstants(get_handle(), pipeline_layout.get_handle(), shader_stage, 0, to_u32(stored_push_constants.size()), stored_push_constants.data());
+		vkCmdPushConstants(get_handle(), pipeline_layout.get_handle(), shader_stage, 0, stored_push_constant_size, stored_push_constants.data());
 	}
 	else
 	{
-		LOGW("Push constant range [{}, {}] not found", 0, stored_push_constants.size());
+		LOGW("Push constant range [{}, {}] not found", 0, stored_push_constant_size);
 	}
 
-	stored_push_constants.clear();
+	stored_push_constant_size = 0;
 }
 
 void CommandBuffer::set_update_after_bind(bool update_after_bind_)
@@ -17,7 +17,9 @@
 
 #pragma once
 
+#include <array>
 #include <list>
+#include <type_traits>
 
 #include "common/helpers.h"
 #include "common/vk_common.h"
@@ -128,28 +130,25 @@ class CommandBuffer : public core::VulkanResource<VkCommandBuffer, VK_OBJECT_TYP
 	template <class T>
 	void set_specialization_constant(uint32_t constant_id, const T &data);
 
+	void set_specialization_constant(uint32_t constant_id, const uint8_t *data, size_t size);
+
 	void set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data);
 
 	/**
 	 * @brief Records byte data into the command buffer to be pushed as push constants to each draw call
-	 * @param values The byte data to store
+	 *        The bytes are appended to a fixed-capacity array, so that pushing does not allocate
+	 * @param data The byte data to store
+	 * @param size Number of bytes
 	 */
+	void push_constants(const uint8_t *data, uint32_t size);
+
 	void push_constants(const std::vector<uint8_t> &values);
 
 	template <typename T>
 	void push_constants(const T &value)
 	{
-		auto data = to_bytes(value);
-
-		uint32_t size = to_u32(stored_push_constants.size() + data.size());
-
-		if (size > max_push_constants_size)
-		{
-			LOGE("Push constant limit exceeded ({} / {} bytes)", size, max_push_constants_size);
-			throw std::runtime_error("Cannot overflow push constant limit");
-		}
-
-		stored_push_constants.insert(stored_push_constants.end(), data.begin(), data.end());
+		static_assert(std::is_trivially_copyable<T>::value, "Push constants are recorded with the bytes of the value");
+		push_constants(reinterpret_cast<const uint8_t *>(&value), to_u32(sizeof(T)));
 	}
 
 	void bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element);
@@ -162,6 +161,9 @@ class CommandBuffer : public core::VulkanResource<VkCommandBuffer, VK_OBJECT_TYP
 
 	void bind_vertex_buffers(uint32_t first_binding, const std::vector<std::reference_wrapper<const vkb::core::Buffer>> &buffers, const std::vector<VkDeviceSize> &offsets);
 
+	/**
+	 * @brief Binds an index buffer, unless the same range is already bound
+	 */
 	void bind_index_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkIndexType index_type);
 
 	void bind_lighting(LightingState &lighting_state, uint32_t set, uint32_t binding);
@@ -249,10 +251,22 @@ class CommandBuffer : public core::VulkanResource<VkCommandBuffer, VK_OBJECT_TYP
 
 	ResourceBindingState resource_binding_state;
 
-	std::vector<uint8_t> stored_push_constants;
+	/// Largest push constant range recorded, the limit of the device is clamped to it
+	static constexpr uint32_t push_constant_capacity = 256;
+
+	std::array<uint8_t, push_constant_capacity> stored_push_constants{};
+
+	uint32_t stored_push_constant_size{0};
 
 	uint32_t max_push_constants_size;
 
+	/// Index buffer bound last, so that the draws sharing it do not bind it again
+	VkBuffer bound_index_buffer{VK_NULL_HANDLE};
+
+	VkDeviceSize bound_index_offset{0};
+
+	VkIndexType bound_index_type{VK_INDEX_TYPE_UINT16};
+
 	VkExtent2D last_framebuffer_extent{};
 
 	VkExtent2D last_render_area_extent{};
@@ -261,7 +275,17 @@ class CommandBuffer : public core::VulkanResource<VkCommandBuffer, VK_OBJECT_TYP
 	// that contain update after bind, as they wont be implicitly updated
 	bool update_after_bind{false};
 
-	std::unordered_map<uint32_t, DescriptorSetLayout *> descriptor_set_layout_binding_state;
+	std::array<DescriptorSetLayout *, max_bound_descriptor_sets> descriptor_set_layout_binding_state{};
+
+	/// Dynamic offsets of the descriptor set being flushed, kept to reuse its storage
+	std::vector<uint32_t> dynamic_offsets;
+
+	/// Writes of the push descriptor set being flushed and their infos, kept to reuse their storage
+	std::vector<VkWriteDescriptorSet> push_descriptor_writes;
+
+	std::vector<VkDescriptorBufferInfo> push_buffer_infos;
+
+	std::vector<VkDescriptorImageInfo> push_image_infos;
 
 	const RenderPassBinding &get_current_render_pass() const;
 
@@ -282,6 +306,11 @@ class CommandBuffer : public core::VulkanResource<VkCommandBuffer, VK_OBJECT_TYP
 	 */
 	void flush_descriptor_state(VkPipelineBindPoint pipeline_bind_point);
 
+	/**
+	 * @brief Writes the resources of a set into the command buffer, for a push descriptor set layout
+	 */
+	void push_descriptor_set(VkPipelineBindPoint pipeline_bind_point, const PipelineLayout &pipeline_layout, const DescriptorSetLayout &descriptor_set_layout, const ResourceSet &resource_set);
+
 	/**
 	 * @brief Flush the push constant state
 	 */
@@ -291,12 +320,14 @@ class CommandBuffer : public core::VulkanResource<VkCommandBuffer, VK_OBJECT_TYP
 template <class T>
 inline void CommandBuffer::set_specialization_constant(uint32_t constant_id, const T &data)
 {
-	set_specialization_constant(constant_id, to_bytes(data));
+	static_assert(std::is_trivially_copyable<T>::value, "Specialization constants are set with the bytes of the value");
+	set_specialization_constant(constant_id, reinterpret_cast<const uint8_t *>(&data), sizeof(T));
 }
 
 template <>
 inline void CommandBuffer::set_specialization_constant<bool>(std::uint32_t constant_id, const bool &data)
 {
-	set_specialization_constant(constant_id, to_bytes(to_u32(data)));
+	uint32_t value = to_u32(data);
+	set_specialization_constant(constant_id, reinterpret_cast<const uint8_t *>(&value), sizeof(value));
 }
 }        // namespace vkb
@@ -17,6 +17,8 @@
 
 #include "descriptor_pool.h"
 
+#include <algorithm>
+
 #include "descriptor_set_layout.h"
 #include "device.h"
 
@@ -43,12 +45,12 @@ DescriptorPool::DescriptorPool(Device &                   device,
 
 	auto pool_size_it = pool_sizes.begin();
 
-	// Fill pool size for each descriptor type count multiplied by the pool size
+	// Fill pool size for each descriptor type count of a set
 	for (auto &it : descriptor_type_counts)
 	{
 		pool_size_it->type = it.first;
 
-		pool_size_it->descriptorCount = it.second * pool_size;
+		pool_size_it->descriptorCount = it.second;
 
 		++pool_size_it;
 	}
@@ -76,6 +78,7 @@ void DescriptorPool::reset()
 	// Clear internal tracking of descriptor set allocations
 	std::fill(pool_sets_count.begin(), pool_sets_count.end(), 0);
 	set_pool_mapping.clear();
+	free_sets.clear();
 
 	// Reset the pool index from which descriptor sets are allocated
 	pool_index = 0;
@@ -94,6 +97,14 @@ void DescriptorPool::set_descriptor_set_layout(const DescriptorSetLayout &set_la
 
 VkDescriptorSet DescriptorPool::allocate()
 {
+	// Descriptor sets of the same layout are interchangeable, a freed one is written again by its new owner
+	if (!free_sets.empty())
+	{
+		VkDescriptorSet handle = free_sets.back();
+		free_sets.pop_back();
+		return handle;
+	}
+
 	pool_index = find_available_pool(pool_index);
 
 	// Increment allocated set count for the current pool
@@ -127,27 +138,13 @@ VkDescriptorSet DescriptorPool::allocate()
 
 VkResult DescriptorPool::free(VkDescriptorSet descriptor_set)
 {
-	// Get the pool index of the descriptor set
-	auto it = set_pool_mapping.find(descriptor_set);
-
-	if (it == set_pool_mapping.end())
+	// The pools are not created with FREE_DESCRIPTOR_SET_BIT, the descriptor set is kept for the next allocation
+	if (set_pool_mapping.find(descriptor_set) == set_pool_mapping.end())
 	{
 		return VK_INCOMPLETE;
 	}
 
-	auto desc_pool_index = it->second;
-
-	// Free descriptor set from the pool
-	vkFreeDescriptorSets(device.get_handle(), pools[desc_pool_index], 1, &descriptor_set);
-
-	// Remove descriptor set mapping to the pool
-	set_pool_mapping.erase(it);
-
-	// Decrement allocated set count for the pool
-	--pool_sets_count[desc_pool_index];
-
-	// Change the current pool index to use the available pool
-	pool_index = desc_pool_index;
+	free_sets.push_back(descriptor_set);
 
 	return VK_SUCCESS;
 }
@@ -157,10 +154,16 @@ std::uint32_t DescriptorPool::find_available_pool(std::uint32_t search_index)
 	// Create a new pool
 	if (pools.size() <= search_index)
 	{
+		std::vector<VkDescriptorPoolSize> scaled_pool_sizes{pool_sizes};
+		for (auto &pool_size : scaled_pool_sizes)
+		{
+			pool_size.descriptorCount *= pool_max_sets;
+		}
+
 		VkDescriptorPoolCreateInfo create_info{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
 
-		create_info.poolSizeCount = to_u32(pool_sizes.size());
-		create_info.pPoolSizes    = pool_sizes.data();
+		create_info.poolSizeCount = to_u32(scaled_pool_sizes.size());
+		create_info.pPoolSizes    = scaled_pool_sizes.data();
 		create_info.maxSets       = pool_max_sets;
 
 		// We do not set FREE_DESCRIPTOR_SET_BIT as we do not need to free individual descriptor sets
@@ -191,10 +194,15 @@ std::uint32_t DescriptorPool::find_available_pool(std::uint32_t search_index)
 
 		// Add set count for the descriptor pool
 		pool_sets_count.push_back(0);
+		pool_sets_capacity.push_back(pool_max_sets);
+
+		// Layouts which keep requesting sets get larger pools
+		uint32_t grown_max_sets = MAX_SETS_PER_GROWN_POOL;
+		pool_max_sets           = std::max(pool_max_sets, std::min(pool_max_sets * 2, grown_max_sets));
 
 		return search_index;
 	}
-	else if (pool_sets_count[search_index] < pool_max_sets)
+	else if (pool_sets_count[search_index] < pool_sets_capacity[search_index])
 	{
 		return search_index;
 	}
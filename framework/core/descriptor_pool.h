@@ -28,13 +28,18 @@ class Device;
 class DescriptorSetLayout;
 
 /**
- * @brief Manages an array of fixed size VkDescriptorPool and is able to allocate descriptor sets
+ * @brief Manages an array of VkDescriptorPool and is able to allocate descriptor sets
+ *        Each new VkDescriptorPool holds twice as many sets as the previous one, up to MAX_SETS_PER_GROWN_POOL,
+ *        so that layouts with many sets need few pools while layouts with few sets stay small.
+ *        Freed descriptor sets are handed out again by allocate, as they all share the same layout.
  */
 class DescriptorPool
 {
   public:
 	static const uint32_t MAX_SETS_PER_POOL = 16;
 
+	static const uint32_t MAX_SETS_PER_GROWN_POOL = 1024;
+
 	DescriptorPool(Device &                   device,
 	               const DescriptorSetLayout &descriptor_set_layout,
 	               uint32_t                   pool_size = MAX_SETS_PER_POOL);
@@ -57,6 +62,11 @@ class DescriptorPool
 
 	VkDescriptorSet allocate();
 
+	/**
+	 * @brief Returns a descriptor set to the pool, to be handed out again by allocate
+	 *        The GPU must be done with the descriptor set, and it must be written again before being used
+	 * @return VK_INCOMPLETE if the descriptor set was not allocated from this pool
+	 */
 	VkResult free(VkDescriptorSet descriptor_set);
 
   private:
@@ -64,10 +74,10 @@ class DescriptorPool
 
 	const DescriptorSetLayout *descriptor_set_layout{nullptr};
 
-	// Descriptor pool size
+	// Descriptor counts of a single set, multiplied by the number of sets of a pool when it is created
 	std::vector<VkDescriptorPoolSize> pool_sizes;
 
-	// Number of sets to allocate for each pool
+	// Number of sets to allocate for the next pool
 	uint32_t pool_max_sets{0};
 
 	// Total descriptor pools created
@@ -76,6 +86,12 @@ class DescriptorPool
 	// Count sets for each pool
 	std::vector<uint32_t> pool_sets_count;
 
+	// Number of sets each pool was created for
+	std::vector<uint32_t> pool_sets_capacity;
+
+	// Descriptor sets freed, to be allocated again
+	std::vector<VkDescriptorSet> free_sets;
+
 	// Current pool index to allocate descriptor set
 	uint32_t pool_index{0};
 
@@ -246,6 +246,11 @@ const DescriptorSetLayout &DescriptorSet::get_layout() const
 	return descriptor_set_layout;
 }
 
+DescriptorPool &DescriptorSet::get_descriptor_pool() const
+{
+	return descriptor_pool;
+}
+
 BindingMap<VkDescriptorBufferInfo> &DescriptorSet::get_buffer_infos()
 {
 	return buffer_infos;
@@ -106,6 +106,36 @@ DescriptorSetLayout::DescriptorSetLayout(Device &                           devi
 	//        This way, different pipelines (with different shaders / shader variants) will get
 	//        different descriptor set layouts (incl. appropriate name -> binding lookups)
 
+	push_descriptor = std::find_if(resource_set.begin(), resource_set.end(),
+	                               [](const ShaderResource &shader_resource) { return shader_resource.mode == ShaderResourceMode::Push; }) != resource_set.end();
+
+	if (push_descriptor)
+	{
+		if (!device.is_enabled(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME))
+		{
+			throw std::runtime_error("Cannot create descriptor set layout, pushed resources require " VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME ".");
+		}
+
+		// Every descriptor of the set is pushed, arrays of textures included
+		uint32_t descriptor_count = 0;
+		for (auto &resource : resource_set)
+		{
+			if (resource.type != ShaderResourceType::Input && resource.type != ShaderResourceType::Output &&
+			    resource.type != ShaderResourceType::PushConstant && resource.type != ShaderResourceType::SpecializationConstant)
+			{
+				descriptor_count += resource.array_size;
+			}
+		}
+
+		// The set is then cached, its pushed resources becoming dynamic ones
+		uint32_t max_push_descriptors = device.get_max_push_descriptors();
+		if (descriptor_count > max_push_descriptors)
+		{
+			LOGW("Descriptor set {} holds {} descriptors, more than the {} which can be pushed, its pushed resources are made dynamic", set_index, descriptor_count, max_push_descriptors);
+			push_descriptor = false;
+		}
+	}
+
 	for (auto &resource : resource_set)
 	{
 		// Skip shader resources whitout a binding point
@@ -118,7 +148,9 @@ DescriptorSetLayout::DescriptorSetLayout(Device &                           devi
 		}
 
 		// Convert from ShaderResourceType to VkDescriptorType.
-		auto descriptor_type = find_descriptor_type(resource.type, resource.mode == ShaderResourceMode::Dynamic);
+		// Pushed descriptors are written with their offset, push descriptor sets cannot hold dynamic buffers.
+		bool dynamic         = (resource.mode == ShaderResourceMode::Dynamic || resource.mode == ShaderResourceMode::Push) && !push_descriptor;
+		auto descriptor_type = find_descriptor_type(resource.type, dynamic);
 
 		if (resource.mode == ShaderResourceMode::UpdateAfterBind)
 		{
@@ -142,6 +174,11 @@ DescriptorSetLayout::DescriptorSetLayout(Device &                           devi
 
 		bindings.push_back(layout_binding);
 
+		if (dynamic)
+		{
+			dynamic_bindings = true;
+		}
+
 		// Store mapping between binding and the binding point
 		bindings_lookup.emplace(resource.binding, layout_binding);
 
@@ -155,17 +192,26 @@ DescriptorSetLayout::DescriptorSetLayout(Device &                           devi
 	create_info.bindingCount = to_u32(bindings.size());
 	create_info.pBindings    = bindings.data();
 
+	if (push_descriptor)
+	{
+		create_info.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+	}
+
 	// Handle update-after-bind extensions
 	if (std::find_if(resource_set.begin(), resource_set.end(),
 	                 [](const ShaderResource &shader_resource) { return shader_resource.mode == ShaderResourceMode::UpdateAfterBind; }) != resource_set.end())
 	{
 		// Spec states you can't have ANY dynamic resources if you have one of the bindings set to update-after-bind
-		if (std::find_if(resource_set.begin(), resource_set.end(),
-		                 [](const ShaderResource &shader_resource) { return shader_resource.mode == ShaderResourceMode::Dynamic; }) != resource_set.end())
+		if (dynamic_bindings)
 		{
 			throw std::runtime_error("Cannot create descriptor set layout, dynamic resources are not allowed if at least one resource is update-after-bind.");
 		}
 
+		if (push_descriptor)
+		{
+			throw std::runtime_error("Cannot create descriptor set layout, pushed resources are not allowed if at least one resource is update-after-bind.");
+		}
+
 		if (!validate_flags(device.get_gpu(), bindings, binding_flags))
 		{
 			throw std::runtime_error("Invalid binding, couldn't create descriptor set layout.");
@@ -197,7 +243,9 @@ DescriptorSetLayout::DescriptorSetLayout(DescriptorSetLayout &&other) :
     binding_flags{std::move(other.binding_flags)},
     bindings_lookup{std::move(other.bindings_lookup)},
     binding_flags_lookup{std::move(other.binding_flags_lookup)},
-    resources_lookup{std::move(other.resources_lookup)}
+    resources_lookup{std::move(other.resources_lookup)},
+    dynamic_bindings{other.dynamic_bindings},
+    push_descriptor{other.push_descriptor}
 {
 	other.handle = VK_NULL_HANDLE;
 }
@@ -255,6 +303,30 @@ std::unique_ptr<VkDescriptorSetLayoutBinding> DescriptorSetLayout::get_layout_bi
 	return get_layout_binding(it->second);
 }
 
+bool DescriptorSetLayout::has_dynamic_bindings() const
+{
+	return dynamic_bindings;
+}
+
+bool DescriptorSetLayout::is_dynamic_binding(uint32_t binding_index) const
+{
+	auto it = bindings_lookup.find(binding_index);
+
+	return it != bindings_lookup.end() && is_dynamic_buffer_descriptor_type(it->second.descriptorType);
+}
+
+const VkDescriptorSetLayoutBinding *DescriptorSetLayout::find_layout_binding(uint32_t binding_index) const
+{
+	auto it = bindings_lookup.find(binding_index);
+
+	return it != bindings_lookup.end() ? &it->second : nullptr;
+}
+
+bool DescriptorSetLayout::is_push_descriptor() const
+{
+	return push_descriptor;
+}
+
 VkDescriptorBindingFlagsEXT DescriptorSetLayout::get_layout_binding_flag(const uint32_t binding_index) const
 {
 	auto it = binding_flags_lookup.find(binding_index);
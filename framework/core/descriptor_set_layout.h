@@ -67,10 +67,30 @@ class DescriptorSetLayout
 
 	std::unique_ptr<VkDescriptorSetLayoutBinding> get_layout_binding(const std::string &name) const;
 
+	/**
+	 * @return Layout binding of a binding index, nullptr if the set has none, without copying it
+	 */
+	const VkDescriptorSetLayoutBinding *find_layout_binding(uint32_t binding_index) const;
+
 	const std::vector<VkDescriptorBindingFlagsEXT> &get_binding_flags() const;
 
 	VkDescriptorBindingFlagsEXT get_layout_binding_flag(const uint32_t binding_index) const;
 
+	/**
+	 * @return Whether a binding of the layout is a buffer with a dynamic offset
+	 */
+	bool has_dynamic_bindings() const;
+
+	/**
+	 * @brief Checks whether a binding is a buffer with a dynamic offset, without copying its layout binding
+	 */
+	bool is_dynamic_binding(uint32_t binding_index) const;
+
+	/**
+	 * @return Whether the descriptors of the set are pushed into the command buffer, rather than allocated in descriptor sets
+	 */
+	bool is_push_descriptor() const;
+
 	const std::vector<ShaderModule *> &get_shader_modules() const;
 
   private:
@@ -91,5 +111,9 @@ class DescriptorSetLayout
 	std::unordered_map<std::string, uint32_t> resources_lookup;
 
 	std::vector<ShaderModule *> shader_modules;
+
+	bool dynamic_bindings{false};
+
+	bool push_descriptor{false};
 };
 }        // namespace vkb
@@ -290,6 +290,17 @@ bool Device::is_enabled(const char *extension)
 	return std::find_if(enabled_extensions.begin(), enabled_extensions.end(), [extension](const char *enabled_extension) { return strcmp(extension, enabled_extension) == 0; }) != enabled_extensions.end();
 }
 
+uint32_t Device::get_max_push_descriptors() const
+{
+	VkPhysicalDevicePushDescriptorPropertiesKHR push_descriptor_properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR};
+
+	VkPhysicalDeviceProperties2KHR properties{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR};
+	properties.pNext = &push_descriptor_properties;
+	vkGetPhysicalDeviceProperties2KHR(gpu.get_handle(), &properties);
+
+	return push_descriptor_properties.maxPushDescriptors;
+}
+
 const PhysicalDevice &Device::get_gpu() const
 {
 	return gpu;
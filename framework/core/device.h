@@ -132,6 +132,11 @@ class Device : public core::VulkanResource<VkDevice, VK_OBJECT_TYPE_DEVICE>
 
 	bool is_enabled(const char *extension);
 
+	/**
+	 * @return Largest number of descriptors of a push descriptor set layout, VK_KHR_push_descriptor must be enabled
+	 */
+	uint32_t get_max_push_descriptors() const;
+
 	uint32_t get_queue_family_index(VkQueueFlagBits queue_flag);
 
 	uint32_t get_num_queues_for_queue_family(uint32_t queue_family_index);
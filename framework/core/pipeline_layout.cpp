@@ -79,9 +79,20 @@ PipelineLayout::PipelineLayout(Device &device, const std::vector<ShaderModule *>
 	}
 
 	// Create a descriptor set layout for each shader set in the shader modules
+	uint32_t push_descriptor_set_count = 0;
 	for (auto &shader_set_it : shader_sets)
 	{
 		descriptor_set_layouts.emplace_back(&device.get_resource_cache().request_descriptor_set_layout(shader_set_it.first, shader_modules, shader_set_it.second));
+
+		if (descriptor_set_layouts.back()->is_push_descriptor())
+		{
+			push_descriptor_set_count++;
+		}
+	}
+
+	if (push_descriptor_set_count > 1)
+	{
+		throw std::runtime_error("Cannot create PipelineLayout, only one descriptor set can hold pushed resources.");
 	}
 
 	// Collect all the descriptor set layout handles, maintaining set order
@@ -50,7 +50,10 @@ enum class ShaderResourceMode
 {
 	Static,
 	Dynamic,
-	UpdateAfterBind
+	UpdateAfterBind,
+	/// Written into the command buffer with VK_KHR_push_descriptor every time it is flushed, instead of into a cached descriptor set.
+	/// Every resource of a set holding a pushed resource is pushed, a pipeline layout can have a single such set.
+	Push
 };
 
 /// A bitmask of qualifiers applied to a resource
@@ -0,0 +1,226 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "aabb_batch.h"
+
+#include <cassert>
+#include <cmath>
+
+#include "frustum.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#	define VKB_AABB_BATCH_SSE
+#	include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#	define VKB_AABB_BATCH_NEON
+#	include <arm_neon.h>
+#endif
+
+namespace vkb
+{
+void AABBBatch::clear()
+{
+	center_x.clear();
+	center_y.clear();
+	center_z.clear();
+	extent_x.clear();
+	extent_y.clear();
+	extent_z.clear();
+}
+
+void AABBBatch::reserve(size_t count)
+{
+	center_x.reserve(count);
+	center_y.reserve(count);
+	center_z.reserve(count);
+	extent_x.reserve(count);
+	extent_y.reserve(count);
+	extent_z.reserve(count);
+}
+
+size_t AABBBatch::add(const glm::vec3 &min, const glm::vec3 &max)
+{
+	glm::vec3 center  = (min + max) * 0.5f;
+	glm::vec3 extents = (max - min) * 0.5f;
+
+	center_x.push_back(center.x);
+	center_y.push_back(center.y);
+	center_z.push_back(center.z);
+	extent_x.push_back(extents.x);
+	extent_y.push_back(extents.y);
+	extent_z.push_back(extents.z);
+
+	return center_x.size() - 1;
+}
+
+size_t AABBBatch::size() const
+{
+	return center_x.size();
+}
+
+glm::vec3 AABBBatch::get_center(size_t index) const
+{
+	return {center_x[index], center_y[index], center_z[index]};
+}
+
+glm::vec3 AABBBatch::get_extents(size_t index) const
+{
+	return {extent_x[index], extent_y[index], extent_z[index]};
+}
+
+size_t AABBBatch::cull(const glm::vec4 *planes, size_t plane_count, std::vector<uint8_t> &visibility) const
+{
+	visibility.resize(size());
+
+	return test_planes(planes, plane_count, 1.0f, 0, size(), visibility.data());
+}
+
+size_t AABBBatch::cull(const glm::vec4 *planes, size_t plane_count, size_t first, size_t last, uint8_t *visibility) const
+{
+	assert(first <= last && last <= size());
+
+	return test_planes(planes, plane_count, 1.0f, first, last, visibility);
+}
+
+size_t AABBBatch::cull(const Frustum &frustum, std::vector<uint8_t> &visibility) const
+{
+	const auto &planes = frustum.get_planes();
+
+	return cull(planes.data(), planes.size(), visibility);
+}
+
+size_t AABBBatch::contain(const glm::vec4 *planes, size_t plane_count, std::vector<uint8_t> &containment) const
+{
+	containment.resize(size());
+
+	return test_planes(planes, plane_count, -1.0f, 0, size(), containment.data());
+}
+
+size_t AABBBatch::test_planes(const glm::vec4 *planes, size_t plane_count, float radius_sign, size_t first, size_t last, uint8_t *result) const
+{
+	size_t pass_count = 0;
+	size_t i          = first;
+
+	// The signed distance of the box center to each plane is offset by the projection
+	// of the half extents onto the plane normal. Adding it gives the distance of the
+	// corner furthest inside (intersection test), subtracting it gives the distance of
+	// the corner furthest outside (containment test).
+#if defined(VKB_AABB_BATCH_SSE)
+	const __m128 zero = _mm_setzero_ps();
+
+	for (; i + 4 <= last; i += 4)
+	{
+		__m128 cx = _mm_loadu_ps(&center_x[i]);
+		__m128 cy = _mm_loadu_ps(&center_y[i]);
+		__m128 cz = _mm_loadu_ps(&center_z[i]);
+		__m128 ex = _mm_loadu_ps(&extent_x[i]);
+		__m128 ey = _mm_loadu_ps(&extent_y[i]);
+		__m128 ez = _mm_loadu_ps(&extent_z[i]);
+
+		__m128 inside = _mm_cmpeq_ps(zero, zero);
+
+		for (size_t p = 0; p < plane_count; p++)
+		{
+			const glm::vec4 &plane = planes[p];
+
+			__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx),
+			                                        _mm_mul_ps(_mm_set1_ps(plane.y), cy)),
+			                             _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), cz),
+			                                        _mm_set1_ps(plane.w)));
+
+			__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(radius_sign * std::abs(plane.x)), ex),
+			                                      _mm_mul_ps(_mm_set1_ps(radius_sign * std::abs(plane.y)), ey)),
+			                           _mm_mul_ps(_mm_set1_ps(radius_sign * std::abs(plane.z)), ez));
+
+			inside = _mm_and_ps(inside, _mm_cmpgt_ps(_mm_add_ps(distance, radius), zero));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+
+		for (size_t lane = 0; lane < 4; lane++)
+		{
+			result[i + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+			pass_count += result[i + lane];
+		}
+	}
+#elif defined(VKB_AABB_BATCH_NEON)
+	const float32x4_t zero = vdupq_n_f32(0.0f);
+
+	for (; i + 4 <= last; i += 4)
+	{
+		float32x4_t cx = vld1q_f32(&center_x[i]);
+		float32x4_t cy = vld1q_f32(&center_y[i]);
+		float32x4_t cz = vld1q_f32(&center_z[i]);
+		float32x4_t ex = vld1q_f32(&extent_x[i]);
+		float32x4_t ey = vld1q_f32(&extent_y[i]);
+		float32x4_t ez = vld1q_f32(&extent_z[i]);
+
+		uint32x4_t inside = vdupq_n_u32(0xFFFFFFFF);
+
+		for (size_t p = 0; p < plane_count; p++)
+		{
+			const glm::vec4 &plane = planes[p];
+
+			float32x4_t distance = vdupq_n_f32(plane.w);
+			distance             = vmlaq_n_f32(distance, cx, plane.x);
+			distance             = vmlaq_n_f32(distance, cy, plane.y);
+			distance             = vmlaq_n_f32(distance, cz, plane.z);
+
+			float32x4_t radius = vmulq_n_f32(ex, radius_sign * std::abs(plane.x));
+			radius             = vmlaq_n_f32(radius, ey, radius_sign * std::abs(plane.y));
+			radius             = vmlaq_n_f32(radius, ez, radius_sign * std::abs(plane.z));
+
+			inside = vandq_u32(inside, vcgtq_f32(vaddq_f32(distance, radius), zero));
+		}
+
+		uint32_t lanes[4];
+		vst1q_u32(lanes, inside);
+
+		for (size_t lane = 0; lane < 4; lane++)
+		{
+			result[i + lane] = lanes[lane] ? 1 : 0;
+			pass_count += result[i + lane];
+		}
+	}
+#endif
+
+	// Remaining boxes, or all of them when no SIMD instruction set is available
+	for (; i < last; i++)
+	{
+		uint8_t pass = 1;
+
+		for (size_t p = 0; p < plane_count; p++)
+		{
+			const glm::vec4 &plane = planes[p];
+
+			float distance = plane.x * center_x[i] + plane.y * center_y[i] + plane.z * center_z[i] + plane.w;
+			float radius   = radius_sign * (std::abs(plane.x) * extent_x[i] + std::abs(plane.y) * extent_y[i] + std::abs(plane.z) * extent_z[i]);
+
+			if (distance + radius <= 0.0f)
+			{
+				pass = 0;
+				break;
+			}
+		}
+
+		result[i] = pass;
+		pass_count += pass;
+	}
+
+	return pass_count;
+}
+}        // namespace vkb
@@ -0,0 +1,114 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+class Frustum;
+
+/**
+ * @brief A list of axis aligned bounding boxes stored as a structure of arrays
+ *        (center and half extents per axis), so that they can be tested against
+ *        a set of planes four at a time with SSE or NEON
+ */
+class AABBBatch
+{
+  public:
+	/**
+	 * @brief Removes all the boxes, keeping the allocated storage
+	 */
+	void clear();
+
+	/**
+	 * @brief Reserves storage for a number of boxes
+	 */
+	void reserve(size_t count);
+
+	/**
+	 * @brief Appends a bounding box to the batch
+	 * @param min Minimum corner of the box
+	 * @param max Maximum corner of the box
+	 * @return The index of the box in the batch
+	 */
+	size_t add(const glm::vec3 &min, const glm::vec3 &max);
+
+	size_t size() const;
+
+	/**
+	 * @brief Center of the box at the given index
+	 */
+	glm::vec3 get_center(size_t index) const;
+
+	/**
+	 * @brief Half extents of the box at the given index
+	 */
+	glm::vec3 get_extents(size_t index) const;
+
+	/**
+	 * @brief Tests every box against a convex volume described by inward facing planes
+	 * @param planes Normalized planes (xyz normal, w distance) of the volume
+	 * @param plane_count Number of planes
+	 * @param visibility Set to 1 for each box intersecting or inside the volume, 0 otherwise
+	 * @return The number of visible boxes
+	 */
+	size_t cull(const glm::vec4 *planes, size_t plane_count, std::vector<uint8_t> &visibility) const;
+
+	/**
+	 * @brief Tests the boxes of a range against a convex volume, disjoint ranges can be tested concurrently
+	 * @param first Index of the first box of the range
+	 * @param last Index past the last box of the range
+	 * @param visibility Holds a value per box of the batch, set for the boxes of the range
+	 * @return The number of visible boxes in the range
+	 */
+	size_t cull(const glm::vec4 *planes, size_t plane_count, size_t first, size_t last, uint8_t *visibility) const;
+
+	/**
+	 * @brief Tests every box against the six planes of a frustum
+	 */
+	size_t cull(const Frustum &frustum, std::vector<uint8_t> &visibility) const;
+
+	/**
+	 * @brief Tests whether every box lies entirely inside a convex volume
+	 * @param planes Normalized planes (xyz normal, w distance) of the volume
+	 * @param plane_count Number of planes
+	 * @param containment Set to 1 for each box fully inside the volume, 0 otherwise
+	 * @return The number of contained boxes
+	 */
+	size_t contain(const glm::vec4 *planes, size_t plane_count, std::vector<uint8_t> &containment) const;
+
+  private:
+	size_t test_planes(const glm::vec4 *planes, size_t plane_count, float radius_sign, size_t first, size_t last, uint8_t *result) const;
+
+	std::vector<float> center_x;
+	std::vector<float> center_y;
+	std::vector<float> center_z;
+
+	std::vector<float> extent_x;
+	std::vector<float> extent_y;
+	std::vector<float> extent_z;
+};
+}        // namespace vkb
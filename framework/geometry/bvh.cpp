@@ -0,0 +1,391 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bvh.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+
+#include "common/helpers.h"
+
+namespace vkb
+{
+namespace
+{
+constexpr uint32_t max_leaf_items = 4;
+
+constexpr uint32_t bin_count = 8;
+
+float surface_area(const glm::vec3 &min, const glm::vec3 &max)
+{
+	glm::vec3 size = glm::max(max - min, glm::vec3(0.0f));
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+enum class Overlap
+{
+	Outside,
+	Intersecting,
+	Inside
+};
+}        // namespace
+
+void BVH::build(const std::vector<glm::vec3> &mins, const std::vector<glm::vec3> &maxs)
+{
+	assert(mins.size() == maxs.size());
+
+	item_mins = mins;
+	item_maxs = maxs;
+
+	item_order.resize(mins.size());
+	for (uint32_t i = 0; i < item_order.size(); ++i)
+	{
+		item_order[i] = i;
+	}
+
+	nodes.clear();
+	depth = 0;
+	if (!item_order.empty())
+	{
+		nodes.reserve(2 * item_order.size() / max_leaf_items + 1);
+		build_node(0, to_u32(item_order.size()), 0);
+	}
+}
+
+uint32_t BVH::build_node(uint32_t first_item, uint32_t item_count, uint32_t node_depth)
+{
+	uint32_t node_index = to_u32(nodes.size());
+	nodes.push_back({});
+
+	glm::vec3 min{std::numeric_limits<float>::max()};
+	glm::vec3 max{std::numeric_limits<float>::lowest()};
+	glm::vec3 centroid_min{std::numeric_limits<float>::max()};
+	glm::vec3 centroid_max{std::numeric_limits<float>::lowest()};
+
+	for (uint32_t i = first_item; i < first_item + item_count; ++i)
+	{
+		uint32_t item = item_order[i];
+		min           = glm::min(min, item_mins[item]);
+		max           = glm::max(max, item_maxs[item]);
+
+		glm::vec3 centroid = (item_mins[item] + item_maxs[item]) * 0.5f;
+		centroid_min       = glm::min(centroid_min, centroid);
+		centroid_max       = glm::max(centroid_max, centroid);
+	}
+
+	nodes[node_index] = {min, max, first_item, item_count, 0};
+
+	if (item_count <= max_leaf_items)
+	{
+		depth = std::max(depth, node_depth);
+		return node_index;
+	}
+
+	glm::vec3 centroid_size = centroid_max - centroid_min;
+
+	int axis = 0;
+	if (centroid_size.y > centroid_size[axis])
+	{
+		axis = 1;
+	}
+	if (centroid_size.z > centroid_size[axis])
+	{
+		axis = 2;
+	}
+
+	auto centroid_of = [this, axis](uint32_t item) {
+		return (item_mins[item][axis] + item_maxs[item][axis]) * 0.5f;
+	};
+
+	uint32_t left_count = item_count / 2;
+
+	if (centroid_size[axis] > 0.0f)
+	{
+		// Binned surface area heuristic along the longest centroid axis
+		struct Bin
+		{
+			glm::vec3 min{std::numeric_limits<float>::max()};
+			glm::vec3 max{std::numeric_limits<float>::lowest()};
+			uint32_t  count{0};
+		};
+
+		std::array<Bin, bin_count> bins{};
+
+		float bin_scale = bin_count / centroid_size[axis];
+
+		auto bin_of = [&](uint32_t item) {
+			auto bin = static_cast<uint32_t>((centroid_of(item) - centroid_min[axis]) * bin_scale);
+			return std::min(bin, bin_count - 1);
+		};
+
+		for (uint32_t i = first_item; i < first_item + item_count; ++i)
+		{
+			uint32_t item = item_order[i];
+			Bin     &bin  = bins[bin_of(item)];
+			bin.min       = glm::min(bin.min, item_mins[item]);
+			bin.max       = glm::max(bin.max, item_maxs[item]);
+			++bin.count;
+		}
+
+		// Sweep from the right to accumulate the cost of every right partition
+		std::array<float, bin_count> right_cost{};
+
+		Bin right{};
+		for (uint32_t i = bin_count - 1; i > 0; --i)
+		{
+			right.min = glm::min(right.min, bins[i].min);
+			right.max = glm::max(right.max, bins[i].max);
+			right.count += bins[i].count;
+			right_cost[i] = right.count * surface_area(right.min, right.max);
+		}
+
+		float    best_cost  = std::numeric_limits<float>::max();
+		uint32_t best_split = 0;
+
+		Bin left{};
+		for (uint32_t i = 0; i < bin_count - 1; ++i)
+		{
+			left.min = glm::min(left.min, bins[i].min);
+			left.max = glm::max(left.max, bins[i].max);
+			left.count += bins[i].count;
+
+			if (left.count == 0 || left.count == item_count)
+			{
+				continue;
+			}
+
+			float cost = left.count * surface_area(left.min, left.max) + right_cost[i + 1];
+			if (cost < best_cost)
+			{
+				best_cost  = cost;
+				best_split = i + 1;
+			}
+		}
+
+		if (best_split > 0)
+		{
+			auto middle = std::partition(item_order.begin() + first_item,
+			                             item_order.begin() + first_item + item_count,
+			                             [&](uint32_t item) { return bin_of(item) < best_split; });
+
+			left_count = to_u32(middle - (item_order.begin() + first_item));
+		}
+	}
+
+	if (left_count == 0 || left_count == item_count)
+	{
+		// All centroids fall in the same bin, split at the median instead
+		left_count = item_count / 2;
+		std::nth_element(item_order.begin() + first_item,
+		                 item_order.begin() + first_item + left_count,
+		                 item_order.begin() + first_item + item_count,
+		                 [&](uint32_t a, uint32_t b) { return centroid_of(a) < centroid_of(b); });
+	}
+
+	build_node(first_item, left_count, node_depth + 1);
+	uint32_t right_child = build_node(first_item + left_count, item_count - left_count, node_depth + 1);
+
+	nodes[node_index].right_child = right_child;
+
+	return node_index;
+}
+
+void BVH::set_item_bounds(uint32_t item, const glm::vec3 &min, const glm::vec3 &max)
+{
+	item_mins[item] = min;
+	item_maxs[item] = max;
+}
+
+void BVH::refit()
+{
+	// Children are always stored after their parent
+	for (size_t i = nodes.size(); i-- > 0;)
+	{
+		Node *node = &nodes[i];
+
+		if (node->right_child == 0)
+		{
+			node->min = glm::vec3(std::numeric_limits<float>::max());
+			node->max = glm::vec3(std::numeric_limits<float>::lowest());
+
+			for (uint32_t j = node->first_item; j < node->first_item + node->item_count; ++j)
+			{
+				node->min = glm::min(node->min, item_mins[item_order[j]]);
+				node->max = glm::max(node->max, item_maxs[item_order[j]]);
+			}
+		}
+		else
+		{
+			const Node &left  = nodes[i + 1];
+			const Node &right = nodes[node->right_child];
+
+			node->min = glm::min(left.min, right.min);
+			node->max = glm::max(left.max, right.max);
+		}
+	}
+}
+
+size_t BVH::get_item_count() const
+{
+	return item_mins.size();
+}
+
+const glm::vec3 &BVH::get_item_min(uint32_t item) const
+{
+	return item_mins[item];
+}
+
+const glm::vec3 &BVH::get_item_max(uint32_t item) const
+{
+	return item_maxs[item];
+}
+
+void BVH::append_items(const Node &node, std::vector<uint32_t> &items) const
+{
+	items.insert(items.end(), item_order.begin() + node.first_item, item_order.begin() + node.first_item + node.item_count);
+}
+
+template <class Classify>
+void BVH::traverse(Classify classify, std::vector<uint32_t> &items) const
+{
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	// Every level leaves at most one node on the stack, a tree deeper than the fixed stack only happens with very unbalanced splits
+	std::array<uint32_t, 64> fixed_stack;
+	std::vector<uint32_t>    deep_stack;
+
+	uint32_t *stack = fixed_stack.data();
+	if (depth + 1 > fixed_stack.size())
+	{
+		deep_stack.resize(depth + 1);
+		stack = deep_stack.data();
+	}
+
+	size_t stack_size = 0;
+
+	stack[stack_size++] = 0;
+
+	while (stack_size > 0)
+	{
+		uint32_t node_index = stack[--stack_size];
+
+		const Node &node = nodes[node_index];
+
+		Overlap overlap = classify(node.min, node.max);
+
+		if (overlap == Overlap::Outside)
+		{
+			continue;
+		}
+
+		if (overlap == Overlap::Inside)
+		{
+			append_items(node, items);
+		}
+		else if (node.right_child == 0)
+		{
+			// Test the items of a partially visible leaf individually
+			for (uint32_t i = node.first_item; i < node.first_item + node.item_count; ++i)
+			{
+				uint32_t item = item_order[i];
+				if (classify(item_mins[item], item_maxs[item]) != Overlap::Outside)
+				{
+					items.push_back(item);
+				}
+			}
+		}
+		else
+		{
+			stack[stack_size++] = node.right_child;
+			stack[stack_size++] = node_index + 1;
+		}
+	}
+}
+
+void BVH::query(const glm::vec4 *planes, size_t plane_count, std::vector<uint32_t> &items) const
+{
+	traverse([planes, plane_count](const glm::vec3 &min, const glm::vec3 &max) {
+		glm::vec3 center  = (min + max) * 0.5f;
+		glm::vec3 extents = (max - min) * 0.5f;
+
+		Overlap overlap = Overlap::Inside;
+
+		for (size_t i = 0; i < plane_count; ++i)
+		{
+			glm::vec3 normal = glm::vec3(planes[i]);
+
+			float distance = glm::dot(normal, center) + planes[i].w;
+			float radius   = glm::dot(glm::abs(normal), extents);
+
+			if (distance < -radius)
+			{
+				return Overlap::Outside;
+			}
+			if (distance < radius)
+			{
+				overlap = Overlap::Intersecting;
+			}
+		}
+
+		return overlap;
+	},
+	         items);
+}
+
+void BVH::query(const glm::vec3 &center, float radius, std::vector<uint32_t> &items) const
+{
+	float radius_squared = radius * radius;
+
+	traverse([&center, radius_squared](const glm::vec3 &min, const glm::vec3 &max) {
+		glm::vec3 closest = glm::clamp(center, min, max);
+		glm::vec3 delta   = closest - center;
+
+		if (glm::dot(delta, delta) > radius_squared)
+		{
+			return Overlap::Outside;
+		}
+
+		// Inside when the farthest corner lies in the sphere
+		glm::vec3 farthest = glm::max(glm::abs(min - center), glm::abs(max - center));
+
+		return glm::dot(farthest, farthest) <= radius_squared ? Overlap::Inside : Overlap::Intersecting;
+	},
+	         items);
+}
+
+void BVH::query(const glm::vec3 &min, const glm::vec3 &max, std::vector<uint32_t> &items) const
+{
+	traverse([&min, &max](const glm::vec3 &node_min, const glm::vec3 &node_max) {
+		if (glm::any(glm::lessThan(node_max, min)) || glm::any(glm::greaterThan(node_min, max)))
+		{
+			return Overlap::Outside;
+		}
+
+		if (glm::all(glm::greaterThanEqual(node_min, min)) && glm::all(glm::lessThanEqual(node_max, max)))
+		{
+			return Overlap::Inside;
+		}
+
+		return Overlap::Intersecting;
+	},
+	         items);
+}
+}        // namespace vkb
@@ -0,0 +1,116 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+/**
+ * @brief Bounding volume hierarchy over a set of axis aligned boxes, identified
+ *        by their index. Nodes are stored depth-first and every node covers a
+ *        contiguous range of items, so fully visible subtrees are appended
+ *        without being traversed.
+ */
+class BVH
+{
+  public:
+	/**
+	 * @brief Builds the hierarchy with a binned surface area heuristic
+	 * @param mins Minimum corner of every item
+	 * @param maxs Maximum corner of every item
+	 */
+	void build(const std::vector<glm::vec3> &mins, const std::vector<glm::vec3> &maxs);
+
+	/**
+	 * @brief Updates the bounds of an item, the hierarchy is updated by refit()
+	 */
+	void set_item_bounds(uint32_t item, const glm::vec3 &min, const glm::vec3 &max);
+
+	/**
+	 * @brief Recomputes the bounds of every node from the item bounds, keeping the topology
+	 */
+	void refit();
+
+	size_t get_item_count() const;
+
+	const glm::vec3 &get_item_min(uint32_t item) const;
+
+	const glm::vec3 &get_item_max(uint32_t item) const;
+
+	/**
+	 * @brief Finds the items intersecting a convex volume
+	 * @param planes Normalized planes (xyz normal, w distance) of the volume, facing inwards
+	 * @param plane_count Number of planes
+	 * @param items Indices of the items found are appended to it
+	 */
+	void query(const glm::vec4 *planes, size_t plane_count, std::vector<uint32_t> &items) const;
+
+	/**
+	 * @brief Finds the items intersecting a sphere
+	 */
+	void query(const glm::vec3 &center, float radius, std::vector<uint32_t> &items) const;
+
+	/**
+	 * @brief Finds the items intersecting a box
+	 */
+	void query(const glm::vec3 &min, const glm::vec3 &max, std::vector<uint32_t> &items) const;
+
+  private:
+	struct Node
+	{
+		glm::vec3 min;
+
+		glm::vec3 max;
+
+		/// Range of the node in item_order
+		uint32_t first_item;
+
+		uint32_t item_count;
+
+		/// The left child follows its parent, 0 marks a leaf
+		uint32_t right_child;
+	};
+
+	uint32_t build_node(uint32_t first_item, uint32_t item_count, uint32_t node_depth);
+
+	void append_items(const Node &node, std::vector<uint32_t> &items) const;
+
+	template <class Classify>
+	void traverse(Classify classify, std::vector<uint32_t> &items) const;
+
+	std::vector<Node> nodes;
+
+	/// Item indices, reordered so that every node covers a contiguous range
+	std::vector<uint32_t> item_order;
+
+	std::vector<glm::vec3> item_mins;
+
+	std::vector<glm::vec3> item_maxs;
+
+	/// Depth of the deepest leaf, the root at depth 0, which bounds the traversal stack
+	uint32_t depth{0};
+};
+}        // namespace vkb
@@ -0,0 +1,343 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_set>
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @brief Squared distances to a set of planes, as the coefficients of a symmetric 4x4 matrix
+ */
+struct Quadric
+{
+	double xx{0}, xy{0}, xz{0}, yy{0}, yz{0}, zz{0};
+
+	double dx{0}, dy{0}, dz{0}, dd{0};
+
+	/// Number of planes
+	double weight{0};
+
+	void add_plane(const glm::dvec3 &n, double d)
+	{
+		xx += n.x * n.x;
+		xy += n.x * n.y;
+		xz += n.x * n.z;
+		yy += n.y * n.y;
+		yz += n.y * n.z;
+		zz += n.z * n.z;
+		dx += n.x * d;
+		dy += n.y * d;
+		dz += n.z * d;
+		dd += d * d;
+		weight += 1;
+	}
+
+	void add(const Quadric &other)
+	{
+		xx += other.xx;
+		xy += other.xy;
+		xz += other.xz;
+		yy += other.yy;
+		yz += other.yz;
+		zz += other.zz;
+		dx += other.dx;
+		dy += other.dy;
+		dz += other.dz;
+		dd += other.dd;
+		weight += other.weight;
+	}
+
+	/**
+	 * @return Mean squared distance of a point to the planes
+	 */
+	double evaluate(const glm::vec3 &p) const
+	{
+		if (weight == 0)
+		{
+			return 0.0;
+		}
+
+		double x = p.x, y = p.y, z = p.z;
+
+		double result = xx * x * x + 2 * xy * x * y + 2 * xz * x * z +
+		                yy * y * y + 2 * yz * y * z +
+		                zz * z * z +
+		                2 * (dx * x + dy * y + dz * z) + dd;
+
+		// Rounding may leave a tiny negative error
+		return std::max(result, 0.0) / weight;
+	}
+};
+
+struct Collapse
+{
+	uint32_t from;
+
+	uint32_t to;
+
+	double cost;
+};
+
+glm::vec3 triangle_normal(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2)
+{
+	return glm::cross(p1 - p0, p2 - p0);
+}
+}        // namespace
+
+std::vector<uint32_t> simplify_mesh(const std::vector<glm::vec3> &positions, const std::vector<uint32_t> &indices, size_t target_index_count, float &error)
+{
+	const auto vertex_count = static_cast<uint32_t>(positions.size());
+
+	std::vector<uint32_t> result{indices};
+	error = 0.0f;
+
+	// Weld the vertices sharing a position, the topology is measured on the welded mesh
+	std::vector<uint32_t> order(vertex_count);
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&positions](uint32_t a, uint32_t b) {
+		const auto &pa = positions[a];
+		const auto &pb = positions[b];
+		return pa.x != pb.x ? pa.x < pb.x : pa.y != pb.y ? pa.y < pb.y : pa.z < pb.z;
+	});
+
+	std::vector<uint32_t> welded(vertex_count);
+	std::vector<bool>     seam(vertex_count, false);
+
+	for (size_t begin = 0; begin < order.size();)
+	{
+		size_t end = begin + 1;
+		while (end < order.size() && positions[order[end]] == positions[order[begin]])
+		{
+			end++;
+		}
+
+		for (size_t i = begin; i < end; i++)
+		{
+			welded[order[i]] = order[begin];
+			seam[order[i]]   = end - begin > 1;
+		}
+
+		begin = end;
+	}
+
+	// Moving a vertex of a seam would tear the attributes of the other side apart
+	std::vector<bool> locked{seam};
+
+	// An edge used in one direction only lies on an open border
+	std::unordered_set<uint64_t> edges;
+	edges.reserve(result.size());
+	for (size_t i = 0; i < result.size(); i += 3)
+	{
+		for (size_t e = 0; e < 3; e++)
+		{
+			uint64_t a = welded[result[i + e]];
+			uint64_t b = welded[result[i + (e + 1) % 3]];
+			edges.insert((a << 32) | b);
+		}
+	}
+
+	for (size_t i = 0; i < result.size(); i += 3)
+	{
+		for (size_t e = 0; e < 3; e++)
+		{
+			uint64_t a = welded[result[i + e]];
+			uint64_t b = welded[result[i + (e + 1) % 3]];
+			if (edges.find((b << 32) | a) == edges.end())
+			{
+				locked[result[i + e]]           = true;
+				locked[result[i + (e + 1) % 3]] = true;
+			}
+		}
+	}
+
+	std::vector<Quadric> quadrics(vertex_count);
+	for (size_t i = 0; i < result.size(); i += 3)
+	{
+		const glm::dvec3 p0 = positions[result[i]];
+		const glm::dvec3 p1 = positions[result[i + 1]];
+		const glm::dvec3 p2 = positions[result[i + 2]];
+
+		glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+		double     length = glm::length(normal);
+		if (length == 0.0)
+		{
+			continue;
+		}
+		normal /= length;
+
+		for (size_t v = 0; v < 3; v++)
+		{
+			quadrics[welded[result[i + v]]].add_plane(normal, -glm::dot(normal, p0));
+		}
+	}
+
+	std::vector<uint32_t> triangle_offsets(vertex_count + 1);
+	std::vector<uint32_t> fill_offsets(vertex_count);
+	std::vector<uint32_t> vertex_triangles;
+	std::vector<Collapse> collapses;
+	std::vector<uint32_t> collapse_targets(vertex_count);
+	std::vector<bool>     pass_locked(vertex_count);
+	double                max_cost = 0.0;
+
+	// Every pass collapses a set of edges whose neighbourhoods do not overlap, cheapest first
+	while (result.size() > target_index_count)
+	{
+		// Triangles around every vertex
+		std::fill(triangle_offsets.begin(), triangle_offsets.end(), 0);
+		for (auto index : result)
+		{
+			triangle_offsets[index + 1]++;
+		}
+		std::partial_sum(triangle_offsets.begin(), triangle_offsets.end(), triangle_offsets.begin());
+
+		vertex_triangles.resize(result.size());
+		std::copy(triangle_offsets.begin(), triangle_offsets.end() - 1, fill_offsets.begin());
+		for (size_t i = 0; i < result.size(); i++)
+		{
+			vertex_triangles[fill_offsets[result[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+
+		collapses.clear();
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			for (size_t e = 0; e < 3; e++)
+			{
+				uint32_t a = result[i + e];
+				uint32_t b = result[i + (e + 1) % 3];
+
+				for (auto collapse : {std::make_pair(a, b), std::make_pair(b, a)})
+				{
+					// Seam vertices are not targets either, the collapsed triangles would take the attributes of one side
+					if (locked[collapse.first] || seam[collapse.second])
+					{
+						continue;
+					}
+
+					Quadric quadric = quadrics[welded[collapse.first]];
+					quadric.add(quadrics[welded[collapse.second]]);
+
+					collapses.push_back({collapse.first, collapse.second, quadric.evaluate(positions[collapse.second])});
+				}
+			}
+		}
+
+		if (collapses.empty())
+		{
+			break;
+		}
+
+		std::sort(collapses.begin(), collapses.end(), [](const Collapse &a, const Collapse &b) { return a.cost < b.cost; });
+
+		std::iota(collapse_targets.begin(), collapse_targets.end(), 0);
+		std::fill(pass_locked.begin(), pass_locked.end(), false);
+
+		size_t triangles_to_remove = (result.size() - target_index_count + 2) / 3;
+		size_t triangles_removed   = 0;
+
+		for (auto &collapse : collapses)
+		{
+			if (triangles_removed >= triangles_to_remove)
+			{
+				break;
+			}
+
+			if (pass_locked[collapse.from] || pass_locked[collapse.to])
+			{
+				continue;
+			}
+
+			// Reject the collapse if it flips a remaining triangle around the vertex
+			bool   valid           = true;
+			size_t shared_triangles = 0;
+
+			for (uint32_t t = triangle_offsets[collapse.from]; t < triangle_offsets[collapse.from + 1] && valid; t++)
+			{
+				const uint32_t *triangle = &result[vertex_triangles[t] * 3];
+
+				if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to)
+				{
+					shared_triangles++;
+					continue;
+				}
+
+				glm::vec3 before[3];
+				glm::vec3 after[3];
+				for (size_t v = 0; v < 3; v++)
+				{
+					before[v] = positions[triangle[v]];
+					after[v]  = triangle[v] == collapse.from ? positions[collapse.to] : before[v];
+				}
+
+				valid = glm::dot(triangle_normal(before[0], before[1], before[2]), triangle_normal(after[0], after[1], after[2])) > 0.0f;
+			}
+
+			if (!valid || shared_triangles == 0)
+			{
+				continue;
+			}
+
+			collapse_targets[collapse.from] = collapse.to;
+			quadrics[welded[collapse.to]].add(quadrics[welded[collapse.from]]);
+			max_cost = std::max(max_cost, collapse.cost);
+
+			// The neighbourhood has changed, its collapses are evaluated again in the next pass
+			for (uint32_t t = triangle_offsets[collapse.from]; t < triangle_offsets[collapse.from + 1]; t++)
+			{
+				const uint32_t *triangle = &result[vertex_triangles[t] * 3];
+				pass_locked[triangle[0]] = true;
+				pass_locked[triangle[1]] = true;
+				pass_locked[triangle[2]] = true;
+			}
+
+			triangles_removed += shared_triangles;
+		}
+
+		if (triangles_removed == 0)
+		{
+			break;
+		}
+
+		// Remap the collapsed vertices and drop the triangles which became degenerate
+		size_t write = 0;
+		for (size_t i = 0; i < result.size(); i += 3)
+		{
+			uint32_t a = collapse_targets[result[i]];
+			uint32_t b = collapse_targets[result[i + 1]];
+			uint32_t c = collapse_targets[result[i + 2]];
+
+			if (a != b && b != c && c != a)
+			{
+				result[write++] = a;
+				result[write++] = b;
+				result[write++] = c;
+			}
+		}
+		result.resize(write);
+	}
+
+	error = static_cast<float>(std::sqrt(max_cost));
+
+	return result;
+}
+}        // namespace vkb
@@ -0,0 +1,44 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+/**
+ * @brief Simplifies an indexed triangle list by collapsing its edges in the order of their
+ *        quadric error. A vertex only ever collapses onto one of its neighbours, so the result
+ *        indexes the same vertices as the input and can share its vertex buffers.
+ *        Vertices on open borders and attribute seams (several vertices at one position)
+ *        are kept in place, so the silhouette and texture mapping of the mesh hold.
+ * @param positions Position of every vertex
+ * @param indices Triangle list to simplify
+ * @param target_index_count Number of indices to stop at, not reached if no more edges can collapse
+ * @param[out] error Largest root mean square distance of a collapsed vertex to the planes of the triangles it merged
+ * @return The simplified triangle list
+ */
+std::vector<uint32_t> simplify_mesh(const std::vector<glm::vec3> &positions, const std::vector<uint32_t> &indices, size_t target_index_count, float &error);
+}        // namespace vkb
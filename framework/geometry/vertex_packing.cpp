@@ -0,0 +1,78 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "geometry/vertex_packing.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace vkb
+{
+namespace
+{
+/// Largest magnitude of the texture coordinates stored as half floats, their step is 1/1024 between 1 and 2
+constexpr float max_half_texcoord = 2.0f;
+
+glm::vec2 sign_not_zero(const glm::vec2 &value)
+{
+	return glm::vec2(value.x >= 0.0f ? 1.0f : -1.0f, value.y >= 0.0f ? 1.0f : -1.0f);
+}
+}        // namespace
+
+glm::vec2 encode_octahedral(const glm::vec3 &direction)
+{
+	float length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+	if (length == 0.0f)
+	{
+		return glm::vec2(0.0f);
+	}
+
+	glm::vec3 octahedron = direction / length;
+
+	// The lower hemisphere is folded over the diagonals of the square
+	if (octahedron.z < 0.0f)
+	{
+		return (1.0f - glm::abs(glm::vec2(octahedron.y, octahedron.x))) * sign_not_zero(glm::vec2(octahedron));
+	}
+
+	return glm::vec2(octahedron);
+}
+
+glm::vec3 decode_octahedral(const glm::vec2 &encoded)
+{
+	glm::vec3 direction{encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y)};
+
+	float fold = std::max(-direction.z, 0.0f);
+	direction.x += direction.x >= 0.0f ? -fold : fold;
+	direction.y += direction.y >= 0.0f ? -fold : fold;
+
+	return glm::normalize(direction);
+}
+
+bool can_pack_texcoords(const std::vector<glm::vec2> &texcoords)
+{
+	for (auto &texcoord : texcoords)
+	{
+		if (std::abs(texcoord.x) > max_half_texcoord || std::abs(texcoord.y) > max_half_texcoord)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+}        // namespace vkb
@@ -0,0 +1,50 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+namespace vkb
+{
+/**
+ * @brief Maps a unit vector onto the unit octahedron unfolded into a square, so that it is stored in two
+ *        components with an error evenly spread over the sphere. Read back by decode_octahedral in shaders.
+ * @param direction Unit vector, a zero vector is encoded as +Z
+ * @return Coordinates in [-1, 1]
+ */
+glm::vec2 encode_octahedral(const glm::vec3 &direction);
+
+/**
+ * @brief Inverse of encode_octahedral
+ * @return Unit vector
+ */
+glm::vec3 decode_octahedral(const glm::vec2 &encoded);
+
+/**
+ * @return Whether texture coordinates keep enough precision as half floats, whose precision halves with
+ *         every power of two, so only coordinates close to the [0, 1] range are packed
+ */
+bool can_pack_texcoords(const std::vector<glm::vec2> &texcoords);
+}        // namespace vkb
@@ -19,13 +19,17 @@
 #define TINYGLTF_IMPLEMENTATION
 #include "gltf_loader.h"
 
+#include <algorithm>
+#include <cstring>
 #include <limits>
+#include <map>
 #include <queue>
 
 #include "common/error.h"
 
 VKBP_DISABLE_WARNINGS()
 #include "common/glm_common.h"
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/type_ptr.hpp>
 VKBP_ENABLE_WARNINGS()
 
@@ -34,8 +38,11 @@ VKBP_ENABLE_WARNINGS()
 #include "common/vk_common.h"
 #include "core/device.h"
 #include "core/image.h"
+#include "geometry/mesh_simplifier.h"
+#include "geometry/vertex_packing.h"
 #include "platform/filesystem.h"
 #include "scene_graph/components/camera.h"
+#include "scene_graph/components/geometry_buffer.h"
 #include "scene_graph/components/image.h"
 #include "scene_graph/components/image/astc.h"
 #include "scene_graph/components/light.h"
@@ -50,7 +57,7 @@ VKBP_ENABLE_WARNINGS()
 #include "scene_graph/scene.h"
 #include "scene_graph/scripts/animation.h"
 
-#include <ctpl_stl.h>
+#include <core/util/job_system.hpp>
 
 
 struct Vertex
@@ -410,6 +417,380 @@ inline void prepare_meshlets(std::vector<Meshlet> &meshlets, std::unique_ptr<vkb
 	}
 }
 
+/**
+ * @brief Simplifies a submesh into levels of detail of decreasing triangle counts,
+ *        appending their indices to the index data in the index type of the submesh
+ * @param submesh Submesh receiving the levels, with vertex_indices and index_type set
+ * @param position_data Three floats per vertex position
+ * @param position_stride Stride of the positions in bytes
+ * @param index_data Indices of the submesh, the levels are appended to it
+ */
+inline void generate_lods(vkb::sg::SubMesh &submesh, const std::vector<uint8_t> &position_data, size_t position_stride, std::vector<uint8_t> &index_data)
+{
+	// Each level targets half the triangles of the previous one
+	const uint32_t max_lod_count       = 4;
+	const float    lod_ratio           = 0.5f;
+	const uint32_t min_lod_index_count = 3 * 64;
+
+	if (submesh.vertex_indices < 2 * min_lod_index_count)
+	{
+		return;
+	}
+
+	std::vector<glm::vec3> positions(submesh.vertices_count);
+	for (size_t i = 0; i < positions.size(); i++)
+	{
+		positions[i] = glm::make_vec3(reinterpret_cast<const float *>(position_data.data() + i * position_stride));
+	}
+
+	size_t                index_size = submesh.index_type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+	std::vector<uint32_t> indices(submesh.vertex_indices);
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		if (index_size == sizeof(uint16_t))
+		{
+			indices[i] = *(reinterpret_cast<const uint16_t *>(index_data.data()) + i);
+		}
+		else
+		{
+			indices[i] = *(reinterpret_cast<const uint32_t *>(index_data.data()) + i);
+		}
+	}
+
+	float error = 0.0f;
+	while (submesh.lods.size() < max_lod_count)
+	{
+		size_t target_index_count = static_cast<size_t>(indices.size() * lod_ratio) / 3 * 3;
+		if (target_index_count < min_lod_index_count)
+		{
+			break;
+		}
+
+		float lod_error   = 0.0f;
+		auto  lod_indices = vkb::simplify_mesh(positions, indices, target_index_count, lod_error);
+
+		// Stop once the collapses are blocked by borders and seams
+		if (lod_indices.empty() || lod_indices.size() > indices.size() * 0.9f)
+		{
+			break;
+		}
+
+		// Each level is simplified from the previous one, so their errors add up
+		error += lod_error;
+
+		vkb::sg::SubMeshLod lod;
+		lod.index_offset = vkb::to_u32(index_data.size());
+		lod.index_count  = vkb::to_u32(lod_indices.size());
+		lod.error        = error;
+		submesh.lods.push_back(lod);
+
+		for (auto index : lod_indices)
+		{
+			if (index_size == sizeof(uint16_t))
+			{
+				auto value = static_cast<uint16_t>(index);
+				index_data.insert(index_data.end(), reinterpret_cast<uint8_t *>(&value), reinterpret_cast<uint8_t *>(&value) + sizeof(value));
+			}
+			else
+			{
+				index_data.insert(index_data.end(), reinterpret_cast<uint8_t *>(&index), reinterpret_cast<uint8_t *>(&index) + sizeof(index));
+			}
+		}
+
+		indices = std::move(lod_indices);
+	}
+}
+
+/**
+ * @brief Appends the values of a submesh to the geometry gathered for a buffer shared by the submeshes of a scene
+ * @return Offset of the values in the buffer, aligned so that any vertex attribute or index type can be read from it
+ */
+inline size_t append_geometry(std::vector<uint8_t> &geometry, const std::vector<uint8_t> &values)
+{
+	const size_t alignment = 16;
+
+	size_t offset = (geometry.size() + alignment - 1) / alignment * alignment;
+
+	geometry.resize(offset);
+	geometry.insert(geometry.end(), values.begin(), values.end());
+
+	return offset;
+}
+
+/**
+ * @brief Vertex attribute of a glTF primitive, as read from its accessor
+ */
+struct VertexAttributeData
+{
+	std::vector<uint8_t> data;
+
+	VkFormat format = VK_FORMAT_UNDEFINED;
+
+	uint32_t stride = 0;
+};
+
+template <class T>
+std::vector<T> read_vertex_values(const VertexAttributeData &attribute, uint32_t vertex_count)
+{
+	std::vector<T> values(vertex_count);
+	for (size_t i = 0; i < values.size(); i++)
+	{
+		std::memcpy(&values[i], attribute.data.data() + i * attribute.stride, sizeof(T));
+	}
+	return values;
+}
+
+/**
+ * @brief Vertex stream of a submesh, holding a single attribute or several interleaved ones
+ */
+struct VertexStream
+{
+	std::vector<std::string> attributes;
+
+	std::vector<uint8_t> data;
+
+	uint32_t stride = 0;
+};
+
+/**
+ * @brief Packs the vertex attributes of a submesh into the streams of the shared vertex buffer.
+ *        The positions keep a stream of their own, which is all the depth and shadow passes read.
+ *        The normals, tangents and texture coordinates are interleaved in a second stream, the
+ *        directions in octahedral encoding and the texture coordinates in half floats when they
+ *        keep enough precision. Other attributes keep a stream each, in their glTF format.
+ * @param submesh Submesh receiving the attributes, with vertices_count set
+ * @param attributes Attributes of the submesh, by name
+ * @param quantize_positions Whether the positions are stored in 16 bit normalized integers, within the bounds of the submesh
+ * @param streams Streams of the submesh, placed in the vertex buffer once all the submeshes are packed
+ */
+inline void pack_vertex_attributes(vkb::sg::SubMesh &submesh, const std::map<std::string, VertexAttributeData> &attributes, bool quantize_positions, std::vector<VertexStream> &streams)
+{
+	auto add_stream = [&](const std::string &name, const std::vector<uint8_t> &values, VkFormat format, uint32_t stride) {
+		streams.push_back({{name}, values, stride});
+
+		vkb::sg::VertexAttribute attribute;
+		attribute.format = format;
+		attribute.stride = stride;
+
+		submesh.set_attribute(name, attribute);
+	};
+
+	uint32_t vertex_count = submesh.vertices_count;
+
+	std::vector<glm::vec3> normals;
+	std::vector<glm::vec4> tangents;
+	std::vector<glm::vec2> texcoords;
+	VkFormat               texcoord_format = VK_FORMAT_R32G32_SFLOAT;
+
+	for (auto &attribute : attributes)
+	{
+		auto &name = attribute.first;
+		auto &data = attribute.second;
+
+		if (name == "position" && data.format == VK_FORMAT_R32G32B32_SFLOAT && quantize_positions && vertex_count > 0)
+		{
+			auto positions = read_vertex_values<glm::vec3>(data, vertex_count);
+
+			glm::vec3 min_position = positions[0];
+			glm::vec3 max_position = positions[0];
+			for (auto &position : positions)
+			{
+				min_position = glm::min(min_position, position);
+				max_position = glm::max(max_position, position);
+			}
+
+			// Flat submeshes keep a unit scale on their flat axes
+			glm::vec3 extent = max_position - min_position;
+			submesh.position_offset = min_position;
+			submesh.position_scale  = glm::vec3(extent.x > 0.0f ? extent.x : 1.0f, extent.y > 0.0f ? extent.y : 1.0f, extent.z > 0.0f ? extent.z : 1.0f);
+
+			std::vector<uint8_t> quantized(positions.size() * sizeof(uint64_t));
+			for (size_t i = 0; i < positions.size(); i++)
+			{
+				uint64_t value = glm::packUnorm4x16(glm::vec4((positions[i] - submesh.position_offset) / submesh.position_scale, 0.0f));
+				std::memcpy(quantized.data() + i * sizeof(uint64_t), &value, sizeof(uint64_t));
+			}
+
+			add_stream(name, quantized, vkb::sg::quantized_position_format, sizeof(uint64_t));
+		}
+		else if (name == "normal" && data.format == VK_FORMAT_R32G32B32_SFLOAT)
+		{
+			normals = read_vertex_values<glm::vec3>(data, vertex_count);
+		}
+		else if (name == "tangent" && data.format == VK_FORMAT_R32G32B32A32_SFLOAT)
+		{
+			tangents = read_vertex_values<glm::vec4>(data, vertex_count);
+		}
+		else if (name == "texcoord_0" && data.format == VK_FORMAT_R32G32_SFLOAT)
+		{
+			texcoords = read_vertex_values<glm::vec2>(data, vertex_count);
+			if (vkb::can_pack_texcoords(texcoords))
+			{
+				texcoord_format = VK_FORMAT_R16G16_SFLOAT;
+			}
+		}
+		else
+		{
+			add_stream(name, data.data, data.format, data.stride);
+		}
+	}
+
+	// Layout of the interleaved stream
+	uint32_t normal_offset   = 0;
+	uint32_t tangent_offset  = normal_offset + (normals.empty() ? 0 : sizeof(uint32_t));
+	uint32_t texcoord_offset = tangent_offset + (tangents.empty() ? 0 : sizeof(uint64_t));
+	uint32_t stride          = texcoord_offset;
+	if (!texcoords.empty())
+	{
+		stride += texcoord_format == VK_FORMAT_R16G16_SFLOAT ? sizeof(uint32_t) : sizeof(glm::vec2);
+	}
+
+	if (stride == 0)
+	{
+		return;
+	}
+
+	std::vector<uint8_t> interleaved(vertex_count * stride);
+	for (size_t i = 0; i < vertex_count; i++)
+	{
+		uint8_t *vertex = interleaved.data() + i * stride;
+
+		if (!normals.empty())
+		{
+			uint32_t value = glm::packSnorm2x16(vkb::encode_octahedral(normals[i]));
+			std::memcpy(vertex + normal_offset, &value, sizeof(value));
+		}
+
+		if (!tangents.empty())
+		{
+			glm::vec2 encoded = vkb::encode_octahedral(glm::vec3(tangents[i]));
+			uint64_t  value   = glm::packSnorm4x16(glm::vec4(encoded, tangents[i].w < 0.0f ? -1.0f : 1.0f, 0.0f));
+			std::memcpy(vertex + tangent_offset, &value, sizeof(value));
+		}
+
+		if (!texcoords.empty())
+		{
+			if (texcoord_format == VK_FORMAT_R16G16_SFLOAT)
+			{
+				uint32_t value = glm::packHalf2x16(texcoords[i]);
+				std::memcpy(vertex + texcoord_offset, &value, sizeof(value));
+			}
+			else
+			{
+				std::memcpy(vertex + texcoord_offset, &texcoords[i], sizeof(glm::vec2));
+			}
+		}
+	}
+
+	VertexStream stream;
+	stream.data   = std::move(interleaved);
+	stream.stride = stride;
+
+	auto add_interleaved = [&](const std::string &name, VkFormat format, uint32_t offset) {
+		stream.attributes.push_back(name);
+
+		vkb::sg::VertexAttribute attribute;
+		attribute.format = format;
+		attribute.stride = stride;
+		attribute.offset = offset;
+
+		submesh.set_attribute(name, attribute);
+	};
+
+	if (!normals.empty())
+	{
+		add_interleaved("normal", vkb::sg::octahedral_normal_format, normal_offset);
+	}
+	if (!tangents.empty())
+	{
+		add_interleaved("tangent", vkb::sg::octahedral_tangent_format, tangent_offset);
+	}
+	if (!texcoords.empty())
+	{
+		add_interleaved("texcoord_0", texcoord_format, texcoord_offset);
+	}
+
+	streams.push_back(std::move(stream));
+}
+
+/**
+ * @brief Places the vertex streams of the submeshes into the geometry of the shared vertex buffer.
+ *        Submeshes whose streams have the same layout share one arena per stream, in which their
+ *        vertices follow each other in the same order, so that they can all be drawn from the same
+ *        bindings with their vertex offset as base vertex.
+ * @param submeshes Submeshes receiving the ranges of their attributes and their vertex offset
+ * @param submesh_streams Streams of every submesh, as packed by pack_vertex_attributes
+ * @param vertex_geometry Geometry of the vertex buffer, the arenas are appended to it
+ */
+inline void place_vertex_streams(const std::vector<vkb::sg::SubMesh *> &submeshes, const std::vector<std::vector<VertexStream>> &submesh_streams, std::vector<uint8_t> &vertex_geometry)
+{
+	// Submeshes sharing arenas, by description of the layout of their streams
+	std::map<std::string, std::vector<size_t>> layouts;
+
+	for (size_t i = 0; i < submeshes.size(); i++)
+	{
+		std::string layout;
+		for (auto &stream : submesh_streams[i])
+		{
+			layout += std::to_string(stream.stride);
+
+			for (auto &name : stream.attributes)
+			{
+				vkb::sg::VertexAttribute attribute;
+				submeshes[i]->get_attribute(name, attribute);
+
+				layout += fmt::format(" {}:{}:{}", name, static_cast<int>(attribute.format), attribute.offset);
+			}
+
+			layout += ';';
+		}
+
+		layouts[layout].push_back(i);
+	}
+
+	for (auto &layout : layouts)
+	{
+		auto &layout_submeshes = layout.second;
+
+		uint32_t vertex_count = 0;
+		for (auto i : layout_submeshes)
+		{
+			submeshes[i]->vertex_offset = vertex_count;
+			vertex_count += submeshes[i]->vertices_count;
+		}
+
+		size_t stream_count = submesh_streams[layout_submeshes.front()].size();
+
+		for (size_t stream_index = 0; stream_index < stream_count; stream_index++)
+		{
+			uint32_t stride = submesh_streams[layout_submeshes.front()][stream_index].stride;
+
+			// Streams are cut or padded to their vertex count, for the base vertex of the next ones to hold
+			std::vector<uint8_t> arena(static_cast<size_t>(vertex_count) * stride);
+			for (auto i : layout_submeshes)
+			{
+				auto &data = submesh_streams[i][stream_index].data;
+				std::copy_n(data.begin(), std::min<size_t>(data.size(), static_cast<size_t>(submeshes[i]->vertices_count) * stride),
+				            arena.begin() + static_cast<size_t>(submeshes[i]->vertex_offset) * stride);
+			}
+
+			size_t arena_offset = append_geometry(vertex_geometry, arena);
+
+			for (auto i : layout_submeshes)
+			{
+				vkb::sg::BufferRange range;
+				range.offset = arena_offset + static_cast<size_t>(submeshes[i]->vertex_offset) * stride;
+				range.size   = static_cast<size_t>(submeshes[i]->vertices_count) * stride;
+
+				for (auto &name : submesh_streams[i][stream_index].attributes)
+				{
+					submeshes[i]->vertex_buffers[name] = range;
+				}
+			}
+		}
+	}
+}
+
 static inline bool texture_needs_srgb_colorspace(const std::string &name)
 {
 	// The gltf spec states that the base and emissive textures MUST be encoded with the sRGB
@@ -518,6 +899,11 @@ std::unique_ptr<sg::SubMesh> GLTFLoader::read_model_from_file(const std::string
 	return std::move(load_model(index, storage_buffer));
 }
 
+void GLTFLoader::set_quantize_positions(bool quantize)
+{
+	quantize_positions = quantize;
+}
+
 sg::Scene GLTFLoader::load_scene(int scene_index)
 {
 	auto scene = sg::Scene();
@@ -572,87 +958,104 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 	timer.start();
 
 	// Load images
-	auto thread_count = std::thread::hardware_concurrency();
-	thread_count      = thread_count == 0 ? 1 : thread_count;
-	ctpl::thread_pool thread_pool(thread_count);
-
-	auto image_count = to_u32(model.images.size());
+	auto &job_system  = JobSystem::get();
+	auto  image_count = to_u32(model.images.size());
 
-	std::vector<std::future<std::unique_ptr<sg::Image>>> image_component_futures;
+	// Images are decoded by the job system while the decoded ones are uploaded
+	std::vector<std::unique_ptr<sg::Image>> decoded_images(image_count);
+	std::vector<JobCounter>                 image_counters(image_count);
 	for (size_t image_index = 0; image_index < image_count; image_index++)
 	{
-		auto fut = thread_pool.push(
-		    [this, image_index](size_t) {
-			    auto image = parse_image(model.images[image_index]);
-
-			    LOGI("Loaded gltf image #{} ({})", image_index, model.images[image_index].uri.c_str());
-
-			    return image;
-		    });
+		job_system.schedule(image_counters[image_index], [this, &decoded_images, image_index]() {
+			decoded_images[image_index] = parse_image(model.images[image_index]);
 
-		image_component_futures.push_back(std::move(fut));
+			LOGI("Loaded gltf image #{} ({})", image_index, model.images[image_index].uri.c_str());
+		});
 	}
 
+	// The jobs reference the images, they must complete before leaving on an error
+	auto wait_for_images = [&job_system, &image_counters]() {
+		for (auto &counter : image_counters)
+		{
+			try
+			{
+				job_system.wait(counter);
+			}
+			catch (...)
+			{
+			}
+		}
+	};
+
 	std::vector<std::unique_ptr<sg::Image>> image_components;
 
-	// Upload images to GPU. We do this in batches of 64MB of data to avoid needing
-	// double the amount of memory (all the images and all the corresponding buffers).
-	// This helps keep memory footprint lower which is helpful on smaller devices.
-	size_t image_index = 0;
-	while (image_index < image_count)
+	try
 	{
-		std::vector<core::Buffer> transient_buffers;
+		// Upload images to GPU. We do this in batches of 64MB of data to avoid needing
+		// double the amount of memory (all the images and all the corresponding buffers).
+		// This helps keep memory footprint lower which is helpful on smaller devices.
+		size_t image_index = 0;
+		while (image_index < image_count)
+		{
+			std::vector<core::Buffer> transient_buffers;
 
-		auto &command_buffer = device.request_command_buffer();
+			auto &command_buffer = device.request_command_buffer();
 
-		command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, 0);
+			command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, 0);
 
-		size_t batch_size = 0;
+			size_t batch_size = 0;
 
-		// Deal with 64MB of image data at a time to keep memory footprint low
-		while (image_index < image_count && batch_size < 64 * 1024 * 1024)
-		{
-			// Wait for this image to complete loading, then stage for upload
-			image_components.push_back(image_component_futures[image_index].get());
+			// Deal with 64MB of image data at a time to keep memory footprint low
+			while (image_index < image_count && batch_size < 64 * 1024 * 1024)
+			{
+				// Wait for this image to complete loading, then stage for upload
+				job_system.wait(image_counters[image_index]);
+				image_components.push_back(std::move(decoded_images[image_index]));
 
-			auto &image = image_components[image_index];
+				auto &image = image_components[image_index];
 
-			core::Buffer stage_buffer{device,
-			                          image->get_data().size(),
-			                          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			                          VMA_MEMORY_USAGE_CPU_ONLY};
+				core::Buffer stage_buffer{device,
+				                          image->get_data().size(),
+				                          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+				                          VMA_MEMORY_USAGE_CPU_ONLY};
 
-			batch_size += image->get_data().size();
+				batch_size += image->get_data().size();
 
-			stage_buffer.update(image->get_data());
+				stage_buffer.update(image->get_data());
 
-			upload_image_to_gpu(command_buffer, stage_buffer, *image);
+				upload_image_to_gpu(command_buffer, stage_buffer, *image);
 
-			transient_buffers.push_back(std::move(stage_buffer));
+				transient_buffers.push_back(std::move(stage_buffer));
 
-			image_index++;
-		}
+				image_index++;
+			}
 
-		command_buffer.end();
+			command_buffer.end();
 
-		auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+			auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
 
-		queue.submit(command_buffer, device.request_fence());
+			queue.submit(command_buffer, device.request_fence());
 
-		device.get_fence_pool().wait();
-		device.get_fence_pool().reset();
-		device.get_command_pool().reset_pool();
-		device.wait_idle();
+			device.get_fence_pool().wait();
+			device.get_fence_pool().reset();
+			device.get_command_pool().reset_pool();
+			device.wait_idle();
 
-		// Remove the staging buffers for the batch we just processed
-		transient_buffers.clear();
+			// Remove the staging buffers for the batch we just processed
+			transient_buffers.clear();
+		}
+	}
+	catch (...)
+	{
+		wait_for_images();
+		throw;
 	}
 
 	scene.set_components(std::move(image_components));
 
 	auto elapsed_time = timer.stop();
 
-	LOGI("Time spent loading images: {} seconds across {} threads.", vkb::to_string(elapsed_time), thread_count);
+	LOGI("Time spent loading images: {} seconds across {} threads.", vkb::to_string(elapsed_time), job_system.get_worker_count() + 1);
 
 	// Load textures
 	auto images          = scene.get_components<sg::Image>();
@@ -686,8 +1089,8 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 	scene.add_component(std::move(default_sampler));
 
 	// Load materials
-	bool                            has_textures = scene.has_component<sg::Texture>();
-	std::vector<vkb::sg::Texture *> textures;
+	bool                           has_textures = scene.has_component<sg::Texture>();
+	sg::ComponentView<sg::Texture> textures;
 	if (has_textures)
 	{
 		textures = scene.get_components<sg::Texture>();
@@ -741,6 +1144,13 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 	// Load meshes
 	auto materials = scene.get_components<sg::PBRMaterial>();
 
+	// The vertices and indices of all the submeshes are gathered, to be uploaded into two buffers,
+	// which the submeshes refer to once created
+	std::vector<uint8_t>                   vertex_geometry;
+	std::vector<uint8_t>                   index_geometry;
+	std::vector<sg::SubMesh *>             loaded_submeshes;
+	std::vector<std::vector<VertexStream>> loaded_streams;
+
 	for (auto &gltf_mesh : model.meshes)
 	{
 		auto mesh = parse_mesh(gltf_mesh);
@@ -752,36 +1162,39 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 			auto submesh_name = fmt::format("'{}' mesh, primitive #{}", gltf_mesh.name, i_primitive);
 			auto submesh      = std::make_unique<sg::SubMesh>(std::move(submesh_name));
 
+			std::map<std::string, VertexAttributeData> attributes;
+
 			for (auto &attribute : gltf_primitive.attributes)
 			{
 				std::string attrib_name = attribute.first;
 				std::transform(attrib_name.begin(), attrib_name.end(), attrib_name.begin(), ::tolower);
 
-				auto vertex_data = get_attribute_data(&model, attribute.second);
-
 				if (attrib_name == "position")
 				{
 					assert(attribute.second < model.accessors.size());
 					submesh->vertices_count = to_u32(model.accessors[attribute.second].count);
 				}
 
-				core::Buffer buffer{device,
-				                    vertex_data.size(),
-				                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-				                    VMA_MEMORY_USAGE_CPU_TO_GPU};
-				buffer.update(vertex_data);
-				buffer.set_debug_name(fmt::format("'{}' mesh, primitive #{}: '{}' vertex buffer",
-				                                  gltf_mesh.name, i_primitive, attrib_name));
-
-				submesh->vertex_buffers.insert(std::make_pair(attrib_name, std::move(buffer)));
+				auto &attribute_data  = attributes[attrib_name];
+				attribute_data.data   = get_attribute_data(&model, attribute.second);
+				attribute_data.format = get_attribute_format(&model, attribute.second);
+				attribute_data.stride = to_u32(get_attribute_stride(&model, attribute.second));
+			}
 
-				sg::VertexAttribute attrib;
-				attrib.format = get_attribute_format(&model, attribute.second);
-				attrib.stride = to_u32(get_attribute_stride(&model, attribute.second));
+			// Kept to simplify the levels of detail, as the positions may be quantized
+			std::vector<uint8_t> position_data;
+			size_t               position_stride = 0;
 
-				submesh->set_attribute(attrib_name, attrib);
+			auto position_it = attributes.find("position");
+			if (position_it != attributes.end() && position_it->second.format == VK_FORMAT_R32G32B32_SFLOAT)
+			{
+				position_data   = position_it->second.data;
+				position_stride = position_it->second.stride;
 			}
 
+			std::vector<VertexStream> streams;
+			pack_vertex_attributes(*submesh, attributes, quantize_positions, streams);
+
 			if (gltf_primitive.indices >= 0)
 			{
 				submesh->vertex_indices = to_u32(get_attribute_size(&model, gltf_primitive.indices));
@@ -808,14 +1221,18 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 						break;
 				}
 
-				submesh->index_buffer = std::make_unique<core::Buffer>(device,
-				                                                       index_data.size(),
-				                                                       VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-				                                                       VMA_MEMORY_USAGE_GPU_TO_CPU);
-				submesh->index_buffer->set_debug_name(fmt::format("'{}' mesh, primitive #{}: index buffer",
-				                                                  gltf_mesh.name, i_primitive));
+				// Levels of detail follow the full detail indices in the same buffer
+				if (!position_data.empty() && gltf_primitive.mode == TINYGLTF_MODE_TRIANGLES)
+				{
+					generate_lods(*submesh, position_data, position_stride, index_data);
+				}
 
-				submesh->index_buffer->update(index_data);
+				// The offsets of the levels are relative to the indices of the submesh until they are gathered
+				submesh->index_offset = to_u32(append_geometry(index_geometry, index_data));
+				for (auto &lod : submesh->lods)
+				{
+					lod.index_offset += submesh->index_offset;
+				}
 			}
 			else
 			{
@@ -834,15 +1251,84 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 
 			mesh->add_submesh(*submesh);
 
+			loaded_submeshes.push_back(submesh.get());
+			loaded_streams.push_back(std::move(streams));
+
 			scene.add_component(std::move(submesh));
 		}
 
 		scene.add_component(std::move(mesh));
 	}
 
-	device.get_fence_pool().wait();
-	device.get_fence_pool().reset();
-	device.get_command_pool().reset_pool();
+	place_vertex_streams(loaded_submeshes, loaded_streams, vertex_geometry);
+	loaded_streams.clear();
+
+	// Upload the geometry once, into device local buffers
+	{
+		std::vector<core::Buffer> transient_buffers;
+
+		auto &command_buffer = device.request_command_buffer();
+
+		command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, 0);
+
+		auto upload_geometry = [&](const std::vector<uint8_t> &geometry, VkBufferUsageFlags usage, const std::string &name) -> const core::Buffer * {
+			// Buffers cannot be empty
+			if (geometry.empty())
+			{
+				return nullptr;
+			}
+
+			core::Buffer stage_buffer{device,
+			                          geometry.size(),
+			                          VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			                          VMA_MEMORY_USAGE_CPU_ONLY};
+
+			stage_buffer.update(geometry);
+
+			core::Buffer buffer{device,
+			                    geometry.size(),
+			                    usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			                    VMA_MEMORY_USAGE_GPU_ONLY};
+			buffer.set_debug_name(name);
+
+			command_buffer.copy_buffer(stage_buffer, buffer, geometry.size());
+
+			transient_buffers.push_back(std::move(stage_buffer));
+
+			auto geometry_buffer = std::make_unique<sg::GeometryBuffer>(name, std::move(buffer));
+			auto result          = &geometry_buffer->buffer;
+
+			scene.add_component(std::move(geometry_buffer));
+
+			return result;
+		};
+
+		auto vertex_buffer = upload_geometry(vertex_geometry, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, "Scene vertex buffer");
+		auto index_buffer  = upload_geometry(index_geometry, VK_BUFFER_USAGE_INDEX_BUFFER_BIT, "Scene index buffer");
+
+		command_buffer.end();
+
+		auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+		queue.submit(command_buffer, device.request_fence());
+
+		device.get_fence_pool().wait();
+		device.get_fence_pool().reset();
+		device.get_command_pool().reset_pool();
+
+		for (auto submesh : loaded_submeshes)
+		{
+			for (auto &vertex_range : submesh->vertex_buffers)
+			{
+				vertex_range.second.buffer = vertex_buffer;
+			}
+
+			if (submesh->vertex_indices != 0)
+			{
+				submesh->index_buffer = index_buffer;
+			}
+		}
+	}
 
 	scene.add_component(std::move(default_material));
 
@@ -1098,6 +1584,8 @@ sg::Scene GLTFLoader::load_scene(int scene_index)
 		vkb::add_directional_light(scene, glm::quat({glm::radians(-90.0f), 0.0f, glm::radians(30.0f)}));
 	}
 
+	scene.build_bvh();
+
 	return scene;
 }
 
@@ -1190,8 +1678,8 @@ std::unique_ptr<sg::SubMesh> GLTFLoader::load_model(uint32_t index, bool storage
 
 		command_buffer.copy_buffer(stage_buffer, buffer, aligned_vertex_data.size() * sizeof(AlignedVertex));
 
-		auto pair = std::make_pair("vertex_buffer", std::move(buffer));
-		submesh->vertex_buffers.insert(std::move(pair));
+		submesh->buffers.push_back(std::make_unique<core::Buffer>(std::move(buffer)));
+		submesh->vertex_buffers["vertex_buffer"] = {submesh->buffers.back().get(), 0, submesh->buffers.back()->get_size()};
 
 		transient_buffers.push_back(std::move(stage_buffer));
 	}
@@ -1223,8 +1711,8 @@ std::unique_ptr<sg::SubMesh> GLTFLoader::load_model(uint32_t index, bool storage
 
 		command_buffer.copy_buffer(stage_buffer, buffer, vertex_data.size() * sizeof(Vertex));
 
-		auto pair = std::make_pair("vertex_buffer", std::move(buffer));
-		submesh->vertex_buffers.insert(std::move(pair));
+		submesh->buffers.push_back(std::make_unique<core::Buffer>(std::move(buffer)));
+		submesh->vertex_buffers["vertex_buffer"] = {submesh->buffers.back().get(), 0, submesh->buffers.back()->get_size()};
 
 		transient_buffers.push_back(std::move(stage_buffer));
 	}
@@ -1278,10 +1766,11 @@ std::unique_ptr<sg::SubMesh> GLTFLoader::load_model(uint32_t index, bool storage
 
 			stage_buffer.update(meshlets.data(), meshlets.size() * sizeof(Meshlet));
 
-			submesh->index_buffer = std::make_unique<core::Buffer>(device,
-			                                                       meshlets.size() * sizeof(Meshlet),
-			                                                       VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-			                                                       VMA_MEMORY_USAGE_GPU_ONLY);
+			submesh->buffers.push_back(std::make_unique<core::Buffer>(device,
+			                                                          meshlets.size() * sizeof(Meshlet),
+			                                                          VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			                                                          VMA_MEMORY_USAGE_GPU_ONLY));
+			submesh->index_buffer = submesh->buffers.back().get();
 
 			command_buffer.copy_buffer(stage_buffer, *submesh->index_buffer, meshlets.size() * sizeof(Meshlet));
 
@@ -1296,10 +1785,11 @@ std::unique_ptr<sg::SubMesh> GLTFLoader::load_model(uint32_t index, bool storage
 
 			stage_buffer.update(index_data);
 
-			submesh->index_buffer = std::make_unique<core::Buffer>(device,
-			                                                       index_data.size(),
-			                                                       VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-			                                                       VMA_MEMORY_USAGE_GPU_ONLY);
+			submesh->buffers.push_back(std::make_unique<core::Buffer>(device,
+			                                                          index_data.size(),
+			                                                          VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+			                                                          VMA_MEMORY_USAGE_GPU_ONLY));
+			submesh->index_buffer = submesh->buffers.back().get();
 
 			command_buffer.copy_buffer(stage_buffer, *submesh->index_buffer, index_data.size());
 
@@ -81,6 +81,12 @@ class GLTFLoader
 	 */
 	std::unique_ptr<sg::SubMesh> read_model_from_file(const std::string &file_name, uint32_t index, bool storage_buffer = false);
 
+	/**
+	 * @brief Sets whether the positions of the scenes read next are quantized to 16 bit normalized integers,
+	 *        within the bounds of each submesh. Their vertex shaders must then handle QUANTIZED_POSITION.
+	 */
+	void set_quantize_positions(bool quantize);
+
   protected:
 	virtual std::unique_ptr<sg::Node> parse_node(const tinygltf::Node &gltf_node, size_t index) const;
 
@@ -128,6 +134,8 @@ class GLTFLoader
 
 	std::string model_path;
 
+	bool quantize_positions{false};
+
 	/// The extensions that the GLTFLoader can load mapped to whether they should be enabled or not
 	static std::unordered_map<std::string, bool> supported_extensions;
 
@@ -28,6 +28,8 @@
 #include <spdlog/sinks/basic_file_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
+#include <core/util/job_system.hpp>
+
 #include "common/logging.h"
 #include "platform/filesystem.h"
 #include "platform/parsers/CLI11.h"
@@ -122,6 +124,9 @@ ExitCode Platform::initialize(const std::vector<Plugin *> &plugins)
 		return ExitCode::FatalError;
 	}
 
+	// The thread running the main loop becomes the main thread of the job system
+	LOGI("Job system running {} worker threads", JobSystem::get().get_worker_count());
+
 	return ExitCode::Success;
 }
 
@@ -169,6 +174,9 @@ void Platform::update()
 			delta_time = simulation_frame_time;
 		}
 
+		// Jobs which must run on the main thread, scheduled by the jobs of the previous frame
+		JobSystem::get().run_main_thread_jobs();
+
 		active_app->update(delta_time);
 
 		if (auto *app = dynamic_cast<VulkanSample *>(active_app.get()))
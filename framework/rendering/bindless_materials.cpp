@@ -0,0 +1,170 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/bindless_materials.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "common/utils.h"
+#include "core/command_buffer.h"
+#include "core/device.h"
+#include "scene_graph/components/image.h"
+#include "scene_graph/components/material.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/pbr_material.h"
+#include "scene_graph/components/sampler.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/components/texture.h"
+
+namespace vkb
+{
+BindlessMaterials::BindlessMaterials(Device &device, const std::vector<sg::Mesh *> &meshes)
+{
+	std::vector<BindlessMaterial> materials;
+
+	for (auto mesh : meshes)
+	{
+		for (auto sub_mesh : mesh->get_submeshes())
+		{
+			auto material = sub_mesh->get_material();
+			if (!material || material_indices.count(material) != 0)
+			{
+				continue;
+			}
+
+			material_indices.emplace(material, to_u32(materials.size()));
+
+			BindlessMaterial bindless_material{};
+			bindless_material.base_color_factor  = glm::vec4(1.0f);
+			bindless_material.metallic_factor    = 1.0f;
+			bindless_material.roughness_factor   = 1.0f;
+			bindless_material.base_color_texture = ~0u;
+
+			if (auto pbr_material = dynamic_cast<const sg::PBRMaterial *>(material))
+			{
+				bindless_material.base_color_factor = pbr_material->base_color_factor;
+				bindless_material.metallic_factor   = pbr_material->metallic_factor;
+				bindless_material.roughness_factor  = pbr_material->roughness_factor;
+			}
+
+			// Every texture takes an element of the array, the ones the shaders do not read yet included
+			for (auto &texture : material->textures)
+			{
+				uint32_t texture_index = add_texture(texture.second->get_image()->get_vk_image_view(),
+				                                     texture.second->get_sampler()->vk_sampler);
+
+				if (texture.first == "base_color_texture")
+				{
+					bindless_material.base_color_texture = texture_index;
+				}
+			}
+
+			materials.push_back(bindless_material);
+		}
+	}
+
+	// A buffer cannot be empty
+	if (materials.empty())
+	{
+		materials.emplace_back();
+	}
+
+	material_buffer = std::make_unique<core::Buffer>(device, materials.size() * sizeof(BindlessMaterial), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	material_buffer->update(materials);
+}
+
+bool BindlessMaterials::is_supported(Device &device, const std::vector<sg::Mesh *> &meshes)
+{
+	auto &gpu = device.get_gpu();
+
+	if (!gpu.get_requested_features().shaderSampledImageArrayDynamicIndexing)
+	{
+		return false;
+	}
+
+	// Textures shared by several materials are counted once, the array may still be smaller
+	// as textures sharing their image and sampler take a single element
+	std::unordered_set<const sg::Texture *> textures;
+	for (auto mesh : meshes)
+	{
+		for (auto sub_mesh : mesh->get_submeshes())
+		{
+			if (auto material = sub_mesh->get_material())
+			{
+				for (auto &texture : material->textures)
+				{
+					textures.insert(texture.second);
+				}
+			}
+		}
+	}
+
+	const auto &limits = gpu.get_properties().limits;
+
+	uint32_t max_textures = std::min({limits.maxPerStageDescriptorSamplers,
+	                                  limits.maxPerStageDescriptorSampledImages,
+	                                  limits.maxDescriptorSetSamplers,
+	                                  limits.maxDescriptorSetSampledImages});
+
+	return textures.size() <= max_textures;
+}
+
+uint32_t BindlessMaterials::add_texture(const core::ImageView &image_view, const core::Sampler &sampler)
+{
+	auto texture = std::make_pair(&image_view, &sampler);
+
+	auto it = texture_indices.emplace(texture, to_u32(textures.size()));
+	if (it.second)
+	{
+		textures.push_back(texture);
+	}
+
+	return it.first->second;
+}
+
+void BindlessMaterials::add_definitions(ShaderVariant &variant) const
+{
+	variant.add_define("BINDLESS_MATERIALS");
+
+	// Arrays cannot be empty, the shaders do not declare the texture array without textures
+	if (!textures.empty())
+	{
+		variant.add_define("BINDLESS_TEXTURE_COUNT=" + std::to_string(textures.size()));
+	}
+}
+
+void BindlessMaterials::bind(CommandBuffer &command_buffer) const
+{
+	for (uint32_t i = 0; i < textures.size(); i++)
+	{
+		command_buffer.bind_image(*textures[i].first, *textures[i].second, descriptor_set, 0, i);
+	}
+
+	command_buffer.bind_buffer(*material_buffer, 0, material_buffer->get_size(), descriptor_set, 1, 0);
+}
+
+uint32_t BindlessMaterials::get_material_index(const sg::Material &material) const
+{
+	return material_indices.at(&material);
+}
+
+uint32_t BindlessMaterials::get_texture_count() const
+{
+	return to_u32(textures.size());
+}
+}        // namespace vkb
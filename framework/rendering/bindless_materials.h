@@ -0,0 +1,134 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "common/vk_common.h"
+#include "core/buffer.h"
+#include "core/image_view.h"
+#include "core/sampler.h"
+#include "core/shader_module.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class Device;
+
+namespace sg
+{
+class Material;
+class Mesh;
+}        // namespace sg
+
+/**
+ * @brief Material of the material buffer, as read by the BINDLESS_MATERIALS shader variants
+ */
+struct alignas(16) BindlessMaterial
+{
+	glm::vec4 base_color_factor;
+
+	float metallic_factor;
+
+	float roughness_factor;
+
+	/// Index of the base color texture in the texture array, ~0 if the material has none
+	uint32_t base_color_texture;
+};
+
+/**
+ * @brief Textures and materials of a set of meshes, gathered into tables bound once for all the draws.
+ *        Every texture of the materials is an element of a single array of combined image samplers,
+ *        and every material is an element of a storage buffer referring to its textures by index.
+ *        A draw then only selects its material with a push constant, so switching materials neither
+ *        binds textures nor requests another descriptor set.
+ *
+ *        The array is sized for the textures of the meshes, and all of its elements are written,
+ *        so it only relies on indexing arrays of samplers with dynamically uniform indices.
+ */
+class BindlessMaterials
+{
+  public:
+	/// Descriptor set of the tables, the sets below are left to the per-draw resources
+	static constexpr uint32_t descriptor_set = 1;
+
+	/**
+	 * @param device Device to create the material buffer with
+	 * @param meshes Meshes whose materials are gathered
+	 */
+	BindlessMaterials(Device &device, const std::vector<sg::Mesh *> &meshes);
+
+	BindlessMaterials(const BindlessMaterials &) = delete;
+
+	BindlessMaterials(BindlessMaterials &&) = delete;
+
+	~BindlessMaterials() = default;
+
+	BindlessMaterials &operator=(const BindlessMaterials &) = delete;
+
+	BindlessMaterials &operator=(BindlessMaterials &&) = delete;
+
+	/**
+	 * @return Whether the device can index the texture array of a set of meshes, it must be
+	 *         checked before constructing the tables
+	 */
+	static bool is_supported(Device &device, const std::vector<sg::Mesh *> &meshes);
+
+	/**
+	 * @brief Adds the defines selecting the bindless path of the shaders, and sizing their texture array
+	 */
+	void add_definitions(ShaderVariant &variant) const;
+
+	/**
+	 * @brief Binds the texture array and the material buffer, in descriptor_set
+	 */
+	void bind(CommandBuffer &command_buffer) const;
+
+	/**
+	 * @return Index of a material of the meshes in the material buffer
+	 */
+	uint32_t get_material_index(const sg::Material &material) const;
+
+	uint32_t get_texture_count() const;
+
+  private:
+	/**
+	 * @return Index of a texture in the texture array, added if it is not in it yet
+	 */
+	uint32_t add_texture(const core::ImageView &image_view, const core::Sampler &sampler);
+
+	std::vector<std::pair<const core::ImageView *, const core::Sampler *>> textures;
+
+	/// Index of every texture in textures
+	std::map<std::pair<const core::ImageView *, const core::Sampler *>, uint32_t> texture_indices;
+
+	std::unordered_map<const sg::Material *, uint32_t> material_indices;
+
+	std::unique_ptr<core::Buffer> material_buffer;
+};
+}        // namespace vkb
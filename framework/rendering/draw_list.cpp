@@ -0,0 +1,128 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "draw_list.h"
+
+#include <array>
+#include <cstring>
+
+namespace vkb
+{
+namespace
+{
+// Key layout, from the most significant bit:
+//   opaque:      layer (2) | state (18) | material (16) | unused (4) | depth (24)
+//   transparent: layer (2) | inverted depth (24) | state (18) | material (16) | unused (4)
+constexpr uint64_t layer_shift   = 62;
+constexpr uint64_t state_mask    = (1u << 18) - 1;
+constexpr uint64_t material_mask = (1u << 16) - 1;
+constexpr uint64_t depth_mask    = (1u << 24) - 1;
+constexpr size_t   radix_bits    = 8;
+constexpr size_t   radix_size    = 1 << radix_bits;
+constexpr size_t   radix_passes  = 64 / radix_bits;
+
+/**
+ * @brief Quantizes a positive distance to 24 bits while keeping its order.
+ *        The bit pattern of a positive float grows with its value, so the
+ *        top bits (sign excluded) are a monotonic, scale independent encoding.
+ */
+uint64_t quantize_depth(float depth)
+{
+	depth = depth > 0.0f ? depth : 0.0f;
+
+	uint32_t bits;
+	std::memcpy(&bits, &depth, sizeof(bits));
+
+	return (bits >> 7) & depth_mask;
+}
+}        // namespace
+
+uint64_t DrawList::opaque_key(uint32_t state_id, uint32_t material_id, float depth)
+{
+	return (static_cast<uint64_t>(Opaque) << layer_shift) |
+	       ((state_id & state_mask) << 44) |
+	       ((material_id & material_mask) << 28) |
+	       quantize_depth(depth);
+}
+
+uint64_t DrawList::transparent_key(uint32_t state_id, uint32_t material_id, float depth)
+{
+	return (static_cast<uint64_t>(Transparent) << layer_shift) |
+	       ((~quantize_depth(depth) & depth_mask) << 38) |
+	       ((state_id & state_mask) << 20) |
+	       ((material_id & material_mask) << 4);
+}
+
+DrawList::Layer DrawList::get_layer(uint64_t key)
+{
+	return static_cast<Layer>(key >> layer_shift);
+}
+
+void DrawList::clear()
+{
+	items.clear();
+}
+
+void DrawList::add(uint64_t key, sg::Node &node, sg::SubMesh &sub_mesh, uint32_t lod)
+{
+	items.push_back({key, &node, &sub_mesh, lod});
+}
+
+void DrawList::sort()
+{
+	sorted_items.resize(items.size());
+
+	for (size_t pass = 0; pass < radix_passes; pass++)
+	{
+		const size_t shift = pass * radix_bits;
+
+		std::array<size_t, radix_size> offsets{};
+
+		for (auto &item : items)
+		{
+			offsets[(item.key >> shift) & (radix_size - 1)]++;
+		}
+
+		// Skip the pass when every key has the same digit, which is the
+		// common case for the unused and high order bits of the key
+		if (offsets[(items.empty() ? 0 : items[0].key >> shift) & (radix_size - 1)] == items.size())
+		{
+			continue;
+		}
+
+		size_t sum = 0;
+		for (auto &offset : offsets)
+		{
+			size_t count = offset;
+			offset       = sum;
+			sum += count;
+		}
+
+		for (auto &item : items)
+		{
+			sorted_items[offsets[(item.key >> shift) & (radix_size - 1)]++] = item;
+		}
+
+		items.swap(sorted_items);
+	}
+}
+
+const std::vector<DrawItem> &DrawList::get_items() const
+{
+	return items;
+}
+}        // namespace vkb
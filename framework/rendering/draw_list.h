@@ -0,0 +1,95 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace vkb
+{
+namespace sg
+{
+class Node;
+class SubMesh;
+}        // namespace sg
+
+/**
+ * @brief A submesh instance to draw, ordered by a packed 64-bit sort key
+ */
+struct DrawItem
+{
+	uint64_t key;
+
+	sg::Node *node;
+
+	sg::SubMesh *sub_mesh;
+
+	/// Level of detail of the submesh, 0 for full detail
+	uint32_t lod;
+};
+
+/**
+ * @brief A flat list of draw items sorted by key with an LSD radix sort.
+ *        The storage is kept between frames so that steady state frames do not allocate.
+ */
+class DrawList
+{
+  public:
+	/// Layers occupy the top bits of the key, so all items of a layer are drawn together
+	enum Layer : uint64_t
+	{
+		Opaque      = 0,
+		Transparent = 1
+	};
+
+	/**
+	 * @brief Builds the key of an opaque item, sorted by state first and front-to-back last
+	 * @param state_id Pipeline state of the item (shader variant, rasterization), 18 bits
+	 * @param material_id Material of the item, 16 bits
+	 * @param depth Distance to the camera, must be positive
+	 */
+	static uint64_t opaque_key(uint32_t state_id, uint32_t material_id, float depth);
+
+	/**
+	 * @brief Builds the key of a transparent item, sorted back-to-front first and by state last
+	 * @param state_id Pipeline state of the item (shader variant, rasterization), 18 bits
+	 * @param material_id Material of the item, 16 bits
+	 * @param depth Distance to the camera, must be positive
+	 */
+	static uint64_t transparent_key(uint32_t state_id, uint32_t material_id, float depth);
+
+	static Layer get_layer(uint64_t key);
+
+	void clear();
+
+	void add(uint64_t key, sg::Node &node, sg::SubMesh &sub_mesh, uint32_t lod = 0);
+
+	/**
+	 * @brief Sorts the items by ascending key
+	 */
+	void sort();
+
+	const std::vector<DrawItem> &get_items() const;
+
+  private:
+	std::vector<DrawItem> items;
+
+	/// Ping-pong buffer for the radix sort passes
+	std::vector<DrawItem> sorted_items;
+};
+}        // namespace vkb
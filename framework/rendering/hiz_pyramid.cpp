@@ -0,0 +1,156 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/hiz_pyramid.h"
+
+#include "core/command_buffer.h"
+#include "core/debug.h"
+#include "core/device.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+HiZPyramid::HiZPyramid(RenderContext &render_context, ShaderSource &&downsample_source) :
+    render_context{render_context},
+    downsample_shader{std::move(downsample_source)}
+{
+	VkSamplerCreateInfo sampler_info{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+	sampler_info.magFilter    = VK_FILTER_NEAREST;
+	sampler_info.minFilter    = VK_FILTER_NEAREST;
+	sampler_info.mipmapMode   = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	sampler_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	sampler_info.maxLod       = VK_LOD_CLAMP_NONE;
+
+	sampler = std::make_unique<core::Sampler>(render_context.get_device(), sampler_info);
+
+	render_context.get_device().get_resource_cache().request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, downsample_shader);
+}
+
+void HiZPyramid::create_pyramid(const VkExtent2D &extent)
+{
+	depth_extent = extent;
+
+	VkExtent3D level_extent{std::max(extent.width / 2, 1u), std::max(extent.height / 2, 1u), 1};
+
+	uint32_t mip_count = 1;
+	while ((std::max(level_extent.width, level_extent.height) >> mip_count) > 0)
+	{
+		mip_count++;
+	}
+
+	mip_views.clear();
+	view.reset();
+
+	image = std::make_unique<core::Image>(render_context.get_device(),
+	                                      level_extent,
+	                                      VK_FORMAT_R32_SFLOAT,
+	                                      VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+	                                      VMA_MEMORY_USAGE_GPU_ONLY,
+	                                      VK_SAMPLE_COUNT_1_BIT,
+	                                      mip_count);
+
+	for (uint32_t level = 0; level < mip_count; level++)
+	{
+		mip_views.push_back(std::make_unique<core::ImageView>(*image, VK_IMAGE_VIEW_TYPE_2D, VK_FORMAT_UNDEFINED, level, 0, 1, 1));
+	}
+
+	view = std::make_unique<core::ImageView>(*image, VK_IMAGE_VIEW_TYPE_2D);
+}
+
+void HiZPyramid::build(CommandBuffer &command_buffer, const core::ImageView &depth_view)
+{
+	const auto &extent = depth_view.get_image().get_extent();
+	if (!image || extent.width != depth_extent.width || extent.height != depth_extent.height)
+	{
+		if (image)
+		{
+			// Previous frames may still read the pyramid
+			render_context.get_device().wait_idle();
+		}
+		create_pyramid({extent.width, extent.height});
+	}
+
+	ScopedDebugLabel debug_label{command_buffer, "Hi-Z pyramid"};
+
+	// The previous pyramid may still be read by the culling of the previous frame
+	ImageMemoryBarrier write_barrier{};
+	write_barrier.old_layout      = VK_IMAGE_LAYOUT_UNDEFINED;
+	write_barrier.new_layout      = VK_IMAGE_LAYOUT_GENERAL;
+	write_barrier.src_access_mask = 0;
+	write_barrier.dst_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	write_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	write_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	command_buffer.image_memory_barrier(*view, write_barrier);
+
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+	auto &shader_module  = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, downsample_shader);
+
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&shader_module});
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+	command_buffer.set_specialization_constant(0, work_group_size);
+	command_buffer.set_specialization_constant(1, work_group_size);
+
+	const core::ImageView *input_view = &depth_view;
+
+	for (uint32_t level = 0; level < mip_views.size(); level++)
+	{
+		auto &output_view = *mip_views[level];
+
+		command_buffer.bind_image(*input_view, *sampler, 0, 0, 0);
+		command_buffer.bind_image(output_view, 0, 1, 0);
+
+		uint32_t width  = std::max(image->get_extent().width >> level, 1u);
+		uint32_t height = std::max(image->get_extent().height >> level, 1u);
+		command_buffer.dispatch((width + work_group_size - 1) / work_group_size, (height + work_group_size - 1) / work_group_size, 1);
+
+		// The level is the input of the next one
+		ImageMemoryBarrier read_barrier{};
+		read_barrier.old_layout      = VK_IMAGE_LAYOUT_GENERAL;
+		read_barrier.new_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		read_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+		read_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+		read_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		read_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		command_buffer.image_memory_barrier(output_view, read_barrier);
+
+		input_view = &output_view;
+	}
+}
+
+const core::ImageView &HiZPyramid::get_view() const
+{
+	assert(view && "Hi-Z pyramid has not been built");
+	return *view;
+}
+
+const core::Sampler &HiZPyramid::get_sampler() const
+{
+	return *sampler;
+}
+
+const VkExtent2D &HiZPyramid::get_depth_extent() const
+{
+	return depth_extent;
+}
+
+uint32_t HiZPyramid::get_mip_count() const
+{
+	return to_u32(mip_views.size());
+}
+}        // namespace vkb
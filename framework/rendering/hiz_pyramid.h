@@ -0,0 +1,107 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/image.h"
+#include "core/image_view.h"
+#include "core/sampler.h"
+#include "core/shader_module.h"
+
+namespace vkb
+{
+class CommandBuffer;
+class RenderContext;
+
+/**
+ * @brief Hierarchical depth buffer, a mip chain in which every texel holds the farthest
+ *        depth of the texels it covers in the level above, built with a compute downsample.
+ *        Depth is reversed in this framework, so the farthest depth is the minimum.
+ *
+ *        Level 0 is half the size of the depth image. The last texel of a row or column of
+ *        a level also covers the extra texel of an odd sized level above, so the texel of
+ *        level L covering depth pixel p is min(p >> (L + 1), size(L) - 1).
+ */
+class HiZPyramid
+{
+  public:
+	/**
+	 * @param render_context Render context
+	 * @param downsample_shader Compute shader reducing a level into the next one
+	 */
+	HiZPyramid(RenderContext &render_context, ShaderSource &&downsample_shader);
+
+	HiZPyramid(const HiZPyramid &) = delete;
+
+	HiZPyramid(HiZPyramid &&) = delete;
+
+	~HiZPyramid() = default;
+
+	HiZPyramid &operator=(const HiZPyramid &) = delete;
+
+	HiZPyramid &operator=(HiZPyramid &&) = delete;
+
+	/**
+	 * @brief Records the construction of the pyramid from a depth image, recreating the
+	 *        pyramid if the depth extent changed. Compute work cannot be recorded in a render pass.
+	 * @param command_buffer Command buffer to record into
+	 * @param depth_view Depth-only view of the depth image, in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+	 *        and visible to compute shader reads
+	 * After this call every level is in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL and visible to compute shaders.
+	 */
+	void build(CommandBuffer &command_buffer, const core::ImageView &depth_view);
+
+	/**
+	 * @return View of the whole mip chain
+	 */
+	const core::ImageView &get_view() const;
+
+	/**
+	 * @return Nearest sampler, to be used with texelFetch
+	 */
+	const core::Sampler &get_sampler() const;
+
+	/**
+	 * @return Extent of the depth image the pyramid was built from
+	 */
+	const VkExtent2D &get_depth_extent() const;
+
+	uint32_t get_mip_count() const;
+
+  private:
+	void create_pyramid(const VkExtent2D &extent);
+
+	RenderContext &render_context;
+
+	ShaderSource downsample_shader;
+
+	VkExtent2D depth_extent{0, 0};
+
+	std::unique_ptr<core::Image> image;
+
+	/// Single level views written by the downsample
+	std::vector<std::unique_ptr<core::ImageView>> mip_views;
+
+	std::unique_ptr<core::ImageView> view;
+
+	std::unique_ptr<core::Sampler> sampler;
+
+	uint32_t work_group_size{8};
+};
+}        // namespace vkb
@@ -17,6 +17,8 @@
 
 #include "pipeline_state.h"
 
+#include "common/resource_caching.h"
+
 bool operator==(const VkVertexInputAttributeDescription &lhs, const VkVertexInputAttributeDescription &rhs)
 {
 	return std::tie(lhs.binding, lhs.format, lhs.location, lhs.offset) == std::tie(rhs.binding, rhs.format, rhs.location, rhs.offset);
@@ -84,11 +86,136 @@ bool operator!=(const vkb::ColorBlendState &lhs, const vkb::ColorBlendState &rhs
 
 namespace vkb
 {
+namespace
+{
+size_t hash_state(const PipelineLayout *pipeline_layout)
+{
+	size_t result = 0;
+
+	if (pipeline_layout)
+	{
+		hash_combine(result, pipeline_layout->get_handle());
+
+		for (auto shader_module : pipeline_layout->get_shader_modules())
+		{
+			hash_combine(result, shader_module->get_id());
+		}
+	}
+
+	return result;
+}
+
+size_t hash_state(const RenderPass *render_pass)
+{
+	size_t result = 0;
+
+	// For graphics only
+	if (render_pass)
+	{
+		hash_combine(result, render_pass->get_handle());
+	}
+
+	return result;
+}
+
+size_t hash_state(const VertexInputState &vertex_input_state)
+{
+	size_t result = 0;
+
+	for (auto &attribute : vertex_input_state.attributes)
+	{
+		hash_combine(result, attribute);
+	}
+
+	for (auto &binding : vertex_input_state.bindings)
+	{
+		hash_combine(result, binding);
+	}
+
+	return result;
+}
+
+size_t hash_state(const InputAssemblyState &input_assembly_state)
+{
+	size_t result = 0;
+	hash_combine(result, input_assembly_state.primitive_restart_enable);
+	hash_combine(result, static_cast<std::underlying_type<VkPrimitiveTopology>::type>(input_assembly_state.topology));
+	return result;
+}
+
+size_t hash_state(const RasterizationState &rasterization_state)
+{
+	size_t result = 0;
+	hash_combine(result, rasterization_state.cull_mode);
+	hash_combine(result, rasterization_state.depth_bias_enable);
+	hash_combine(result, rasterization_state.depth_clamp_enable);
+	hash_combine(result, static_cast<std::underlying_type<VkFrontFace>::type>(rasterization_state.front_face));
+	hash_combine(result, static_cast<std::underlying_type<VkPolygonMode>::type>(rasterization_state.polygon_mode));
+	hash_combine(result, rasterization_state.rasterizer_discard_enable);
+	return result;
+}
+
+size_t hash_state(const ViewportState &viewport_state)
+{
+	size_t result = 0;
+	hash_combine(result, viewport_state.viewport_count);
+	hash_combine(result, viewport_state.scissor_count);
+	return result;
+}
+
+size_t hash_state(const MultisampleState &multisample_state)
+{
+	size_t result = 0;
+	hash_combine(result, multisample_state.alpha_to_coverage_enable);
+	hash_combine(result, multisample_state.alpha_to_one_enable);
+	hash_combine(result, multisample_state.min_sample_shading);
+	hash_combine(result, static_cast<std::underlying_type<VkSampleCountFlagBits>::type>(multisample_state.rasterization_samples));
+	hash_combine(result, multisample_state.sample_shading_enable);
+	hash_combine(result, multisample_state.sample_mask);
+	return result;
+}
+
+size_t hash_state(const DepthStencilState &depth_stencil_state)
+{
+	size_t result = 0;
+	hash_combine(result, depth_stencil_state.back);
+	hash_combine(result, depth_stencil_state.depth_bounds_test_enable);
+	hash_combine(result, static_cast<std::underlying_type<VkCompareOp>::type>(depth_stencil_state.depth_compare_op));
+	hash_combine(result, depth_stencil_state.depth_test_enable);
+	hash_combine(result, depth_stencil_state.depth_write_enable);
+	hash_combine(result, depth_stencil_state.front);
+	hash_combine(result, depth_stencil_state.stencil_test_enable);
+	return result;
+}
+
+size_t hash_state(const ColorBlendState &color_blend_state)
+{
+	size_t result = 0;
+	hash_combine(result, static_cast<std::underlying_type<VkLogicOp>::type>(color_blend_state.logic_op));
+	hash_combine(result, color_blend_state.logic_op_enable);
+
+	for (auto &attachment : color_blend_state.attachments)
+	{
+		hash_combine(result, attachment);
+	}
+
+	return result;
+}
+
+size_t hash_state(uint32_t subpass_index)
+{
+	size_t result = 0;
+	hash_combine(result, subpass_index);
+	return result;
+}
+}        // namespace
+
 void SpecializationConstantState::reset()
 {
 	if (dirty)
 	{
 		specialization_constant_state.clear();
+		hash = 0;
 	}
 
 	dirty = false;
@@ -104,23 +231,41 @@ void SpecializationConstantState::clear_dirty()
 	dirty = false;
 }
 
-void SpecializationConstantState::set_constant(uint32_t constant_id, const std::vector<uint8_t> &value)
+void SpecializationConstantState::set_constant(uint32_t constant_id, const uint8_t *data, size_t size)
 {
-	auto data = specialization_constant_state.find(constant_id);
+	auto it = specialization_constant_state.find(constant_id);
 
-	if (data != specialization_constant_state.end() && data->second == value)
+	if (it != specialization_constant_state.end() && it->second.size() == size && std::equal(data, data + size, it->second.begin()))
 	{
 		return;
 	}
 
 	dirty = true;
 
-	specialization_constant_state[constant_id] = value;
+	auto &constant = specialization_constant_state[constant_id];
+	if (it != specialization_constant_state.end())
+	{
+		hash ^= hash_constant(constant_id, constant);
+	}
+
+	constant.assign(data, data + size);
+	hash ^= hash_constant(constant_id, constant);
+}
+
+void SpecializationConstantState::set_constant(uint32_t constant_id, const std::vector<uint8_t> &value)
+{
+	set_constant(constant_id, value.data(), value.size());
 }
 
 void SpecializationConstantState::set_specialization_constant_state(const std::map<uint32_t, std::vector<uint8_t>> &state)
 {
 	specialization_constant_state = state;
+
+	hash = 0;
+	for (auto &constant : specialization_constant_state)
+	{
+		hash ^= hash_constant(constant.first, constant.second);
+	}
 }
 
 const std::map<uint32_t, std::vector<uint8_t>> &SpecializationConstantState::get_specialization_constant_state() const
@@ -128,6 +273,27 @@ const std::map<uint32_t, std::vector<uint8_t>> &SpecializationConstantState::get
 	return specialization_constant_state;
 }
 
+size_t SpecializationConstantState::get_hash() const
+{
+	return hash;
+}
+
+size_t SpecializationConstantState::hash_constant(uint32_t constant_id, const std::vector<uint8_t> &data)
+{
+	size_t result = 0;
+	hash_combine(result, constant_id);
+	for (auto byte : data)
+	{
+		hash_combine(result, byte);
+	}
+	return result;
+}
+
+PipelineState::PipelineState()
+{
+	reset_hash();
+}
+
 void PipelineState::reset()
 {
 	clear_dirty();
@@ -151,6 +317,8 @@ void PipelineState::reset()
 	color_blend_state = {};
 
 	subpass_index = {0U};
+
+	reset_hash();
 }
 
 void PipelineState::set_pipeline_layout(PipelineLayout &new_pipeline_layout)
@@ -161,6 +329,8 @@ void PipelineState::set_pipeline_layout(PipelineLayout &new_pipeline_layout)
 		{
 			pipeline_layout = &new_pipeline_layout;
 
+			update_hash(PipelineLayoutPart, hash_state(pipeline_layout));
+
 			dirty = true;
 		}
 	}
@@ -168,6 +338,8 @@ void PipelineState::set_pipeline_layout(PipelineLayout &new_pipeline_layout)
 	{
 		pipeline_layout = &new_pipeline_layout;
 
+		update_hash(PipelineLayoutPart, hash_state(pipeline_layout));
+
 		dirty = true;
 	}
 }
@@ -180,6 +352,8 @@ void PipelineState::set_render_pass(const RenderPass &new_render_pass)
 		{
 			render_pass = &new_render_pass;
 
+			update_hash(RenderPassPart, hash_state(render_pass));
+
 			dirty = true;
 		}
 	}
@@ -187,13 +361,15 @@ void PipelineState::set_render_pass(const RenderPass &new_render_pass)
 	{
 		render_pass = &new_render_pass;
 
+		update_hash(RenderPassPart, hash_state(render_pass));
+
 		dirty = true;
 	}
 }
 
-void PipelineState::set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data)
+void PipelineState::set_specialization_constant(uint32_t constant_id, const uint8_t *data, size_t size)
 {
-	specialization_constant_state.set_constant(constant_id, data);
+	specialization_constant_state.set_constant(constant_id, data, size);
 
 	if (specialization_constant_state.is_dirty())
 	{
@@ -201,12 +377,19 @@ void PipelineState::set_specialization_constant(uint32_t constant_id, const std:
 	}
 }
 
+void PipelineState::set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data)
+{
+	set_specialization_constant(constant_id, data.data(), data.size());
+}
+
 void PipelineState::set_vertex_input_state(const VertexInputState &new_vertex_input_state)
 {
 	if (vertex_input_state != new_vertex_input_state)
 	{
 		vertex_input_state = new_vertex_input_state;
 
+		update_hash(VertexInputPart, hash_state(vertex_input_state));
+
 		dirty = true;
 	}
 }
@@ -217,6 +400,8 @@ void PipelineState::set_input_assembly_state(const InputAssemblyState &new_input
 	{
 		input_assembly_state = new_input_assembly_state;
 
+		update_hash(InputAssemblyPart, hash_state(input_assembly_state));
+
 		dirty = true;
 	}
 }
@@ -227,6 +412,8 @@ void PipelineState::set_rasterization_state(const RasterizationState &new_raster
 	{
 		rasterization_state = new_rasterization_state;
 
+		update_hash(RasterizationPart, hash_state(rasterization_state));
+
 		dirty = true;
 	}
 }
@@ -237,6 +424,8 @@ void PipelineState::set_viewport_state(const ViewportState &new_viewport_state)
 	{
 		viewport_state = new_viewport_state;
 
+		update_hash(ViewportPart, hash_state(viewport_state));
+
 		dirty = true;
 	}
 }
@@ -247,6 +436,8 @@ void PipelineState::set_multisample_state(const MultisampleState &new_multisampl
 	{
 		multisample_state = new_multisample_state;
 
+		update_hash(MultisamplePart, hash_state(multisample_state));
+
 		dirty = true;
 	}
 }
@@ -257,6 +448,8 @@ void PipelineState::set_depth_stencil_state(const DepthStencilState &new_depth_s
 	{
 		depth_stencil_state = new_depth_stencil_state;
 
+		update_hash(DepthStencilPart, hash_state(depth_stencil_state));
+
 		dirty = true;
 	}
 }
@@ -267,6 +460,8 @@ void PipelineState::set_color_blend_state(const ColorBlendState &new_color_blend
 	{
 		color_blend_state = new_color_blend_state;
 
+		update_hash(ColorBlendPart, hash_state(color_blend_state));
+
 		dirty = true;
 	}
 }
@@ -277,6 +472,8 @@ void PipelineState::set_subpass_index(uint32_t new_subpass_index)
 	{
 		subpass_index = new_subpass_index;
 
+		update_hash(SubpassIndexPart, hash_state(subpass_index));
+
 		dirty = true;
 	}
 }
@@ -347,4 +544,37 @@ void PipelineState::clear_dirty()
 	dirty = false;
 	specialization_constant_state.clear_dirty();
 }
+
+size_t PipelineState::get_hash() const
+{
+	size_t result = hash;
+	hash_combine(result, specialization_constant_state.get_hash());
+	return result;
+}
+
+void PipelineState::update_hash(HashPart part, size_t part_hash)
+{
+	// Salted with the part, so that equal hashes of different states do not cancel out
+	hash_combine(part_hash, static_cast<uint32_t>(part));
+
+	hash ^= part_hashes[part] ^ part_hash;
+	part_hashes[part] = part_hash;
+}
+
+void PipelineState::reset_hash()
+{
+	hash = 0;
+	part_hashes.fill(0);
+
+	update_hash(PipelineLayoutPart, hash_state(pipeline_layout));
+	update_hash(RenderPassPart, hash_state(render_pass));
+	update_hash(VertexInputPart, hash_state(vertex_input_state));
+	update_hash(InputAssemblyPart, hash_state(input_assembly_state));
+	update_hash(RasterizationPart, hash_state(rasterization_state));
+	update_hash(ViewportPart, hash_state(viewport_state));
+	update_hash(MultisamplePart, hash_state(multisample_state));
+	update_hash(DepthStencilPart, hash_state(depth_stencil_state));
+	update_hash(ColorBlendPart, hash_state(color_blend_state));
+	update_hash(SubpassIndexPart, hash_state(subpass_index));
+}
 }        // namespace vkb
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <array>
 #include <vector>
 
 #include "common/vk_common.h"
@@ -146,39 +147,60 @@ class SpecializationConstantState
 	template <class T>
 	void set_constant(uint32_t constant_id, const T &data);
 
+	/**
+	 * @brief Sets the bytes of a constant, only reallocating its storage when its size changes
+	 */
+	void set_constant(uint32_t constant_id, const uint8_t *data, size_t size);
+
 	void set_constant(uint32_t constant_id, const std::vector<uint8_t> &data);
 
 	void set_specialization_constant_state(const std::map<uint32_t, std::vector<uint8_t>> &state);
 
 	const std::map<uint32_t, std::vector<uint8_t>> &get_specialization_constant_state() const;
 
+	/**
+	 * @return Hash of the constants, maintained as they are set
+	 */
+	size_t get_hash() const;
+
   private:
+	static size_t hash_constant(uint32_t constant_id, const std::vector<uint8_t> &data);
+
 	bool dirty{false};
 	// Map tracking state of the Specialization Constants
 	std::map<uint32_t, std::vector<uint8_t>> specialization_constant_state;
+
+	/// Xor of the hashes of the constants, so that a constant is replaced without rehashing the others
+	size_t hash{0};
 };
 
 template <class T>
 inline void SpecializationConstantState::set_constant(std::uint32_t constant_id, const T &data)
 {
-	set_constant(constant_id, to_bytes(static_cast<std::uint32_t>(data)));
+	auto value = static_cast<std::uint32_t>(data);
+	set_constant(constant_id, reinterpret_cast<const uint8_t *>(&value), sizeof(value));
 }
 
 template <>
 inline void SpecializationConstantState::set_constant<bool>(std::uint32_t constant_id, const bool &data)
 {
-	set_constant(constant_id, to_bytes(static_cast<std::uint32_t>(data)));
+	auto value = static_cast<std::uint32_t>(data);
+	set_constant(constant_id, reinterpret_cast<const uint8_t *>(&value), sizeof(value));
 }
 
 class PipelineState
 {
   public:
+	PipelineState();
+
 	void reset();
 
 	void set_pipeline_layout(PipelineLayout &pipeline_layout);
 
 	void set_render_pass(const RenderPass &render_pass);
 
+	void set_specialization_constant(uint32_t constant_id, const uint8_t *data, size_t size);
+
 	void set_specialization_constant(uint32_t constant_id, const std::vector<uint8_t> &data);
 
 	void set_vertex_input_state(const VertexInputState &vertex_input_state);
@@ -223,9 +245,48 @@ class PipelineState
 
 	void clear_dirty();
 
+	/**
+	 * @return Hash of the whole state, maintained as the states are set so that
+	 *         looking the pipeline up does not walk the state
+	 */
+	size_t get_hash() const;
+
   private:
+	/**
+	 * @brief States hashed separately, a state only being rehashed when it changes
+	 */
+	enum HashPart
+	{
+		PipelineLayoutPart,
+		RenderPassPart,
+		VertexInputPart,
+		InputAssemblyPart,
+		RasterizationPart,
+		ViewportPart,
+		MultisamplePart,
+		DepthStencilPart,
+		ColorBlendPart,
+		SubpassIndexPart,
+		HashPartCount
+	};
+
+	/**
+	 * @brief Replaces the hash of a state in the hash of the pipeline state
+	 */
+	void update_hash(HashPart part, size_t part_hash);
+
+	/**
+	 * @brief Hashes every state again
+	 */
+	void reset_hash();
+
 	bool dirty{false};
 
+	/// Xor of the hashes of the states
+	size_t hash{0};
+
+	std::array<size_t, HashPartCount> part_hashes{};
+
 	PipelineLayout *pipeline_layout{nullptr};
 
 	const RenderPass *render_pass{nullptr};
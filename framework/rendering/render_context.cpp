@@ -426,7 +426,8 @@ void RenderContext::end_frame(VkSemaphore semaphore)
 		release_owned_semaphore(acquired_semaphore);
 		acquired_semaphore = VK_NULL_HANDLE;
 	}
-	frame_active = false;
+	last_rendered_frame_index = active_frame_index;
+	frame_active              = false;
 }
 
 VkSemaphore RenderContext::consume_acquired_semaphore()
@@ -457,6 +458,11 @@ RenderFrame &RenderContext::get_last_rendered_frame()
 	return *frames[active_frame_index];
 }
 
+uint32_t RenderContext::get_last_rendered_frame_index() const
+{
+	return last_rendered_frame_index;
+}
+
 VkSemaphore RenderContext::request_semaphore()
 {
 	RenderFrame &frame = get_active_frame();
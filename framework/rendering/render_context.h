@@ -195,6 +195,12 @@ class RenderContext
 	 */
 	RenderFrame &get_last_rendered_frame();
 
+	/**
+	 * @brief Can be called whether a frame is active or not, unlike @ref get_last_rendered_frame
+	 * @return The index of the frame ended last
+	 */
+	uint32_t get_last_rendered_frame_index() const;
+
 	VkSemaphore request_semaphore();
 	VkSemaphore request_semaphore_with_ownership();
 	void        release_owned_semaphore(VkSemaphore semaphore);
@@ -249,6 +255,9 @@ class RenderContext
 	/// Current active frame index
 	uint32_t active_frame_index{0};
 
+	/// Index of the frame ended last
+	uint32_t last_rendered_frame_index{0};
+
 	/// Whether a frame is active or not
 	bool frame_active{false};
 
@@ -22,6 +22,24 @@
 
 namespace vkb
 {
+namespace
+{
+struct SupportedUsage
+{
+	VkBufferUsageFlags usage;
+
+	/// Multiplier for the BUFFER_POOL_BLOCK_SIZE
+	uint32_t size_multiplier;
+};
+
+// Indexed by RenderFrame::get_usage_index
+constexpr SupportedUsage supported_usages[] = {
+    {VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 1},
+    {VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 2},        // x2 the size of BUFFER_POOL_BLOCK_SIZE since SSBOs are normally much larger than other types of buffers
+    {VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 1},
+    {VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 1}};
+}        // namespace
+
 RenderFrame::RenderFrame(Device &device, std::unique_ptr<RenderTarget> &&render_target, size_t thread_count) :
     device{device},
     fence_pool{device},
@@ -29,26 +47,23 @@ RenderFrame::RenderFrame(Device &device, std::unique_ptr<RenderTarget> &&render_
     swapchain_render_target{std::move(render_target)},
     thread_count{thread_count}
 {
-	for (auto &usage_it : supported_usage_map)
+	for (auto &supported_usage : supported_usages)
 	{
-		std::vector<std::pair<BufferPool, BufferBlock *>> usage_buffer_pools;
-		for (size_t i = 0; i < thread_count; ++i)
-		{
-			usage_buffer_pools.push_back(std::make_pair(BufferPool{device, BUFFER_POOL_BLOCK_SIZE * 1024 * usage_it.second, usage_it.first}, nullptr));
-		}
+		VkDeviceSize block_size = BUFFER_POOL_BLOCK_SIZE * 1024 * supported_usage.size_multiplier;
 
-		auto res_ins_it = buffer_pools.emplace(usage_it.first, std::move(usage_buffer_pools));
+		// The threads share the ring of a usage, which starts from a single block and grows to the high watermark
+		buffer_rings.push_back(std::make_unique<BufferRing>(device, block_size, supported_usage.usage));
 
-		if (!res_ins_it.second)
+		for (size_t i = 0; i < thread_count; ++i)
 		{
-			throw std::runtime_error("Failed to insert buffer pool");
+			buffer_pools.push_back(std::make_unique<BufferPool>(device, block_size, supported_usage.usage));
 		}
 	}
 
 	for (size_t i = 0; i < thread_count; ++i)
 	{
 		descriptor_pools.push_back(std::make_unique<std::unordered_map<std::size_t, DescriptorPool>>());
-		descriptor_sets.push_back(std::make_unique<std::unordered_map<std::size_t, DescriptorSet>>());
+		descriptor_sets.push_back(std::make_unique<ThreadDescriptorSets>());
 	}
 }
 
@@ -76,21 +91,63 @@ void RenderFrame::reset()
 		}
 	}
 
-	for (auto &buffer_pools_per_usage : buffer_pools)
+	bool buffers_replaced = false;
+	for (auto &buffer_ring : buffer_rings)
 	{
-		for (auto &buffer_pool : buffer_pools_per_usage.second)
-		{
-			buffer_pool.first.reset();
-			buffer_pool.second = nullptr;
-		}
+		buffers_replaced |= buffer_ring->reset();
+	}
+
+	for (auto &buffer_pool : buffer_pools)
+	{
+		buffer_pool->reset();
 	}
 
 	semaphore_pool.reset();
 
-	if (descriptor_management_strategy == vkb::DescriptorManagementStrategy::CreateDirectly)
+	use_count++;
+
+	descriptor_set_eviction_count = 0;
+
+	// Cached descriptor sets may refer to the destroyed buffers, whose handles a new buffer may reuse
+	if (descriptor_management_strategy == vkb::DescriptorManagementStrategy::CreateDirectly || buffers_replaced)
 	{
 		clear_descriptors();
 	}
+	else
+	{
+		evict_descriptor_sets();
+	}
+
+	for (auto &thread_descriptor_sets : descriptor_sets)
+	{
+		thread_descriptor_sets->hit_count  = 0;
+		thread_descriptor_sets->miss_count = 0;
+	}
+}
+
+void RenderFrame::evict_descriptor_sets()
+{
+	// The fence of the frame was waited on, so the GPU is done with the descriptor sets of the frame
+	for (auto &thread_descriptor_sets : descriptor_sets)
+	{
+		auto &cached_descriptor_sets = thread_descriptor_sets->descriptor_sets;
+		for (auto it = cached_descriptor_sets.begin(); it != cached_descriptor_sets.end();)
+		{
+			if (use_count - it->second.last_use > descriptor_set_max_age)
+			{
+				auto &descriptor_set = it->second.descriptor_set;
+				descriptor_set.get_descriptor_pool().free(descriptor_set.get_handle());
+
+				it = cached_descriptor_sets.erase(it);
+
+				descriptor_set_eviction_count++;
+			}
+			else
+			{
+				++it;
+			}
+		}
+	}
 }
 
 std::vector<std::unique_ptr<CommandPool>> &RenderFrame::get_command_pools(const Queue &queue, CommandBuffer::ResetMode reset_mode)
@@ -205,6 +262,15 @@ CommandBuffer &RenderFrame::request_command_buffer(const Queue &queue, CommandBu
 }
 
 VkDescriptorSet RenderFrame::request_descriptor_set(const DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos, bool update_after_bind, size_t thread_index)
+{
+	// The descriptor pool only depends on the layout, it is left out of the hash
+	size_t hash{0U};
+	hash_param(hash, descriptor_set_layout, buffer_infos, image_infos);
+
+	return request_descriptor_set(descriptor_set_layout, hash, buffer_infos, image_infos, update_after_bind, thread_index);
+}
+
+VkDescriptorSet RenderFrame::request_descriptor_set(const DescriptorSetLayout &descriptor_set_layout, size_t hash, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos, bool update_after_bind, size_t thread_index)
 {
 	assert(thread_index < thread_count && "Thread index is out of bounds");
 
@@ -222,7 +288,23 @@ VkDescriptorSet RenderFrame::request_descriptor_set(const DescriptorSetLayout &d
 
 		// Request a descriptor set from the render frame, and write the buffer infos and image infos of all the specified bindings
 		assert(thread_index < descriptor_sets.size());
-		auto &descriptor_set = request_resource(device, nullptr, *descriptor_sets[thread_index], descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+		auto &thread_descriptor_sets = *descriptor_sets[thread_index];
+
+		auto descriptor_set_it = thread_descriptor_sets.descriptor_sets.find(hash);
+		if (descriptor_set_it == thread_descriptor_sets.descriptor_sets.end())
+		{
+			descriptor_set_it = thread_descriptor_sets.descriptor_sets.emplace(hash, CachedDescriptorSet{DescriptorSet{device, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos}, use_count}).first;
+
+			thread_descriptor_sets.miss_count++;
+		}
+		else
+		{
+			descriptor_set_it->second.last_use = use_count;
+
+			thread_descriptor_sets.hit_count++;
+		}
+
+		auto &descriptor_set = descriptor_set_it->second.descriptor_set;
 		descriptor_set.update(bindings_to_update);
 		return descriptor_set.get_handle();
 	}
@@ -231,17 +313,43 @@ VkDescriptorSet RenderFrame::request_descriptor_set(const DescriptorSetLayout &d
 		// Request a descriptor pool, allocate a descriptor set, write buffer and image data to it
 		DescriptorSet descriptor_set{device, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos};
 		descriptor_set.apply_writes();
+
+		descriptor_sets[thread_index]->miss_count++;
 		return descriptor_set.get_handle();
 	}
 }
 
+VkDescriptorSet RenderFrame::find_descriptor_set(size_t hash, size_t thread_index)
+{
+	if (descriptor_management_strategy != DescriptorManagementStrategy::StoreInCache)
+	{
+		return VK_NULL_HANDLE;
+	}
+
+	assert(thread_index < descriptor_sets.size());
+	auto &thread_descriptor_sets = *descriptor_sets[thread_index];
+
+	auto descriptor_set_it = thread_descriptor_sets.descriptor_sets.find(hash);
+	if (descriptor_set_it == thread_descriptor_sets.descriptor_sets.end())
+	{
+		// Counted as a miss when the descriptor set is requested
+		return VK_NULL_HANDLE;
+	}
+
+	descriptor_set_it->second.last_use = use_count;
+
+	thread_descriptor_sets.hit_count++;
+
+	return descriptor_set_it->second.descriptor_set.get_handle();
+}
+
 void RenderFrame::update_descriptor_sets(size_t thread_index)
 {
 	assert(thread_index < descriptor_sets.size());
 	auto &thread_descriptor_sets = *descriptor_sets[thread_index];
-	for (auto &descriptor_set_it : thread_descriptor_sets)
+	for (auto &descriptor_set_it : thread_descriptor_sets.descriptor_sets)
 	{
-		descriptor_set_it.second.update();
+		descriptor_set_it.second.descriptor_set.update();
 	}
 }
 
@@ -249,7 +357,7 @@ void RenderFrame::clear_descriptors()
 {
 	for (auto &desc_sets_per_thread : descriptor_sets)
 	{
-		desc_sets_per_thread->clear();
+		desc_sets_per_thread->descriptor_sets.clear();
 	}
 
 	for (auto &desc_pools_per_thread : descriptor_pools)
@@ -261,6 +369,31 @@ void RenderFrame::clear_descriptors()
 	}
 }
 
+void RenderFrame::set_descriptor_set_max_age(uint32_t max_age)
+{
+	descriptor_set_max_age = max_age;
+}
+
+DescriptorSetCacheStats RenderFrame::get_descriptor_set_cache_stats() const
+{
+	DescriptorSetCacheStats stats;
+	stats.evictions = descriptor_set_eviction_count;
+
+	for (auto &thread_descriptor_sets : descriptor_sets)
+	{
+		stats.hits += thread_descriptor_sets->hit_count;
+		stats.misses += thread_descriptor_sets->miss_count;
+		stats.cached += to_u32(thread_descriptor_sets->descriptor_sets.size());
+	}
+
+	return stats;
+}
+
+uint32_t RenderFrame::get_descriptor_set_allocation_count() const
+{
+	return get_descriptor_set_cache_stats().misses;
+}
+
 void RenderFrame::set_buffer_allocation_strategy(BufferAllocationStrategy new_strategy)
 {
 	buffer_allocation_strategy = new_strategy;
@@ -275,27 +408,38 @@ BufferAllocation RenderFrame::allocate_buffer(const VkBufferUsageFlags usage, co
 {
 	assert(thread_index < thread_count && "Thread index is out of bounds");
 
-	// Find a pool for this usage
-	auto buffer_pool_it = buffer_pools.find(usage);
-	if (buffer_pool_it == buffer_pools.end())
+	int usage_index = get_usage_index(usage);
+	if (usage_index < 0)
 	{
 		LOGE("No buffer pool for buffer usage {}", usage);
 		return BufferAllocation{};
 	}
 
-	assert(thread_index < buffer_pool_it->second.size());
-	auto &buffer_pool  = buffer_pool_it->second[thread_index].first;
-	auto &buffer_block = buffer_pool_it->second[thread_index].second;
+	if (buffer_allocation_strategy == BufferAllocationStrategy::OneAllocationPerBuffer)
+	{
+		// Request a dedicated buffer block for each allocation
+		auto &buffer_pool = *buffer_pools[usage_index * thread_count + thread_index];
+		return buffer_pool.request_buffer_block(size, true).allocate(to_u32(size));
+	}
 
-	bool want_minimal_block = buffer_allocation_strategy == BufferAllocationStrategy::OneAllocationPerBuffer;
+	return buffer_rings[usage_index]->allocate(size);
+}
+
+VkDeviceSize RenderFrame::get_buffer_high_watermark(VkBufferUsageFlags usage) const
+{
+	int usage_index = get_usage_index(usage);
+	return usage_index < 0 ? 0 : buffer_rings[usage_index]->get_high_watermark();
+}
 
-	if (want_minimal_block || !buffer_block || !buffer_block->can_allocate(size))
+int RenderFrame::get_usage_index(VkBufferUsageFlags usage)
+{
+	for (int i = 0; i < static_cast<int>(sizeof(supported_usages) / sizeof(supported_usages[0])); i++)
 	{
-		// If we are creating a buffer for each allocation of there is no block associated with the pool or the current block is too small
-		// for this allocation, request a new buffer block
-		buffer_block = &buffer_pool.request_buffer_block(size, want_minimal_block);
+		if (supported_usages[i].usage == usage)
+		{
+			return i;
+		}
 	}
-
-	return buffer_block->allocate(to_u32(size));
+	return -1;
 }
 }        // namespace vkb
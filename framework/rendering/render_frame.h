@@ -47,7 +47,25 @@ enum DescriptorManagementStrategy
 };
 
 /**
- * @brief RenderFrame is a container for per-frame data, including BufferPool objects,
+ * @brief Counters of the descriptor sets of a frame since it was last reset
+ */
+struct DescriptorSetCacheStats
+{
+	/// Requests finding a cached descriptor set
+	uint32_t hits{0};
+
+	/// Requests allocating a descriptor set
+	uint32_t misses{0};
+
+	/// Descriptor sets evicted by the last reset, as they were not requested recently
+	uint32_t evictions{0};
+
+	/// Descriptor sets cached
+	uint32_t cached{0};
+};
+
+/**
+ * @brief RenderFrame is a container for per-frame data, including BufferRing objects,
  * synchronization primitives (semaphores, fences) and the swapchain RenderTarget.
  *
  * When creating a RenderTarget, we need to provide images that will be used as attachments
@@ -63,16 +81,14 @@ class RenderFrame
 {
   public:
 	/**
-	 * @brief Block size of a buffer pool in kilobytes
+	 * @brief Initial size of the buffer ring of a usage in kilobytes, shared by the threads recording the frame
 	 */
 	static constexpr uint32_t BUFFER_POOL_BLOCK_SIZE = 256;
 
-	// A map of the supported usages to a multiplier for the BUFFER_POOL_BLOCK_SIZE
-	const std::unordered_map<VkBufferUsageFlags, uint32_t> supported_usage_map = {
-	    {VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 1},
-	    {VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, 2},        // x2 the size of BUFFER_POOL_BLOCK_SIZE since SSBOs are normally much larger than other types of buffers
-	    {VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, 1},
-	    {VK_BUFFER_USAGE_INDEX_BUFFER_BIT, 1}};
+	/**
+	 * @brief Default number of uses of the frame a cached descriptor set is kept without being requested
+	 */
+	static constexpr uint32_t DESCRIPTOR_SET_MAX_AGE = 8;
 
 	RenderFrame(Device &device, std::unique_ptr<RenderTarget> &&render_target, size_t thread_count = 1);
 
@@ -129,8 +145,43 @@ class RenderFrame
 	                                       bool                                      update_after_bind,
 	                                       size_t                                    thread_index = 0);
 
+	/**
+	 * @brief Requests a descriptor set keyed by a hash of its layout and bindings maintained by the caller,
+	 *        instead of a hash of its infos
+	 * @param hash Hash identifying the layout and the bindings of the descriptor set
+	 */
+	VkDescriptorSet request_descriptor_set(const DescriptorSetLayout &               descriptor_set_layout,
+	                                       size_t                                    hash,
+	                                       const BindingMap<VkDescriptorBufferInfo> &buffer_infos,
+	                                       const BindingMap<VkDescriptorImageInfo> & image_infos,
+	                                       bool                                      update_after_bind,
+	                                       size_t                                    thread_index = 0);
+
+	/**
+	 * @brief Looks up a descriptor set requested earlier with the same hash, so that its infos are only built when it is missing
+	 * @return The descriptor set, VK_NULL_HANDLE if it is missing or if descriptor sets are not cached
+	 */
+	VkDescriptorSet find_descriptor_set(size_t hash, size_t thread_index = 0);
+
 	void clear_descriptors();
 
+	/**
+	 * @brief Sets the number of uses of the frame a cached descriptor set is kept without being requested,
+	 *        after which the frame reset returns it to its pool
+	 */
+	void set_descriptor_set_max_age(uint32_t max_age);
+
+	/**
+	 * @brief The counters are updated without synchronization by the threads recording the frame,
+	 *        they must be read once the frame is recorded
+	 */
+	DescriptorSetCacheStats get_descriptor_set_cache_stats() const;
+
+	/**
+	 * @return Number of descriptor sets allocated since the frame was last reset, by any thread
+	 */
+	uint32_t get_descriptor_set_allocation_count() const;
+
 	/**
 	 * @brief Sets a new buffer allocation strategy
 	 * @param new_strategy The new buffer allocation strategy
@@ -144,13 +195,20 @@ class RenderFrame
 	void set_descriptor_management_strategy(DescriptorManagementStrategy new_strategy);
 
 	/**
+	 * @brief Allocates from the buffer ring of the usage, a single ring shared by the threads recording the frame,
+	 *        which may call it concurrently
 	 * @param usage Usage of the buffer
 	 * @param size Amount of memory required
-	 * @param thread_index Index of the buffer pool to be used by the current thread
+	 * @param thread_index Index of the current thread, selecting its own buffer pool with the OneAllocationPerBuffer strategy
 	 * @return The requested allocation, it may be empty
 	 */
 	BufferAllocation allocate_buffer(VkBufferUsageFlags usage, VkDeviceSize size, size_t thread_index = 0);
 
+	/**
+	 * @return Largest number of bytes allocated in a use of the frame for a usage, 0 if the usage is not supported
+	 */
+	VkDeviceSize get_buffer_high_watermark(VkBufferUsageFlags usage) const;
+
 	/**
 	 * @brief Updates all the descriptor sets in the current frame at a specific thread index
 	 */
@@ -174,8 +232,38 @@ class RenderFrame
 	/// Descriptor pools for the frame
 	std::vector<std::unique_ptr<std::unordered_map<std::size_t, DescriptorPool>>> descriptor_pools;
 
+	struct CachedDescriptorSet
+	{
+		DescriptorSet descriptor_set;
+
+		/// Use of the frame the descriptor set was last requested in
+		uint32_t last_use;
+	};
+
+	/// Descriptor sets of a thread, with the counters it updates as it requests them
+	struct ThreadDescriptorSets
+	{
+		std::unordered_map<std::size_t, CachedDescriptorSet> descriptor_sets;
+
+		uint32_t hit_count{0};
+
+		uint32_t miss_count{0};
+	};
+
 	/// Descriptor sets for the frame
-	std::vector<std::unique_ptr<std::unordered_map<std::size_t, DescriptorSet>>> descriptor_sets;
+	std::vector<std::unique_ptr<ThreadDescriptorSets>> descriptor_sets;
+
+	/// Incremented each time the frame is reset
+	uint32_t use_count{0};
+
+	uint32_t descriptor_set_max_age{DESCRIPTOR_SET_MAX_AGE};
+
+	uint32_t descriptor_set_eviction_count{0};
+
+	/**
+	 * @brief Returns the descriptor sets not requested for more than the max age to their pools
+	 */
+	void evict_descriptor_sets();
 
 	FencePool fence_pool;
 
@@ -188,7 +276,16 @@ class RenderFrame
 	BufferAllocationStrategy     buffer_allocation_strategy{BufferAllocationStrategy::MultipleAllocationsPerBuffer};
 	DescriptorManagementStrategy descriptor_management_strategy{DescriptorManagementStrategy::StoreInCache};
 
-	std::map<VkBufferUsageFlags, std::vector<std::pair<BufferPool, BufferBlock *>>> buffer_pools;
+	/// Allocators of the supported usages, indexed by get_usage_index
+	std::vector<std::unique_ptr<BufferRing>> buffer_rings;
+
+	/// Pools of the OneAllocationPerBuffer strategy, per supported usage then per thread
+	std::vector<std::unique_ptr<BufferPool>> buffer_pools;
+
+	/**
+	 * @return Index of a supported usage, -1 if the usage is not supported
+	 */
+	static int get_usage_index(VkBufferUsageFlags usage);
 
 	static std::vector<uint32_t> collect_bindings_to_update(const DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos);
 };
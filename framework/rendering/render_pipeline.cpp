@@ -79,6 +79,24 @@ void RenderPipeline::set_clear_value(const std::vector<VkClearValue> &cv)
 }
 
 void RenderPipeline::draw(CommandBuffer &command_buffer, RenderTarget &render_target, VkSubpassContents contents)
+{
+	draw_subpasses(command_buffer, render_target, contents, nullptr);
+}
+
+void RenderPipeline::draw(CommandBuffer &command_buffer, RenderTarget &render_target, std::vector<CommandBuffer *> &secondary_command_buffers)
+{
+	draw_subpasses(command_buffer, render_target, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, &secondary_command_buffers);
+}
+
+void RenderPipeline::begin_secondary(CommandBuffer &command_buffer, RenderTarget &render_target)
+{
+	auto &render_pass = command_buffer.get_render_pass(render_target, load_store, subpasses);
+	auto &framebuffer = command_buffer.get_device().get_resource_cache().request_framebuffer(render_target, render_pass);
+
+	command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &render_pass, &framebuffer, 0);
+}
+
+void RenderPipeline::draw_subpasses(CommandBuffer &command_buffer, RenderTarget &render_target, VkSubpassContents contents, std::vector<CommandBuffer *> *secondary_command_buffers)
 {
 	assert(!subpasses.empty() && "Render pipeline should contain at least one sub-pass");
 
@@ -103,12 +121,36 @@ void RenderPipeline::draw(CommandBuffer &command_buffer, RenderTarget &render_ta
 		else
 		{
 			command_buffer.next_subpass();
+
+			if (i == 1 && secondary_command_buffers)
+			{
+				// Dynamic state is undefined after secondary command buffers are executed,
+				// the next subpasses draw to the whole render target
+				VkViewport viewport{};
+				viewport.width    = static_cast<float>(render_target.get_extent().width);
+				viewport.height   = static_cast<float>(render_target.get_extent().height);
+				viewport.minDepth = 0.0f;
+				viewport.maxDepth = 1.0f;
+				command_buffer.set_viewport(0, {viewport});
+
+				VkRect2D scissor{};
+				scissor.extent = render_target.get_extent();
+				command_buffer.set_scissor(0, {scissor});
+			}
 		}
 
 		if (subpass->get_debug_name().empty())
 		{
 			subpass->set_debug_name(fmt::format("RP subpass #{}", i));
 		}
+
+		if (i == 0 && secondary_command_buffers)
+		{
+			// Nothing but the execution of the secondary command buffers can be recorded in the subpass
+			command_buffer.execute_commands(*secondary_command_buffers);
+			continue;
+		}
+
 		ScopedDebugLabel subpass_debug_label{command_buffer, subpass->get_debug_name().c_str()};
 
 		subpass->draw(command_buffer);
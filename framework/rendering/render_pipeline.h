@@ -89,6 +89,22 @@ class RenderPipeline
 	 */
 	void draw(CommandBuffer &command_buffer, RenderTarget &render_target, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 
+	/**
+	 * @brief Record draw commands for each Subpass, except the first one which executes secondary command buffers.
+	 *        The viewport and scissor of the next subpasses are reset to the whole render target.
+	 * @param secondary_command_buffers Commands of the first subpass, begun with begin_secondary
+	 */
+	void draw(CommandBuffer &command_buffer, RenderTarget &render_target, std::vector<CommandBuffer *> &secondary_command_buffers);
+
+	/**
+	 * @brief Begins a secondary command buffer continuing the first subpass, so that it can be recorded
+	 *        concurrently with other command buffers. Dynamic state such as the viewport and scissor
+	 *        is not inherited from the primary command buffer and has to be set again.
+	 * @param command_buffer Secondary command buffer to begin
+	 * @param render_target Render target the pipeline will be drawn to
+	 */
+	void begin_secondary(CommandBuffer &command_buffer, RenderTarget &render_target);
+
 	/**
 	 * @return Subpass currently being recorded, or the first one
 	 *         if drawing has not started
@@ -96,6 +112,8 @@ class RenderPipeline
 	std::unique_ptr<Subpass> &get_active_subpass();
 
   private:
+	void draw_subpasses(CommandBuffer &command_buffer, RenderTarget &render_target, VkSubpassContents contents, std::vector<CommandBuffer *> *secondary_command_buffers);
+
 	std::vector<std::unique_ptr<Subpass>> subpasses;
 
 	/// Default to two load store
@@ -54,18 +54,34 @@ const RenderTarget::CreateFunc RenderTarget::DEFAULT_CREATE_FUNC = [](core::Imag
 };
 
 vkb::RenderTarget::RenderTarget(std::vector<core::Image> &&images) :
-    device{images.back().get_device()},
-    images{std::move(images)}
+    RenderTarget{std::move(images), {}}
 {
-	assert(!this->images.empty() && "Should specify at least 1 image");
+}
+
+vkb::RenderTarget::RenderTarget(std::vector<core::Image> &&images, std::vector<std::shared_ptr<core::Image>> &&shared_images) :
+    device{images.empty() ? shared_images.back()->get_device() : images.back().get_device()},
+    images{std::move(images)},
+    shared_images{std::move(shared_images)}
+{
+	assert(!(this->images.empty() && this->shared_images.empty()) && "Should specify at least 1 image");
+
+	std::vector<core::Image *> all_images;
+	for (auto &image : this->images)
+	{
+		all_images.push_back(&image);
+	}
+	for (auto &image : this->shared_images)
+	{
+		all_images.push_back(image.get());
+	}
 
 	std::set<VkExtent2D, CompareExtent2D> unique_extent;
 
 	// Returns the image extent as a VkExtent2D structure from a VkExtent3D
-	auto get_image_extent = [](const core::Image &image) { return VkExtent2D{image.get_extent().width, image.get_extent().height}; };
+	auto get_image_extent = [](const core::Image *image) { return VkExtent2D{image->get_extent().width, image->get_extent().height}; };
 
 	// Constructs a set of unique image extents given a vector of images
-	std::transform(this->images.begin(), this->images.end(), std::inserter(unique_extent, unique_extent.end()), get_image_extent);
+	std::transform(all_images.begin(), all_images.end(), std::inserter(unique_extent, unique_extent.end()), get_image_extent);
 
 	// Allow only one extent size for a render target
 	if (unique_extent.size() != 1)
@@ -75,16 +91,16 @@ vkb::RenderTarget::RenderTarget(std::vector<core::Image> &&images) :
 
 	extent = *unique_extent.begin();
 
-	for (auto &image : this->images)
+	for (auto image : all_images)
 	{
-		if (image.get_type() != VK_IMAGE_TYPE_2D)
+		if (image->get_type() != VK_IMAGE_TYPE_2D)
 		{
 			throw VulkanException{VK_ERROR_INITIALIZATION_FAILED, "Image type is not 2D"};
 		}
 
-		views.emplace_back(image, VK_IMAGE_VIEW_TYPE_2D);
+		views.emplace_back(*image, VK_IMAGE_VIEW_TYPE_2D);
 
-		attachments.emplace_back(Attachment{image.get_format(), image.get_sample_count(), image.get_usage()});
+		attachments.emplace_back(Attachment{image->get_format(), image->get_sample_count(), image->get_usage()});
 	}
 }
 
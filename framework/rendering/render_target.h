@@ -63,6 +63,12 @@ class RenderTarget
 
 	RenderTarget(std::vector<core::Image> &&images);
 
+	/**
+	 * @brief Creates a render target from images it owns, followed by images shared with other render targets
+	 *        such as the attachments of a TransientAttachmentAllocator
+	 */
+	RenderTarget(std::vector<core::Image> &&images, std::vector<std::shared_ptr<core::Image>> &&shared_images);
+
 	RenderTarget(std::vector<core::ImageView> &&image_views);
 
 	RenderTarget(const RenderTarget &) = delete;
@@ -108,6 +114,9 @@ class RenderTarget
 
 	std::vector<core::Image> images;
 
+	/// Images kept alive for the views, after the owned images
+	std::vector<std::shared_ptr<core::Image>> shared_images;
+
 	std::vector<core::ImageView> views;
 
 	std::vector<Attachment> attachments;
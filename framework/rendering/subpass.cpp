@@ -42,6 +42,29 @@ Subpass::Subpass(RenderContext &render_context, ShaderSource &&vertex_source, Sh
 {
 }
 
+void Subpass::apply_resource_modes(ShaderModule &shader_module) const
+{
+	for (auto &resource : shader_module.get_resources())
+	{
+		// Only the modes which change are set, so that shader modules are not written once prepared
+		auto it = resource_mode_map.find(resource.name);
+		if (it != resource_mode_map.end() && resource.mode != it->second)
+		{
+			shader_module.set_resource_mode(resource.name, it->second);
+		}
+	}
+}
+
+ShaderResourceMode Subpass::get_per_draw_resource_mode() const
+{
+	if (render_context.get_device().is_enabled(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME))
+	{
+		return ShaderResourceMode::Push;
+	}
+
+	return ShaderResourceMode::Dynamic;
+}
+
 void Subpass::update_render_target_attachments(RenderTarget &render_target)
 {
 	render_target.set_input_attachments(input_attachments);
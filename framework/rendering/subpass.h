@@ -23,6 +23,7 @@
 #include "rendering/pipeline_state.h"
 #include "rendering/render_context.h"
 #include "rendering/render_frame.h"
+#include "scene_graph/component_pool.h"
 #include "scene_graph/components/light.h"
 #include "scene_graph/node.h"
 
@@ -148,8 +149,8 @@ class Subpass
 	 * @param light_count The maximum amount of lights allowed for any given type of light.
 	 */
 	template <typename T>
-	void allocate_lights(const std::vector<sg::Light *> &scene_lights,
-	                     size_t                          light_count)
+	void allocate_lights(const sg::ComponentView<sg::Light> &scene_lights,
+	                     size_t                              light_count)
 	{
 		assert(scene_lights.size() <= (light_count * sg::LightType::Max) && "Exceeding Max Light Capacity");
 
@@ -157,7 +158,7 @@ class Subpass
 		lighting_state.point_lights.clear();
 		lighting_state.spot_lights.clear();
 
-		for (auto &scene_light : scene_lights)
+		for (auto scene_light : scene_lights)
 		{
 			const auto &properties = scene_light->get_properties();
 			auto &      transform  = scene_light->get_node()->get_transform();
@@ -210,6 +211,18 @@ class Subpass
 	}
 
   protected:
+	/**
+	 * @brief Sets the modes of resource_mode_map on the resources declared by a shader module
+	 *        Called as the shader modules are built in prepare, since they are shared by the threads recording draws
+	 */
+	void apply_resource_modes(ShaderModule &shader_module) const;
+
+	/**
+	 * @return Mode of the uniforms updated for every draw: pushed when the device supports push descriptors,
+	 *         otherwise bound with dynamic offsets
+	 */
+	ShaderResourceMode get_per_draw_resource_mode() const;
+
 	RenderContext &render_context;
 
 	VkSampleCountFlagBits sample_count{VK_SAMPLE_COUNT_1_BIT};
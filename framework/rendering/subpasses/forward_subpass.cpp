@@ -55,6 +55,8 @@ void ForwardSubpass::prepare()
 			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
 		}
 	}
+
+	prepare_draw_states();
 }
 
 void ForwardSubpass::draw(CommandBuffer &command_buffer)
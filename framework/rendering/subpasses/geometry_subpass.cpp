@@ -16,8 +16,15 @@
  */
 
 #include "rendering/subpasses/geometry_subpass.h"
+
+#include <algorithm>
+#include <limits>
+
+#include <core/util/job_system.hpp>
+
 #include "common/utils.h"
 #include "common/vk_common.h"
+#include "geometry/frustum.h"
 #include "rendering/render_context.h"
 #include "scene_graph/components/camera.h"
 #include "scene_graph/components/image.h"
@@ -30,35 +37,390 @@
 
 namespace vkb
 {
+namespace
+{
+/// Instances culled by a job, enough to amortize scheduling it
+constexpr uint32_t cull_grain_size = 1024;
+}        // namespace
+
 GeometrySubpass::GeometrySubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, sg::Scene &scene_, sg::Camera &camera) :
     Subpass{render_context, std::move(vertex_source), std::move(fragment_source)},
-    meshes{scene_.get_components<sg::Mesh>()},
+    meshes{scene_.get_components<sg::Mesh>().to_vector()},
     camera{camera},
     scene{scene_}
 {
+	// The uniforms of the draws are pushed, or bound with dynamic offsets so that their descriptor sets are reused
+	resource_mode_map["GlobalUniform"] = get_per_draw_resource_mode();
 }
 
 void GeometrySubpass::prepare()
 {
-	// Build all shader variance upfront
 	auto &device = render_context.get_device();
+
+	if (bindless_materials_enabled)
+	{
+		if (BindlessMaterials::is_supported(device, meshes))
+		{
+			bindless_materials = std::make_unique<BindlessMaterials>(device, meshes);
+		}
+		else
+		{
+			LOGW("Textures cannot be indexed from an array, the materials are bound per draw");
+		}
+	}
+
+	// Build all shader variance upfront
 	for (auto &mesh : meshes)
 	{
 		for (auto &sub_mesh : mesh->get_submeshes())
 		{
-			auto &variant     = sub_mesh->get_shader_variant();
+			if (bindless_materials)
+			{
+				auto &bindless_variant = bindless_variants.emplace(sub_mesh, sub_mesh->get_shader_variant()).first->second;
+				bindless_materials->add_definitions(bindless_variant);
+			}
+
+			auto &variant     = get_shader_variant(*sub_mesh);
 			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
 			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
+
+			auto &instanced_variant = instanced_variants.emplace(sub_mesh, variant).first->second;
+			instanced_variant.add_define("INSTANCING");
+
+			auto &instanced_vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), instanced_variant);
+			auto &instanced_frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), instanced_variant);
+
+			apply_resource_modes(vert_module);
+			apply_resource_modes(frag_module);
+			apply_resource_modes(instanced_vert_module);
+			apply_resource_modes(instanced_frag_module);
+
+			// Vertex shaders without an instanced variant ignore the define
+			auto &resources = instanced_vert_module.get_resources();
+			instancing      = std::any_of(resources.begin(), resources.end(),
+			                              [](const ShaderResource &resource) { return resource.name == "InstanceBuffer"; });
 		}
 	}
+
+	prepare_draw_states();
 }
 
-void GeometrySubpass::get_sorted_nodes(std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes, std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes)
+GeometrySubpass::SubMeshDrawState GeometrySubpass::prepare_draw_state(const sg::SubMesh &sub_mesh, const ShaderVariant &variant, bool shared_streams) const
 {
-	auto camera_transform = camera.get_node()->get_transform().get_world_matrix();
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	auto &vert_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
+	auto &frag_shader_module = resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
+
+	SubMeshDrawState draw_state;
+	draw_state.shader_modules = {&vert_shader_module, &frag_shader_module};
+
+	// Attributes interleaved in the same stream share its binding, all the streams are bound at once
+	for (auto &input_resource : vert_shader_module.get_resources())
+	{
+		if (input_resource.type != ShaderResourceType::Input)
+		{
+			continue;
+		}
+
+		sg::VertexAttribute attribute;
+
+		const auto &buffer_iter = sub_mesh.vertex_buffers.find(input_resource.name);
+
+		// Bind vertex buffers only for the attribute locations defined
+		if (!sub_mesh.get_attribute(input_resource.name, attribute) || buffer_iter == sub_mesh.vertex_buffers.end())
+		{
+			continue;
+		}
+
+		const auto &range = buffer_iter->second;
+
+		VkDeviceSize offset = range.offset;
+		if (shared_streams)
+		{
+			offset -= static_cast<VkDeviceSize>(sub_mesh.vertex_offset) * attribute.stride;
+		}
+
+		uint32_t binding = 0;
+		while (binding < draw_state.buffers.size() && (&draw_state.buffers[binding].get() != range.buffer || draw_state.offsets[binding] != offset))
+		{
+			binding++;
+		}
+
+		if (binding == draw_state.buffers.size())
+		{
+			draw_state.buffers.emplace_back(std::ref(*range.buffer));
+			draw_state.offsets.push_back(offset);
+
+			VkVertexInputBindingDescription vertex_binding{};
+			vertex_binding.binding = binding;
+			vertex_binding.stride  = attribute.stride;
+
+			draw_state.vertex_input_state.bindings.push_back(vertex_binding);
+		}
+
+		VkVertexInputAttributeDescription vertex_attribute{};
+		vertex_attribute.binding  = binding;
+		vertex_attribute.format   = attribute.format;
+		vertex_attribute.location = input_resource.location;
+		vertex_attribute.offset   = attribute.offset;
+
+		draw_state.vertex_input_state.attributes.push_back(vertex_attribute);
+	}
+
+	return draw_state;
+}
+
+void GeometrySubpass::prepare_draw_states()
+{
+	draw_states.clear();
 
 	for (auto &mesh : meshes)
 	{
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			auto &sub_mesh_states = draw_states[sub_mesh];
+
+			sub_mesh_states[0] = prepare_draw_state(*sub_mesh, get_shader_variant(*sub_mesh));
+
+			auto instanced_it = instanced_variants.find(sub_mesh);
+			if (instancing && instanced_it != instanced_variants.end())
+			{
+				sub_mesh_states[1] = prepare_draw_state(*sub_mesh, instanced_it->second);
+			}
+		}
+	}
+}
+
+void GeometrySubpass::prepare_sort_ids()
+{
+	std::unordered_map<size_t, uint32_t>              variant_ids;
+	std::unordered_map<const sg::Material *, uint32_t> material_ids;
+
+	mesh_sort_id_offsets.clear();
+	submesh_state_ids.clear();
+	submesh_material_ids.clear();
+	batch_slot_offsets.clear();
+
+	uint32_t batch_slot_count = 0;
+
+	for (auto &mesh : meshes)
+	{
+		mesh_sort_id_offsets.push_back(to_u32(submesh_state_ids.size()));
+
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			auto variant_id  = variant_ids.emplace(sub_mesh->get_shader_variant().get_id(), to_u32(variant_ids.size())).first->second;
+			auto material_id = material_ids.emplace(sub_mesh->get_material(), to_u32(material_ids.size())).first->second;
+
+			// The lowest bit is left for the front face, which depends on the node
+			uint32_t double_sided = sub_mesh->get_material()->double_sided ? 1 : 0;
+			submesh_state_ids.push_back((variant_id << 2) | (double_sided << 1));
+			submesh_material_ids.push_back(material_id);
+
+			batch_slot_offsets[sub_mesh] = batch_slot_count;
+			batch_slot_count += to_u32(sub_mesh->lods.size() + 1) * 2;
+		}
+	}
+
+	batch_slots.assign(batch_slot_count, ~0u);
+}
+
+void GeometrySubpass::batch_instances(const DrawItem *items, size_t item_count)
+{
+	instance_batches.clear();
+	item_batches.clear();
+
+	for (size_t i = 0; i < item_count; i++)
+	{
+		auto &item = items[i];
+
+		// Invert the front face if the mesh was flipped
+		const auto &scale   = item.node->get_transform().get_scale();
+		uint32_t    flipped = scale.x * scale.y * scale.z < 0 ? 1 : 0;
+
+		uint32_t batch_index = to_u32(instance_batches.size());
+		uint32_t slot        = ~0u;
+
+		if (instancing)
+		{
+			slot = batch_slot_offsets.at(item.sub_mesh) + item.lod * 2 + flipped;
+
+			if (batch_slots[slot] != ~0u)
+			{
+				batch_index = batch_slots[slot];
+			}
+			else
+			{
+				batch_slots[slot] = batch_index;
+			}
+		}
+
+		if (batch_index == instance_batches.size())
+		{
+			instance_batches.push_back({&item, flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE, slot, 0, 0});
+		}
+
+		instance_batches[batch_index].instance_count++;
+		item_batches.push_back(batch_index);
+	}
+
+	// Lay the nodes of every batch out contiguously, and free the slots for the next frame
+	uint32_t instance_count = 0;
+	for (auto &batch : instance_batches)
+	{
+		batch.first_instance = instance_count;
+		instance_count += batch.instance_count;
+		batch.instance_count = 0;
+
+		if (batch.slot != ~0u)
+		{
+			batch_slots[batch.slot] = ~0u;
+		}
+	}
+
+	batched_nodes.resize(instance_count);
+	for (size_t i = 0; i < item_count; i++)
+	{
+		auto &batch = instance_batches[item_batches[i]];
+		batched_nodes[batch.first_instance + batch.instance_count++] = items[i].node;
+	}
+
+	// Gathered upfront, so that batches can be recorded concurrently
+	instance_matrices.clear();
+	if (instancing)
+	{
+		for (auto node : batched_nodes)
+		{
+			instance_matrices.push_back(node->get_transform().get_world_matrix());
+		}
+	}
+}
+
+void GeometrySubpass::bind_instances(CommandBuffer &command_buffer, const InstanceBatch &batch, size_t thread_index)
+{
+	auto size       = batch.instance_count * sizeof(glm::mat4);
+	auto allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, size, thread_index);
+
+	allocation.update(reinterpret_cast<const uint8_t *>(&instance_matrices[batch.first_instance]), size);
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 2, 0);
+}
+
+void GeometrySubpass::get_sorted_nodes(DrawList &draws)
+{
+	if (mesh_sort_id_offsets.size() != meshes.size())
+	{
+		prepare_sort_ids();
+	}
+
+	auto camera_transform = camera.get_node()->get_transform().get_world_matrix();
+
+	if (frustum_culling && scene.has_bvh())
+	{
+		query_instances();
+	}
+	else
+	{
+		gather_instances();
+	}
+
+	if (frustum_culling)
+	{
+		cull_instances(instance_bounds, instance_visibility);
+	}
+	else
+	{
+		instance_visibility.assign(instances.size(), 1);
+	}
+
+	culling_stats = {};
+
+	draws.clear();
+
+	// Pixels covered by a unit of view space, at a unit of distance for a perspective projection
+	const glm::mat4 &projection      = camera.get_projection();
+	bool             perspective     = projection[3][3] == 0.0f;
+	float            view_height     = static_cast<float>(lod_view_height != 0 ? lod_view_height : render_context.get_surface_extent().height);
+	float            pixels_per_unit = std::abs(projection[1][1]) * 0.5f * view_height;
+	glm::vec3        camera_position = glm::vec3(camera_transform[3]);
+
+	for (size_t i = 0; i < instances.size(); i++)
+	{
+		if (!instance_visibility[i])
+		{
+			continue;
+		}
+
+		culling_stats.visible++;
+
+		auto  node       = instances[i].first;
+		auto  mesh_index = instances[i].second;
+		auto &sub_meshes = meshes[mesh_index]->get_submeshes();
+
+		float distance = glm::length(camera_position - instance_bounds.get_center(i));
+
+		// Invert the front face if the mesh was flipped
+		const auto &scale   = node->get_transform().get_scale();
+		uint32_t    flipped = scale.x * scale.y * scale.z < 0 ? 1 : 0;
+
+		// The error is projected at the nearest point of the bounds, scaled by the largest axis of the instance
+		float error_scale = 0.0f;
+		if (lod_max_error > 0.0f)
+		{
+			const glm::mat4 &world_matrix = node->get_transform().get_world_matrix();
+			float            world_scale  = std::max({glm::length(glm::vec3(world_matrix[0])),
+			                                          glm::length(glm::vec3(world_matrix[1])),
+			                                          glm::length(glm::vec3(world_matrix[2]))});
+
+			error_scale = pixels_per_unit * world_scale;
+			if (perspective)
+			{
+				glm::vec3 offset = glm::max(glm::abs(camera_position - instance_bounds.get_center(i)) - instance_bounds.get_extents(i), glm::vec3(0.0f));
+				error_scale /= std::max(glm::length(offset), std::numeric_limits<float>::min());
+			}
+		}
+
+		for (size_t j = 0; j < sub_meshes.size(); j++)
+		{
+			auto &sub_mesh    = *sub_meshes[j];
+			auto  sort_index  = mesh_sort_id_offsets[mesh_index] + j;
+			auto  state_id    = submesh_state_ids[sort_index];
+			auto  material_id = submesh_material_ids[sort_index];
+			auto  lod         = error_scale > 0.0f ? select_lod(sub_mesh, error_scale) : 0;
+
+			if (sub_mesh.get_material()->alpha_mode == sg::AlphaMode::Blend)
+			{
+				draws.add(DrawList::transparent_key(state_id, material_id, distance), *node, sub_mesh, lod);
+			}
+			else
+			{
+				draws.add(DrawList::opaque_key(state_id | flipped, material_id, distance), *node, sub_mesh, lod);
+			}
+		}
+	}
+
+	// Instances rejected by the hierarchy were never gathered, and the hierarchy
+	// also holds the instances of meshes drawn by other subpasses
+	size_t instance_count = 0;
+	for (auto mesh : meshes)
+	{
+		instance_count += mesh->get_nodes().size();
+	}
+	culling_stats.culled = to_u32(instance_count) - culling_stats.visible;
+
+	draws.sort();
+}
+
+void GeometrySubpass::gather_instances()
+{
+	instances.clear();
+	instance_bounds.clear();
+
+	for (uint32_t mesh_index = 0; mesh_index < meshes.size(); mesh_index++)
+	{
+		auto &mesh = meshes[mesh_index];
+
 		for (auto &node : mesh->get_nodes())
 		{
 			auto node_transform = node->get_transform().get_world_matrix();
@@ -68,47 +430,142 @@ void GeometrySubpass::get_sorted_nodes(std::multimap<float, std::pair<sg::Node *
 			sg::AABB world_bounds{mesh_bounds.get_min(), mesh_bounds.get_max()};
 			world_bounds.transform(node_transform);
 
-			float distance = glm::length(glm::vec3(camera_transform[3]) - world_bounds.get_center());
+			instances.emplace_back(node, mesh_index);
+			instance_bounds.add(world_bounds.get_min(), world_bounds.get_max());
+		}
+	}
+}
 
-			for (auto &sub_mesh : mesh->get_submeshes())
-			{
-				if (sub_mesh->get_material()->alpha_mode == sg::AlphaMode::Blend)
-				{
-					transparent_nodes.emplace(distance, std::make_pair(node, sub_mesh));
-				}
-				else
-				{
-					opaque_nodes.emplace(distance, std::make_pair(node, sub_mesh));
-				}
-			}
+void GeometrySubpass::query_instances()
+{
+	if (mesh_indices.size() != meshes.size())
+	{
+		mesh_indices.clear();
+		for (uint32_t mesh_index = 0; mesh_index < meshes.size(); mesh_index++)
+		{
+			mesh_indices[meshes[mesh_index]] = mesh_index;
 		}
 	}
+
+	culling_planes.clear();
+	get_culling_planes(culling_planes);
+
+	const BVH &bvh = scene.get_bvh();
+
+	bvh_candidates.clear();
+	bvh.query(culling_planes.data(), culling_planes.size(), bvh_candidates);
+
+	auto &mesh_instances = scene.get_mesh_instances();
+
+	instances.clear();
+	instance_bounds.clear();
+	instance_bounds.reserve(bvh_candidates.size());
+
+	for (auto candidate : bvh_candidates)
+	{
+		auto &instance = mesh_instances[candidate];
+
+		auto mesh_it = mesh_indices.find(instance.mesh);
+		if (mesh_it == mesh_indices.end())
+		{
+			continue;
+		}
+
+		instances.emplace_back(instance.node, mesh_it->second);
+		instance_bounds.add(bvh.get_item_min(candidate), bvh.get_item_max(candidate));
+	}
+}
+
+void GeometrySubpass::get_culling_planes(std::vector<glm::vec4> &planes)
+{
+	Frustum frustum;
+	frustum.update(camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view());
+
+	planes.assign(frustum.get_planes().begin(), frustum.get_planes().end());
+}
+
+void GeometrySubpass::cull_instances(const AABBBatch &bounds, std::vector<uint8_t> &visibility)
+{
+	culling_planes.clear();
+	get_culling_planes(culling_planes);
+
+	visibility.resize(bounds.size());
+
+	// Ranges of instances are tested concurrently, a scene with fewer instances than a range is tested inline
+	JobSystem::get().parallel_for(to_u32(bounds.size()), cull_grain_size, [&](uint32_t first, uint32_t last) {
+		bounds.cull(culling_planes.data(), culling_planes.size(), first, last, visibility.data());
+	});
 }
 
 void GeometrySubpass::draw(CommandBuffer &command_buffer)
 {
-	std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> opaque_nodes;
-	std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> transparent_nodes;
+	prepare_draw();
+
+	draw_range(command_buffer, 0, get_draw_count(), thread_index);
+}
+
+void GeometrySubpass::prepare_draw()
+{
+	get_sorted_nodes(draw_list);
+
+	auto &items = draw_list.get_items();
+
+	auto transparent_it = std::find_if(items.begin(), items.end(), [](const DrawItem &item) {
+		return DrawList::get_layer(item.key) == DrawList::Transparent;
+	});
 
-	get_sorted_nodes(opaque_nodes, transparent_nodes);
+	transparent_begin = transparent_it - items.begin();
 
-	// Draw opaque objects in front-to-back order
+	batch_instances(items.data(), transparent_begin);
+}
+
+uint32_t GeometrySubpass::get_draw_count() const
+{
+	return to_u32(instance_batches.size() + draw_list.get_items().size() - transparent_begin);
+}
+
+void GeometrySubpass::draw_range(CommandBuffer &command_buffer, uint32_t first_draw, uint32_t draw_count, size_t thread_index)
+{
+	auto &items = draw_list.get_items();
+
+	uint32_t batch_count = to_u32(instance_batches.size());
+	uint32_t end_draw    = first_draw + draw_count;
+
+	assert(end_draw <= get_draw_count());
+
+	// A single descriptor set of material tables serves all the draws of the range
+	if (bindless_materials && draw_count > 0)
+	{
+		bindless_materials->bind(command_buffer);
+	}
+
+	// Draw opaque objects grouped by state, in front-to-back order within a state.
+	// Instances of a submesh are drawn together, at the position of the nearest one.
+	if (first_draw < batch_count)
 	{
 		ScopedDebugLabel opaque_debug_label{command_buffer, "Opaque objects"};
 
-		for (auto node_it = opaque_nodes.begin(); node_it != opaque_nodes.end(); node_it++)
+		for (uint32_t i = first_draw; i < std::min(end_draw, batch_count); i++)
 		{
-			update_uniform(command_buffer, *node_it->second.first, thread_index);
+			auto &batch = instance_batches[i];
+
+			// The global uniform also holds the camera, used by instanced draws
+			update_uniform(command_buffer, *batch.item->node, *batch.item->sub_mesh, thread_index);
 
-			// Invert the front face if the mesh was flipped
-			const auto &scale      = node_it->second.first->get_transform().get_scale();
-			bool        flipped    = scale.x * scale.y * scale.z < 0;
-			VkFrontFace front_face = flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+			if (batch.instance_count > 1)
+			{
+				bind_instances(command_buffer, batch, thread_index);
+			}
 
-			draw_submesh(command_buffer, *node_it->second.second, front_face);
+			draw_submesh(command_buffer, *batch.item->sub_mesh, batch.front_face, batch.item->lod, batch.instance_count);
 		}
 	}
 
+	if (end_draw <= batch_count)
+	{
+		return;
+	}
+
 	// Enable alpha blending
 	ColorBlendAttachmentState color_blend_attachment{};
 	color_blend_attachment.blend_enable           = VK_TRUE;
@@ -130,16 +587,19 @@ void GeometrySubpass::draw(CommandBuffer &command_buffer)
 	{
 		ScopedDebugLabel transparent_debug_label{command_buffer, "Transparent objects"};
 
-		for (auto node_it = transparent_nodes.rbegin(); node_it != transparent_nodes.rend(); node_it++)
+		size_t first_item = transparent_begin + std::max(first_draw, batch_count) - batch_count;
+		size_t end_item   = transparent_begin + end_draw - batch_count;
+
+		for (size_t i = first_item; i < end_item; i++)
 		{
-			update_uniform(command_buffer, *node_it->second.first, thread_index);
+			update_uniform(command_buffer, *items[i].node, *items[i].sub_mesh, thread_index);
 
-			draw_submesh(command_buffer, *node_it->second.second);
+			draw_submesh(command_buffer, *items[i].sub_mesh, VK_FRONT_FACE_COUNTER_CLOCKWISE, items[i].lod);
 		}
 	}
 }
 
-void GeometrySubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index)
+void GeometrySubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &node, const sg::SubMesh &sub_mesh, size_t thread_index)
 {
 	GlobalUniform global_uniform;
 
@@ -155,15 +615,16 @@ void GeometrySubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &no
 
 	global_uniform.camera_position = glm::vec3(glm::inverse(camera.get_view())[3]);
 
+	global_uniform.position_scale  = glm::vec4(sub_mesh.position_scale, 0.0f);
+	global_uniform.position_offset = glm::vec4(sub_mesh.position_offset, 0.0f);
+
 	allocation.update(global_uniform);
 
 	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
 }
 
-void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face)
+void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face, uint32_t lod, uint32_t instance_count)
 {
-	auto &device = command_buffer.get_device();
-
 	ScopedDebugLabel submesh_debug_label{command_buffer, sub_mesh.get_name().c_str()};
 
 	prepare_pipeline_state(command_buffer, front_face, sub_mesh.get_material()->double_sided);
@@ -172,78 +633,30 @@ void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &s
 	multisample_state.rasterization_samples = sample_count;
 	command_buffer.set_multisample_state(multisample_state);
 
-	auto &vert_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), sub_mesh.get_shader_variant());
-	auto &frag_shader_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), sub_mesh.get_shader_variant());
-
-	std::vector<ShaderModule *> shader_modules{&vert_shader_module, &frag_shader_module};
+	// Resolved at prepare time, instanced draws only happen if the vertex shader supports instancing
+	const auto &draw_state = draw_states.at(&sub_mesh)[instance_count > 1 ? 1 : 0];
 
-	auto &pipeline_layout = prepare_pipeline_layout(command_buffer, shader_modules);
+	auto &pipeline_layout = prepare_pipeline_layout(command_buffer, draw_state.shader_modules);
 
 	command_buffer.bind_pipeline_layout(pipeline_layout);
 
-	if (pipeline_layout.get_push_constant_range_stage(sizeof(PBRMaterialUniform)) != 0)
+	// Bindless materials only push their index
+	uint32_t push_constant_size = bindless_materials ? sizeof(uint32_t) : sizeof(PBRMaterialUniform);
+	if (pipeline_layout.get_push_constant_range_stage(push_constant_size) != 0)
 	{
 		prepare_push_constants(command_buffer, sub_mesh);
 	}
 
-	DescriptorSetLayout &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(0);
-
-	for (auto &texture : sub_mesh.get_material()->textures)
-	{
-		if (auto layout_binding = descriptor_set_layout.get_layout_binding(texture.first))
-		{
-			command_buffer.bind_image(texture.second->get_image()->get_vk_image_view(),
-			                          texture.second->get_sampler()->vk_sampler,
-			                          0, layout_binding->binding, 0);
-		}
-	}
-
-	auto vertex_input_resources = pipeline_layout.get_resources(ShaderResourceType::Input, VK_SHADER_STAGE_VERTEX_BIT);
+	bind_material_textures(command_buffer, pipeline_layout.get_descriptor_set_layout(0), *sub_mesh.get_material());
 
-	VertexInputState vertex_input_state;
+	command_buffer.set_vertex_input_state(draw_state.vertex_input_state);
 
-	for (auto &input_resource : vertex_input_resources)
+	if (!draw_state.buffers.empty())
 	{
-		sg::VertexAttribute attribute;
-
-		if (!sub_mesh.get_attribute(input_resource.name, attribute))
-		{
-			continue;
-		}
-
-		VkVertexInputAttributeDescription vertex_attribute{};
-		vertex_attribute.binding  = input_resource.location;
-		vertex_attribute.format   = attribute.format;
-		vertex_attribute.location = input_resource.location;
-		vertex_attribute.offset   = attribute.offset;
-
-		vertex_input_state.attributes.push_back(vertex_attribute);
-
-		VkVertexInputBindingDescription vertex_binding{};
-		vertex_binding.binding = input_resource.location;
-		vertex_binding.stride  = attribute.stride;
-
-		vertex_input_state.bindings.push_back(vertex_binding);
+		command_buffer.bind_vertex_buffers(0, draw_state.buffers, draw_state.offsets);
 	}
 
-	command_buffer.set_vertex_input_state(vertex_input_state);
-
-	// Find submesh vertex buffers matching the shader input attribute names
-	for (auto &input_resource : vertex_input_resources)
-	{
-		const auto &buffer_iter = sub_mesh.vertex_buffers.find(input_resource.name);
-
-		if (buffer_iter != sub_mesh.vertex_buffers.end())
-		{
-			std::vector<std::reference_wrapper<const core::Buffer>> buffers;
-			buffers.emplace_back(std::ref(buffer_iter->second));
-
-			// Bind vertex buffers only for the attribute locations defined
-			command_buffer.bind_vertex_buffers(input_resource.location, std::move(buffers), {0});
-		}
-	}
-
-	draw_submesh_command(command_buffer, sub_mesh);
+	draw_submesh_command(command_buffer, sub_mesh, lod, instance_count);
 }
 
 void GeometrySubpass::prepare_pipeline_state(CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material)
@@ -265,13 +678,10 @@ void GeometrySubpass::prepare_pipeline_state(CommandBuffer &command_buffer, VkFr
 
 PipelineLayout &GeometrySubpass::prepare_pipeline_layout(CommandBuffer &command_buffer, const std::vector<ShaderModule *> &shader_modules)
 {
-	// Sets any specified resource modes
+	// Sets any specified resource modes, already set in prepare unless the map was changed since
 	for (auto &shader_module : shader_modules)
 	{
-		for (auto &resource_mode : resource_mode_map)
-		{
-			shader_module->set_resource_mode(resource_mode.first, resource_mode.second);
-		}
+		apply_resource_modes(*shader_module);
 	}
 
 	return command_buffer.get_device().get_resource_cache().request_pipeline_layout(shader_modules);
@@ -279,6 +689,12 @@ PipelineLayout &GeometrySubpass::prepare_pipeline_layout(CommandBuffer &command_
 
 void GeometrySubpass::prepare_push_constants(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh)
 {
+	if (bindless_materials)
+	{
+		command_buffer.push_constants(bindless_materials->get_material_index(*sub_mesh.get_material()));
+		return;
+	}
+
 	auto pbr_material = dynamic_cast<const sg::PBRMaterial *>(sub_mesh.get_material());
 
 	PBRMaterialUniform pbr_material_uniform{};
@@ -286,29 +702,61 @@ void GeometrySubpass::prepare_push_constants(CommandBuffer &command_buffer, sg::
 	pbr_material_uniform.metallic_factor   = pbr_material->metallic_factor;
 	pbr_material_uniform.roughness_factor  = pbr_material->roughness_factor;
 
-	auto data = to_bytes(pbr_material_uniform);
+	command_buffer.push_constants(pbr_material_uniform);
+}
+
+void GeometrySubpass::bind_material_textures(CommandBuffer &command_buffer, DescriptorSetLayout &descriptor_set_layout, const sg::Material &material)
+{
+	// The texture array is bound once by draw_range
+	if (bindless_materials)
+	{
+		return;
+	}
 
-	if (!data.empty())
+	for (auto &texture : material.textures)
 	{
-		command_buffer.push_constants(data);
+		if (auto layout_binding = descriptor_set_layout.get_layout_binding(texture.first))
+		{
+			command_buffer.bind_image(texture.second->get_image()->get_vk_image_view(),
+			                          texture.second->get_sampler()->vk_sampler,
+			                          0, layout_binding->binding, 0);
+		}
 	}
 }
 
-void GeometrySubpass::draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh)
+const ShaderVariant &GeometrySubpass::get_shader_variant(const sg::SubMesh &sub_mesh) const
+{
+	return bindless_materials ? bindless_variants.at(&sub_mesh) : sub_mesh.get_shader_variant();
+}
+
+void GeometrySubpass::draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, uint32_t lod, uint32_t instance_count)
 {
 	// Draw submesh indexed if indices exists
 	if (sub_mesh.vertex_indices != 0)
 	{
-		// Bind index buffer of submesh
-		command_buffer.bind_index_buffer(*sub_mesh.index_buffer, sub_mesh.index_offset, sub_mesh.index_type);
+		uint32_t index_offset = sub_mesh.index_offset;
+		uint32_t index_count  = sub_mesh.vertex_indices;
+
+		// Simplified levels index the same vertices from further in the index buffer
+		if (lod > 0)
+		{
+			assert(lod <= sub_mesh.lods.size());
+			index_offset = sub_mesh.lods[lod - 1].index_offset;
+			index_count  = sub_mesh.lods[lod - 1].index_count;
+		}
+
+		// The index buffer is shared by the submeshes, it is only bound again when its index type changes
+		command_buffer.bind_index_buffer(*sub_mesh.index_buffer, 0, sub_mesh.index_type);
+
+		uint32_t index_size = sub_mesh.index_type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
 
 		// Draw submesh using indexed data
-		command_buffer.draw_indexed(sub_mesh.vertex_indices, 1, 0, 0, 0);
+		command_buffer.draw_indexed(index_count, instance_count, index_offset / index_size, 0, 0);
 	}
 	else
 	{
 		// Draw submesh using vertices only
-		command_buffer.draw(sub_mesh.vertices_count, 1, 0, 0);
+		command_buffer.draw(sub_mesh.vertices_count, instance_count, 0, 0);
 	}
 }
 
@@ -316,4 +764,38 @@ void GeometrySubpass::set_thread_index(uint32_t index)
 {
 	thread_index = index;
 }
+
+void GeometrySubpass::set_bindless_materials(bool enable)
+{
+	bindless_materials_enabled = enable;
+}
+
+void GeometrySubpass::set_frustum_culling(bool enable)
+{
+	frustum_culling = enable;
+}
+
+const CullingStats &GeometrySubpass::get_culling_stats() const
+{
+	return culling_stats;
+}
+
+void GeometrySubpass::set_lod_error(float max_error, uint32_t view_height)
+{
+	lod_max_error   = max_error;
+	lod_view_height = view_height;
+}
+
+uint32_t GeometrySubpass::select_lod(const sg::SubMesh &sub_mesh, float error_scale) const
+{
+	uint32_t lod = 0;
+
+	// Levels are in order of increasing error
+	while (lod < sub_mesh.lods.size() && sub_mesh.lods[lod].error * error_scale <= lod_max_error)
+	{
+		lod++;
+	}
+
+	return lod;
+}
 }        // namespace vkb
@@ -23,6 +23,9 @@ VKBP_DISABLE_WARNINGS()
 #include "common/glm_common.h"
 VKBP_ENABLE_WARNINGS()
 
+#include "geometry/aabb_batch.h"
+#include "rendering/bindless_materials.h"
+#include "rendering/draw_list.h"
 #include "rendering/subpass.h"
 
 namespace vkb
@@ -31,6 +34,7 @@ namespace sg
 {
 class Scene;
 class Node;
+class Material;
 class Mesh;
 class SubMesh;
 class Camera;
@@ -46,6 +50,11 @@ struct alignas(16) GlobalUniform
 	glm::mat4 camera_view_proj;
 
 	glm::vec3 camera_position;
+
+	/// Scale and offset of the positions of the QUANTIZED_POSITION variant, aligned like the std140 block
+	alignas(16) glm::vec4 position_scale;
+
+	glm::vec4 position_offset;
 };
 
 /**
@@ -60,6 +69,19 @@ struct PBRMaterialUniform
 	float roughness_factor;
 };
 
+/**
+ * @brief Number of mesh instances which passed or failed culling during the last draw
+ */
+struct CullingStats
+{
+	uint32_t visible{0};
+
+	uint32_t culled{0};
+
+	/// Instances in the frustum hidden by other geometry, included in culled
+	uint32_t occluded{0};
+};
+
 /**
  * @brief This subpass is responsible for rendering a Scene
  */
@@ -85,15 +107,65 @@ class GeometrySubpass : public Subpass
 	 */
 	virtual void draw(CommandBuffer &command_buffer) override;
 
+	/**
+	 * @brief Culls and sorts the scene into the draws of the frame, to be recorded with draw_range
+	 */
+	virtual void prepare_draw();
+
+	/**
+	 * @return Number of draws prepared by prepare_draw
+	 */
+	virtual uint32_t get_draw_count() const;
+
+	/**
+	 * @brief Records a range of the prepared draws. Separate ranges can be recorded concurrently,
+	 *        into secondary command buffers beginning the same subpass, each with its own thread index.
+	 * @param command_buffer Command buffer to record into
+	 * @param first_draw Index of the first draw of the range
+	 * @param draw_count Number of draws of the range
+	 * @param thread_index Render frame thread index used to allocate the resources of the range
+	 */
+	virtual void draw_range(CommandBuffer &command_buffer, uint32_t first_draw, uint32_t draw_count, size_t thread_index);
+
 	/**
 	 * @brief Thread index to use for allocating resources
 	 */
 	void set_thread_index(uint32_t index);
 
+	/**
+	 * @brief Enables or disables culling of mesh instances against the camera frustum
+	 */
+	void set_frustum_culling(bool enable);
+
+	const CullingStats &get_culling_stats() const;
+
+	/**
+	 * @brief Sets the error allowed when selecting the level of detail of the submeshes.
+	 *        The coarsest level whose simplification error projects to at most max_error pixels is drawn.
+	 * @param max_error Largest projected error in pixels, 0 to always draw full detail
+	 * @param view_height Height in pixels of the images rendered, 0 for the height of the surface
+	 */
+	void set_lod_error(float max_error, uint32_t view_height = 0);
+
+	/**
+	 * @brief Enables reading the materials from tables bound once per command buffer, the textures in a
+	 *        single array in descriptor set 1, with only the material index pushed per draw.
+	 *        Must be called before prepare, the shaders must support the BINDLESS_MATERIALS variant.
+	 *        Falls back to binding the textures of every draw if the device cannot index the textures.
+	 */
+	void set_bindless_materials(bool enable);
+
   protected:
-	virtual void update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index);
+	/**
+	 * @brief Binds the uniform of a draw of a submesh by a node
+	 */
+	virtual void update_uniform(CommandBuffer &command_buffer, sg::Node &node, const sg::SubMesh &sub_mesh, size_t thread_index);
 
-	void draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE);
+	/**
+	 * @param instance_count Number of instances, more than one draws the INSTANCING shader variant
+	 *        with the model matrices bound by bind_instances
+	 */
+	void draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE, uint32_t lod = 0, uint32_t instance_count = 1);
 
 	virtual void prepare_pipeline_state(CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material);
 
@@ -101,14 +173,123 @@ class GeometrySubpass : public Subpass
 
 	virtual void prepare_push_constants(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh);
 
-	virtual void draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh);
+	/**
+	 * @brief Shader modules of a submesh drawn with a shader variant, and the vertex streams its vertex shader reads,
+	 *        resolved once so that the draws do not allocate
+	 */
+	struct SubMeshDrawState
+	{
+		/// Vertex shader module, followed by the fragment shader module
+		std::vector<ShaderModule *> shader_modules;
+
+		VertexInputState vertex_input_state;
+
+		std::vector<std::reference_wrapper<const core::Buffer>> buffers;
+
+		std::vector<VkDeviceSize> offsets;
+	};
+
+	/**
+	 * @param shared_streams Whether the streams are bound at the start of the arenas the submesh shares with the
+	 *        submeshes of the same vertex layout, for the draws to use its vertex offset as base vertex
+	 */
+	SubMeshDrawState prepare_draw_state(const sg::SubMesh &sub_mesh, const ShaderVariant &variant, bool shared_streams = false) const;
+
+	/**
+	 * @brief Resolves the draw states of the submeshes of the meshes, with and without instancing,
+	 *        once their shader variants are complete
+	 */
+	void prepare_draw_states();
+
+	/**
+	 * @brief Binds the material textures of a submesh, or nothing if the materials are bindless
+	 */
+	void bind_material_textures(CommandBuffer &command_buffer, DescriptorSetLayout &descriptor_set_layout, const sg::Material &material);
+
+	/**
+	 * @return Shader variant drawing a submesh without instancing
+	 */
+	const ShaderVariant &get_shader_variant(const sg::SubMesh &sub_mesh) const;
+
+	/**
+	 * @param lod Level of detail to draw, 0 for full detail or the index of the submesh level plus one
+	 */
+	virtual void draw_submesh_command(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, uint32_t lod = 0, uint32_t instance_count = 1);
+
+	/**
+	 * @brief Selects the coarsest level of detail of a submesh within the allowed error
+	 * @param sub_mesh Submesh to draw
+	 * @param error_scale Pixels covered by a unit of model space at the instance
+	 */
+	uint32_t select_lod(const sg::SubMesh &sub_mesh, float error_scale) const;
+
+	/**
+	 * @brief Culls the mesh instances and fills the draw list with the visible submeshes,
+	 *        sorted so that opaque objects are grouped by state and drawn front-to-back,
+	 *        and transparent objects are drawn back-to-front
+	 */
+	void get_sorted_nodes(DrawList &draws);
+
+	/**
+	 * @brief Assigns compact sort ids to the shader variant and material of every submesh
+	 */
+	void prepare_sort_ids();
+
+	/**
+	 * @brief Opaque draw items sharing a submesh, level of detail and front face, drawn with one instanced draw
+	 */
+	struct InstanceBatch
+	{
+		const DrawItem *item;
+
+		VkFrontFace front_face;
+
+		/// Index of the batch in batch_slots, ~0 if instancing is disabled
+		uint32_t slot;
+
+		/// Index of the first node of the batch in batched_nodes
+		uint32_t first_instance;
+
+		uint32_t instance_count;
+	};
+
+	/**
+	 * @brief Groups draw items into instance batches, in the order of their first item.
+	 *        Every item is a batch of its own if the vertex shader does not support instancing.
+	 * @param items Sorted opaque draw items
+	 * @param item_count Number of draw items
+	 */
+	void batch_instances(const DrawItem *items, size_t item_count);
+
+	/**
+	 * @brief Uploads the model matrices of the nodes of a batch and binds them to the InstanceBuffer
+	 */
+	void bind_instances(CommandBuffer &command_buffer, const InstanceBatch &batch, size_t thread_index);
+
+	/**
+	 * @brief Tests the world space bounds of the mesh instances for visibility
+	 *        By default the bounds are tested against the camera frustum, in ranges spread over the JobSystem
+	 * @param bounds World space bounds of every mesh instance
+	 * @param visibility Set to 1 for each instance that has to be drawn
+	 */
+	virtual void cull_instances(const AABBBatch &bounds, std::vector<uint8_t> &visibility);
+
+	/**
+	 * @brief Gets the world space planes of the volume in which mesh instances can be visible,
+	 *        used to query the scene bounding volume hierarchy. By default the camera frustum.
+	 * @param planes Normalized planes, facing inwards
+	 */
+	virtual void get_culling_planes(std::vector<glm::vec4> &planes);
+
+	/**
+	 * @brief Gathers the mesh instances intersecting the culling planes from the scene hierarchy
+	 */
+	void query_instances();
 
 	/**
-	 * @brief Sorts objects based on distance from camera and classifies them
-	 *        into opaque and transparent in the arrays provided
+	 * @brief Gathers every mesh instance of the subpass
 	 */
-	void get_sorted_nodes(std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes,
-	                      std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes);
+	void gather_instances();
 
 	sg::Camera &camera;
 
@@ -119,6 +300,77 @@ class GeometrySubpass : public Subpass
 	uint32_t thread_index{0};
 
 	vkb::RasterizationState base_rasterization_state{};
+
+	bool frustum_culling{true};
+
+	float lod_max_error{1.0f};
+
+	uint32_t lod_view_height{0};
+
+	CullingStats culling_stats{};
+
+	/// Mesh instances of the current frame as node and index into meshes, kept to avoid reallocating every frame
+	std::vector<std::pair<sg::Node *, uint32_t>> instances;
+
+	/// World space bounds of the mesh instances, in the same order
+	AABBBatch instance_bounds;
+
+	std::vector<uint8_t> instance_visibility;
+
+	/// Index into meshes of every mesh, to map the scene mesh instances
+	std::unordered_map<const sg::Mesh *, uint32_t> mesh_indices;
+
+	std::vector<glm::vec4> culling_planes;
+
+	std::vector<uint32_t> bvh_candidates;
+
+	DrawList draw_list;
+
+	/// Index of the first submesh of every mesh in the sort id arrays
+	std::vector<uint32_t> mesh_sort_id_offsets;
+
+	/// Shader variant and rasterization state sort id of every submesh
+	std::vector<uint32_t> submesh_state_ids;
+
+	/// Material sort id of every submesh
+	std::vector<uint32_t> submesh_material_ids;
+
+	/// Whether the vertex shader reads the model matrices from an InstanceBuffer in its INSTANCING variant
+	bool instancing{false};
+
+	bool bindless_materials_enabled{false};
+
+	/// Material tables of the meshes, null unless bindless materials are enabled and supported
+	std::unique_ptr<BindlessMaterials> bindless_materials;
+
+	/// BINDLESS_MATERIALS shader variant of every submesh
+	std::unordered_map<const sg::SubMesh *, ShaderVariant> bindless_variants;
+
+	/// INSTANCING shader variant of every submesh
+	std::unordered_map<const sg::SubMesh *, ShaderVariant> instanced_variants;
+
+	/// Draw state of every submesh, without and with instancing
+	std::unordered_map<const sg::SubMesh *, std::array<SubMeshDrawState, 2>> draw_states;
+
+	/// First batch slot of every submesh, followed by one slot per level of detail and front face
+	std::unordered_map<const sg::SubMesh *, uint32_t> batch_slot_offsets;
+
+	/// Batch index of every slot during batch_instances, ~0 when free
+	std::vector<uint32_t> batch_slots;
+
+	std::vector<InstanceBatch> instance_batches;
+
+	/// Batch index of every draw item
+	std::vector<uint32_t> item_batches;
+
+	/// Nodes of the batches, contiguous per batch
+	std::vector<sg::Node *> batched_nodes;
+
+	/// World matrices of the batched nodes, in the same order
+	std::vector<glm::mat4> instance_matrices;
+
+	/// Index of the first transparent draw item, drawn after the instance batches
+	size_t transparent_begin{0};
 };
 
 }        // namespace vkb
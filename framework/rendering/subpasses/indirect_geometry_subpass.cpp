@@ -0,0 +1,839 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/subpasses/indirect_geometry_subpass.h"
+
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <tuple>
+
+#include "common/utils.h"
+#include "common/vk_common.h"
+#include "rendering/hiz_pyramid.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/camera.h"
+#include "scene_graph/components/image.h"
+#include "scene_graph/components/material.h"
+#include "scene_graph/components/mesh.h"
+#include "scene_graph/components/pbr_material.h"
+#include "scene_graph/components/sub_mesh.h"
+#include "scene_graph/components/texture.h"
+#include "scene_graph/node.h"
+#include "scene_graph/scene.h"
+
+namespace vkb
+{
+namespace
+{
+/**
+ * @brief Uniform of the culling compute shader
+ */
+struct alignas(16) CullUniform
+{
+	glm::mat4 view_proj;
+
+	std::array<glm::vec4, 6> planes;
+
+	uint32_t plane_count;
+
+	uint32_t instance_count;
+
+	/// Extent of the depth image the Hi-Z pyramid was built from
+	glm::uvec2 depth_size;
+
+	glm::vec3 camera_position;
+
+	/// Pixels covered by a unit of view space, at a unit of distance for a perspective projection
+	float pixels_per_unit;
+
+	/// Largest projected error of the levels of detail in pixels, 0 to always draw full detail
+	float lod_max_error;
+
+	uint32_t perspective;
+};
+
+/**
+ * @brief Level of detail drawn by a command, the coarser levels of its submesh follow it
+ */
+struct CommandLod
+{
+	/// Simplification error of the level in model space
+	float error;
+
+	uint32_t coarser_level_count;
+};
+
+/**
+ * @brief Scale and offset restoring the positions of the submesh of a command, see SubMesh::position_scale
+ */
+struct CommandPosition
+{
+	glm::vec4 scale;
+
+	glm::vec4 offset;
+};
+
+/**
+ * @brief Counters written by the culling compute shader
+ */
+struct CullCounters
+{
+	uint32_t visible;
+
+	uint32_t frustum_culled;
+
+	uint32_t occluded;
+};
+
+/**
+ * @brief Creates a device local buffer holding the values, copied from a staging buffer kept until the copy completes
+ */
+template <class T>
+std::unique_ptr<core::Buffer> upload_buffer(CommandBuffer &command_buffer, std::vector<core::Buffer> &staging_buffers, const std::vector<T> &values, VkBufferUsageFlags usage)
+{
+	auto &device = command_buffer.get_device();
+	auto  size   = values.size() * sizeof(T);
+
+	core::Buffer staging_buffer{device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY};
+	staging_buffer.update(values);
+
+	auto buffer = std::make_unique<core::Buffer>(device, size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+	command_buffer.copy_buffer(staging_buffer, *buffer, size);
+
+	staging_buffers.push_back(std::move(staging_buffer));
+
+	return buffer;
+}
+
+/**
+ * @return Offset in its buffer of the stream holding an attribute of the submesh and of the submeshes of the same vertex layout
+ */
+VkDeviceSize get_stream_offset(const sg::SubMesh &sub_mesh, const sg::BufferRange &range, uint32_t stride)
+{
+	return range.offset - static_cast<VkDeviceSize>(sub_mesh.vertex_offset) * stride;
+}
+}        // namespace
+
+IndirectGeometrySubpass::IndirectGeometrySubpass(RenderContext &render_context, ShaderSource &&vertex_source, ShaderSource &&fragment_source, ShaderSource &&cull_source, ShaderSource &&scatter_source, sg::Scene &scene_, sg::Camera &camera) :
+    GeometrySubpass{render_context, std::move(vertex_source), std::move(fragment_source), scene_, camera},
+    cull_shader{std::move(cull_source)},
+    scatter_shader{std::move(scatter_source)}
+{
+	occluder_cull_variant.add_define("OCCLUSION_EARLY");
+	occlusion_cull_variant.add_define("OCCLUSION_LATE");
+}
+
+bool IndirectGeometrySubpass::is_packable(const sg::Mesh &mesh)
+{
+	for (auto &sub_mesh : mesh.get_submeshes())
+	{
+		// Transparent submeshes have to be sorted back-to-front
+		if (sub_mesh->get_material()->alpha_mode == sg::AlphaMode::Blend)
+		{
+			return false;
+		}
+
+		if (!sub_mesh->index_buffer || sub_mesh->vertex_indices == 0 ||
+		    (sub_mesh->index_type != VK_INDEX_TYPE_UINT16 && sub_mesh->index_type != VK_INDEX_TYPE_UINT32))
+		{
+			return false;
+		}
+
+		// Vertices are drawn from the shared streams of the submeshes of the same layout
+		sg::VertexAttribute attribute;
+		if (!sub_mesh->get_attribute("position", attribute) || sub_mesh->vertex_buffers.count("position") == 0)
+		{
+			return false;
+		}
+
+		for (auto &vertex_buffer : sub_mesh->vertex_buffers)
+		{
+			if (!vertex_buffer.second.buffer)
+			{
+				return false;
+			}
+		}
+	}
+
+	return !mesh.get_submeshes().empty();
+}
+
+void IndirectGeometrySubpass::prepare()
+{
+	GeometrySubpass::prepare();
+
+	// Commands use their first instance to locate their visible instances
+	auto features = render_context.get_device().get_gpu().get_requested_features();
+	if (!features.drawIndirectFirstInstance)
+	{
+		LOGW("drawIndirectFirstInstance is not enabled, all meshes are drawn without indirect commands");
+		return;
+	}
+
+	multi_draw_indirect = features.multiDrawIndirect;
+
+	std::vector<sg::Mesh *> direct_meshes;
+	for (auto mesh : meshes)
+	{
+		if (is_packable(*mesh))
+		{
+			indirect_meshes.push_back(mesh);
+		}
+		else
+		{
+			direct_meshes.push_back(mesh);
+		}
+	}
+
+	meshes = std::move(direct_meshes);
+
+	if (indirect_meshes.empty())
+	{
+		return;
+	}
+
+	prepare_commands();
+
+	if (batches.empty())
+	{
+		return;
+	}
+
+	// Build the indirect shader variants upfront, with the streams of the batches
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+	for (auto &batch : batches)
+	{
+		batch.draw_state = prepare_draw_state(*batch.sub_mesh, batch.shader_variant, true);
+
+		for (auto shader_module : batch.draw_state.shader_modules)
+		{
+			apply_resource_modes(*shader_module);
+		}
+
+		// Only the vertex shader is needed to draw depth
+		batch.depth_shader_modules = {batch.draw_state.shader_modules.front()};
+	}
+	resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, cull_shader);
+	resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, cull_shader, occluder_cull_variant);
+	resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, cull_shader, occlusion_cull_variant);
+	resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, scatter_shader);
+}
+
+void IndirectGeometrySubpass::prepare_commands()
+{
+	// Instances of every mesh, split by front face, as it is part of the pipeline state
+	std::vector<std::array<uint32_t, 2>> mesh_instance_counts(indirect_meshes.size(), {0, 0});
+	// Mesh index and front face of every instance
+	std::vector<std::pair<uint32_t, uint32_t>> instance_meshes;
+
+	for (uint32_t mesh_index = 0; mesh_index < indirect_meshes.size(); mesh_index++)
+	{
+		for (auto node : indirect_meshes[mesh_index]->get_nodes())
+		{
+			const auto &scale   = node->get_transform().get_scale();
+			uint32_t    flipped = scale.x * scale.y * scale.z < 0 ? 1 : 0;
+
+			node_instances[node] = to_u32(instance_nodes.size());
+			instance_nodes.push_back(node);
+			instance_meshes.emplace_back(mesh_index, flipped);
+			mesh_instance_counts[mesh_index][flipped]++;
+		}
+	}
+
+	if (instance_nodes.empty())
+	{
+		return;
+	}
+
+	// One command per submesh, level of detail and front face, sorted so that the commands sharing a shader
+	// variant, rasterization state, material, vertex streams and index type are adjacent. The levels of a
+	// submesh have the same key, they are inserted in order and then stay adjacent.
+	using BatchKey = std::tuple<size_t, bool, uint32_t, const sg::Material *, VkDeviceSize, VkIndexType>;
+
+	struct CommandEntry
+	{
+		uint32_t     mesh_index;
+		uint32_t     sub_mesh_index;
+		uint32_t     flipped;
+		uint32_t     lod;
+		sg::SubMesh *sub_mesh;
+	};
+
+	std::multimap<BatchKey, CommandEntry> entries;
+
+	for (uint32_t mesh_index = 0; mesh_index < indirect_meshes.size(); mesh_index++)
+	{
+		auto &sub_meshes = indirect_meshes[mesh_index]->get_submeshes();
+
+		for (uint32_t flipped = 0; flipped < 2; flipped++)
+		{
+			if (mesh_instance_counts[mesh_index][flipped] == 0)
+			{
+				continue;
+			}
+
+			for (uint32_t i = 0; i < sub_meshes.size(); i++)
+			{
+				auto *sub_mesh = sub_meshes[i];
+
+				// Submeshes of the same vertex layout share all their streams, the position stream identifies them
+				sg::VertexAttribute position;
+				sub_mesh->get_attribute("position", position);
+				auto stream_offset = get_stream_offset(*sub_mesh, sub_mesh->vertex_buffers.at("position"), position.stride);
+
+				BatchKey key{sub_mesh->get_shader_variant().get_id(), sub_mesh->get_material()->double_sided, flipped, sub_mesh->get_material(), stream_offset, sub_mesh->index_type};
+
+				for (uint32_t lod = 0; lod <= sub_mesh->lods.size(); lod++)
+				{
+					entries.emplace(key, CommandEntry{mesh_index, i, flipped, lod, sub_mesh});
+				}
+			}
+		}
+	}
+
+	// Index of the first submesh of every mesh in submesh_commands
+	std::vector<uint32_t> mesh_submesh_offsets;
+	uint32_t              submesh_count = 0;
+	for (auto mesh : indirect_meshes)
+	{
+		mesh_submesh_offsets.push_back(submesh_count);
+		submesh_count += to_u32(mesh->get_submeshes().size());
+	}
+
+	// Command of the full detail level of every submesh and front face
+	std::vector<std::array<uint32_t, 2>>  submesh_commands(submesh_count);
+	std::vector<VkDrawIndexedIndirectCommand> commands;
+	std::vector<CommandLod>                   command_lods;
+	std::vector<CommandPosition>              command_positions;
+
+	visible_instance_capacity = 0;
+
+	for (auto entry_it = entries.begin(); entry_it != entries.end(); entry_it++)
+	{
+		auto &entry = entry_it->second;
+
+		if (entry_it == entries.begin() || std::prev(entry_it)->first != entry_it->first)
+		{
+			Batch batch{};
+			batch.sub_mesh       = entry.sub_mesh;
+			batch.shader_variant = get_shader_variant(*entry.sub_mesh);
+			batch.shader_variant.add_define("INDIRECT_DRAW");
+			batch.front_face     = entry.flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE;
+			batch.index_type     = entry.sub_mesh->index_type;
+			batch.first_command  = to_u32(commands.size());
+
+			batches.push_back(std::move(batch));
+		}
+
+		batches.back().command_count++;
+
+		uint32_t index_size   = entry.sub_mesh->index_type == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+		uint32_t index_offset = entry.sub_mesh->index_offset;
+
+		CommandLod command_lod{};
+		command_lod.coarser_level_count = to_u32(entry.sub_mesh->lods.size()) - entry.lod;
+
+		if (entry.lod > 0)
+		{
+			auto &lod = entry.sub_mesh->lods[entry.lod - 1];
+
+			index_offset      = lod.index_offset;
+			command_lod.error = lod.error;
+		}
+
+		// The submeshes are drawn from the start of the index buffer and of their vertex streams
+		VkDrawIndexedIndirectCommand command{};
+		command.indexCount    = entry.lod > 0 ? entry.sub_mesh->lods[entry.lod - 1].index_count : entry.sub_mesh->vertex_indices;
+		command.instanceCount = 0;
+		command.firstIndex    = index_offset / index_size;
+		command.vertexOffset  = static_cast<int32_t>(entry.sub_mesh->vertex_offset);
+		command.firstInstance = visible_instance_capacity;
+
+		if (entry.lod == 0)
+		{
+			submesh_commands[mesh_submesh_offsets[entry.mesh_index] + entry.sub_mesh_index][entry.flipped] = to_u32(commands.size());
+		}
+
+		// Quantized positions are restored per command, as a batch draws several submeshes
+		CommandPosition command_position{};
+		command_position.scale  = glm::vec4(entry.sub_mesh->position_scale, 0.0f);
+		command_position.offset = glm::vec4(entry.sub_mesh->position_offset, 0.0f);
+
+		commands.push_back(command);
+		command_lods.push_back(command_lod);
+		command_positions.push_back(command_position);
+
+		// Every instance may select any level
+		visible_instance_capacity += mesh_instance_counts[entry.mesh_index][entry.flipped];
+	}
+
+	// Commands of the submeshes of every instance
+	std::vector<glm::uvec4> instance_infos;
+	std::vector<uint32_t>   command_references;
+
+	for (auto &instance : instance_meshes)
+	{
+		uint32_t mesh_index = instance.first;
+		uint32_t submeshes  = to_u32(indirect_meshes[mesh_index]->get_submeshes().size());
+
+		instance_infos.emplace_back(mesh_index, to_u32(command_references.size()), submeshes, 0);
+
+		for (uint32_t i = 0; i < submeshes; i++)
+		{
+			command_references.push_back(submesh_commands[mesh_submesh_offsets[mesh_index] + i][instance.second]);
+		}
+	}
+
+	std::vector<glm::vec4> mesh_bounds;
+	for (auto mesh : indirect_meshes)
+	{
+		const auto &bounds = mesh->get_bounds();
+		mesh_bounds.emplace_back((bounds.get_min() + bounds.get_max()) * 0.5f, 0.0f);
+		mesh_bounds.emplace_back((bounds.get_max() - bounds.get_min()) * 0.5f, 0.0f);
+	}
+
+	auto &device = render_context.get_device();
+
+	// The tables are only read by the GPU, they are uploaded once into device local memory
+	{
+		std::vector<core::Buffer> staging_buffers;
+
+		auto &command_buffer = device.request_command_buffer();
+
+		command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, 0);
+
+		command_template         = upload_buffer(command_buffer, staging_buffers, commands, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+		instance_info_buffer     = upload_buffer(command_buffer, staging_buffers, instance_infos, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		mesh_bounds_buffer       = upload_buffer(command_buffer, staging_buffers, mesh_bounds, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		command_reference_buffer = upload_buffer(command_buffer, staging_buffers, command_references, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		command_lod_buffer       = upload_buffer(command_buffer, staging_buffers, command_lods, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		command_position_buffer  = upload_buffer(command_buffer, staging_buffers, command_positions, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+		// Only the world matrices which change are written afterwards
+		std::vector<glm::mat4> instance_models;
+		for (auto node : instance_nodes)
+		{
+			instance_models.push_back(node->get_transform().get_world_matrix());
+		}
+		instance_buffer       = upload_buffer(command_buffer, staging_buffers, instance_models, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+		instance_update_count = scene.get_world_update_count();
+
+		// No instance was visible before the first frame, so the first occluder pass is empty
+		instance_visibility_buffer = upload_buffer(command_buffer, staging_buffers, std::vector<uint32_t>(instance_nodes.size(), 0), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+
+		command_buffer.end();
+
+		auto &queue = device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+		queue.submit(command_buffer, device.request_fence());
+
+		device.get_fence_pool().wait();
+		device.get_fence_pool().reset();
+		device.get_command_pool().reset_pool();
+	}
+
+	CullCounters counters{};
+
+	frame_buffers.resize(render_context.get_render_frames().size());
+	for (auto &frame : frame_buffers)
+	{
+		frame.commands = std::make_unique<core::Buffer>(device, commands.size() * sizeof(VkDrawIndexedIndirectCommand),
+		                                                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		                                                VMA_MEMORY_USAGE_GPU_ONLY);
+
+		// Instance and command of every visible instance
+		frame.visible_instances = std::make_unique<core::Buffer>(device, visible_instance_capacity * sizeof(glm::uvec2),
+		                                                         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+
+		frame.occluder_commands = std::make_unique<core::Buffer>(device, commands.size() * sizeof(VkDrawIndexedIndirectCommand),
+		                                                         VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		                                                         VMA_MEMORY_USAGE_GPU_ONLY);
+
+		frame.occluder_visible_instances = std::make_unique<core::Buffer>(device, visible_instance_capacity * sizeof(glm::uvec2),
+		                                                                  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY);
+
+		frame.stats = std::make_unique<core::Buffer>(device, sizeof(CullCounters), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU);
+		frame.stats->convert_and_update(counters);
+	}
+}
+
+void IndirectGeometrySubpass::set_hiz_pyramid(HiZPyramid *pyramid)
+{
+	hiz_pyramid = pyramid;
+}
+
+void IndirectGeometrySubpass::update_instances(CommandBuffer &command_buffer)
+{
+	uint32_t world_update_count = scene.get_world_update_count();
+
+	// The buffer already holds the changes of the last update
+	if (world_update_count != 0 && world_update_count == instance_update_count)
+	{
+		return;
+	}
+
+	instance_updates.clear();
+
+	if (world_update_count != 0 && world_update_count == instance_update_count + 1)
+	{
+		for (auto node : scene.get_changed_nodes())
+		{
+			auto instance_it = node_instances.find(node);
+			if (instance_it != node_instances.end())
+			{
+				instance_updates.push_back({node->get_transform().get_world_matrix(), instance_it->second});
+			}
+		}
+	}
+	else
+	{
+		// Some updates were missed, or the scene does not propagate its transforms
+		for (uint32_t i = 0; i < instance_nodes.size(); i++)
+		{
+			instance_updates.push_back({instance_nodes[i]->get_transform().get_world_matrix(), i});
+		}
+	}
+
+	instance_update_count = world_update_count;
+
+	if (instance_updates.empty())
+	{
+		return;
+	}
+
+	auto size       = instance_updates.size() * sizeof(InstanceUpdate);
+	auto allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, size, thread_index);
+	allocation.update(reinterpret_cast<const uint8_t *>(instance_updates.data()), size);
+
+	// The matrices may still be read by the previous frame
+	BufferMemoryBarrier write_barrier{};
+	write_barrier.src_stage_mask  = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	write_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	write_barrier.src_access_mask = VK_ACCESS_SHADER_READ_BIT;
+	write_barrier.dst_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	command_buffer.buffer_memory_barrier(*instance_buffer, 0, instance_buffer->get_size(), write_barrier);
+
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+	auto &scatter_module = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, scatter_shader);
+
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&scatter_module});
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+	command_buffer.set_specialization_constant(0, work_group_size);
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 0, 0);
+	command_buffer.bind_buffer(*instance_buffer, 0, instance_buffer->get_size(), 0, 1, 0);
+
+	command_buffer.dispatch((to_u32(instance_updates.size()) + work_group_size - 1) / work_group_size, 1, 1);
+
+	BufferMemoryBarrier read_barrier{};
+	read_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	read_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+	read_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	read_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+	command_buffer.buffer_memory_barrier(*instance_buffer, 0, instance_buffer->get_size(), read_barrier);
+}
+
+void IndirectGeometrySubpass::cull_occluders(CommandBuffer &command_buffer)
+{
+	if (batches.empty() || !hiz_pyramid)
+	{
+		return;
+	}
+
+	auto &frame = frame_buffers[render_context.get_active_frame_index()];
+
+	update_instances(command_buffer);
+
+	// Written by the culling of the previous frame
+	BufferMemoryBarrier visibility_barrier{};
+	visibility_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	visibility_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	visibility_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	visibility_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	command_buffer.buffer_memory_barrier(*instance_visibility_buffer, 0, instance_visibility_buffer->get_size(), visibility_barrier);
+
+	dispatch_cull(command_buffer, frame, occluder_cull_variant, *frame.occluder_commands, *frame.occluder_visible_instances);
+}
+
+void IndirectGeometrySubpass::cull(CommandBuffer &command_buffer)
+{
+	if (batches.empty())
+	{
+		return;
+	}
+
+	auto &frame = frame_buffers[render_context.get_active_frame_index()];
+
+	// The frame is not in flight anymore, its counters are complete
+	auto counters = *reinterpret_cast<const CullCounters *>(frame.stats->map());
+	frame.stats->unmap();
+
+	indirect_stats.visible  = counters.visible;
+	indirect_stats.culled   = counters.frustum_culled + counters.occluded;
+	indirect_stats.occluded = counters.occluded;
+
+	frame.stats->convert_and_update(CullCounters{});
+
+	if (hiz_pyramid)
+	{
+		// The occluder culling reads the visibility written here
+		BufferMemoryBarrier visibility_barrier{};
+		visibility_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		visibility_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		visibility_barrier.src_access_mask = VK_ACCESS_SHADER_READ_BIT;
+		visibility_barrier.dst_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+		command_buffer.buffer_memory_barrier(*instance_visibility_buffer, 0, instance_visibility_buffer->get_size(), visibility_barrier);
+
+		command_buffer.bind_image(hiz_pyramid->get_view(), hiz_pyramid->get_sampler(), 0, 7, 0);
+
+		dispatch_cull(command_buffer, frame, occlusion_cull_variant, *frame.commands, *frame.visible_instances);
+	}
+	else
+	{
+		update_instances(command_buffer);
+
+		dispatch_cull(command_buffer, frame, {}, *frame.commands, *frame.visible_instances);
+	}
+
+	BufferMemoryBarrier stats_barrier{};
+	stats_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	stats_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_HOST_BIT;
+	stats_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	stats_barrier.dst_access_mask = VK_ACCESS_HOST_READ_BIT;
+	command_buffer.buffer_memory_barrier(*frame.stats, 0, frame.stats->get_size(), stats_barrier);
+}
+
+void IndirectGeometrySubpass::dispatch_cull(CommandBuffer &command_buffer, FrameBuffers &frame, const ShaderVariant &variant, core::Buffer &commands, core::Buffer &visible_instances)
+{
+	// Reset the instance counts of the commands
+	command_buffer.copy_buffer(*command_template, commands, command_template->get_size());
+
+	BufferMemoryBarrier reset_barrier{};
+	reset_barrier.src_stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT;
+	reset_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	reset_barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	reset_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	command_buffer.buffer_memory_barrier(commands, 0, commands.get_size(), reset_barrier);
+
+	culling_planes.clear();
+	get_culling_planes(culling_planes);
+	assert(culling_planes.size() <= 6);
+
+	CullUniform cull_uniform{};
+	cull_uniform.view_proj = camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
+	std::copy(culling_planes.begin(), culling_planes.end(), cull_uniform.planes.begin());
+	cull_uniform.plane_count    = to_u32(culling_planes.size());
+	cull_uniform.instance_count = to_u32(instance_nodes.size());
+
+	if (hiz_pyramid)
+	{
+		cull_uniform.depth_size = glm::uvec2(hiz_pyramid->get_depth_extent().width, hiz_pyramid->get_depth_extent().height);
+	}
+
+	// Levels of detail are selected like GeometrySubpass::select_lod does
+	const glm::mat4 &projection  = camera.get_projection();
+	float            view_height = static_cast<float>(lod_view_height != 0 ? lod_view_height : render_context.get_surface_extent().height);
+
+	cull_uniform.camera_position = glm::vec3(glm::inverse(camera.get_view())[3]);
+	cull_uniform.pixels_per_unit = std::abs(projection[1][1]) * 0.5f * view_height;
+	cull_uniform.lod_max_error   = lod_max_error;
+	cull_uniform.perspective     = projection[3][3] == 0.0f ? 1 : 0;
+
+	auto allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(CullUniform), thread_index);
+	allocation.update(cull_uniform);
+
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+	auto &cull_module    = resource_cache.request_shader_module(VK_SHADER_STAGE_COMPUTE_BIT, cull_shader, variant);
+
+	auto &pipeline_layout = resource_cache.request_pipeline_layout({&cull_module});
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+	command_buffer.set_specialization_constant(0, work_group_size);
+
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 0, 0);
+	command_buffer.bind_buffer(*instance_buffer, 0, instance_buffer->get_size(), 0, 1, 0);
+	command_buffer.bind_buffer(*instance_info_buffer, 0, instance_info_buffer->get_size(), 0, 2, 0);
+	command_buffer.bind_buffer(*mesh_bounds_buffer, 0, mesh_bounds_buffer->get_size(), 0, 3, 0);
+	command_buffer.bind_buffer(*command_reference_buffer, 0, command_reference_buffer->get_size(), 0, 4, 0);
+	command_buffer.bind_buffer(commands, 0, commands.get_size(), 0, 5, 0);
+	command_buffer.bind_buffer(visible_instances, 0, visible_instances.get_size(), 0, 6, 0);
+
+	// Bindings missing from the variant are ignored
+	if (hiz_pyramid)
+	{
+		command_buffer.bind_buffer(*instance_visibility_buffer, 0, instance_visibility_buffer->get_size(), 0, 8, 0);
+	}
+	command_buffer.bind_buffer(*frame.stats, 0, frame.stats->get_size(), 0, 9, 0);
+	command_buffer.bind_buffer(*command_lod_buffer, 0, command_lod_buffer->get_size(), 0, 10, 0);
+
+	command_buffer.dispatch((to_u32(instance_nodes.size()) + work_group_size - 1) / work_group_size, 1, 1);
+
+	BufferMemoryBarrier command_barrier{};
+	command_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	command_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+	command_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	command_barrier.dst_access_mask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+	command_buffer.buffer_memory_barrier(commands, 0, commands.get_size(), command_barrier);
+
+	BufferMemoryBarrier visible_barrier{};
+	visible_barrier.src_stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+	visible_barrier.dst_stage_mask  = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+	visible_barrier.src_access_mask = VK_ACCESS_SHADER_WRITE_BIT;
+	visible_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+	command_buffer.buffer_memory_barrier(visible_instances, 0, visible_instances.get_size(), visible_barrier);
+}
+
+void IndirectGeometrySubpass::bind_global_uniform(CommandBuffer &command_buffer, size_t thread_index)
+{
+	// The model matrices are read from the instance buffer
+	GlobalUniform global_uniform{};
+	global_uniform.model            = glm::mat4(1.0f);
+	global_uniform.camera_view_proj = camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
+	global_uniform.camera_position  = glm::vec3(glm::inverse(camera.get_view())[3]);
+
+	auto allocation = render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(GlobalUniform), thread_index);
+	allocation.update(global_uniform);
+	command_buffer.bind_buffer(allocation.get_buffer(), allocation.get_offset(), allocation.get_size(), 0, 1, 0);
+}
+
+void IndirectGeometrySubpass::draw_occluders(CommandBuffer &command_buffer)
+{
+	if (batches.empty() || !hiz_pyramid)
+	{
+		return;
+	}
+
+	ScopedDebugLabel occluders_debug_label{command_buffer, "Occluders"};
+
+	bind_global_uniform(command_buffer, thread_index);
+
+	auto &frame = frame_buffers[render_context.get_active_frame_index()];
+
+	for (auto &batch : batches)
+	{
+		if (batch.sub_mesh->get_material()->alpha_mode != sg::AlphaMode::Mask)
+		{
+			draw_batch(command_buffer, batch, frame, *frame.occluder_commands, *frame.occluder_visible_instances, true);
+		}
+	}
+}
+
+void IndirectGeometrySubpass::prepare_draw()
+{
+	// Meshes which could not be packed
+	GeometrySubpass::prepare_draw();
+
+	culling_stats.visible += indirect_stats.visible;
+	culling_stats.culled += indirect_stats.culled;
+	culling_stats.occluded += indirect_stats.occluded;
+}
+
+uint32_t IndirectGeometrySubpass::get_draw_count() const
+{
+	return to_u32(batches.size()) + GeometrySubpass::get_draw_count();
+}
+
+void IndirectGeometrySubpass::draw_range(CommandBuffer &command_buffer, uint32_t first_draw, uint32_t draw_count, size_t thread_index)
+{
+	uint32_t batch_count = to_u32(batches.size());
+	uint32_t end_draw    = first_draw + draw_count;
+
+	// The indirect batches come first, followed by the draws of the meshes which could not be packed
+	if (first_draw < batch_count)
+	{
+		ScopedDebugLabel indirect_debug_label{command_buffer, "Indirect objects"};
+
+		bind_global_uniform(command_buffer, thread_index);
+
+		if (bindless_materials)
+		{
+			bindless_materials->bind(command_buffer);
+		}
+
+		auto &frame = frame_buffers[render_context.get_active_frame_index()];
+
+		for (uint32_t i = first_draw; i < std::min(end_draw, batch_count); i++)
+		{
+			draw_batch(command_buffer, batches[i], frame, *frame.commands, *frame.visible_instances, false);
+		}
+	}
+
+	if (end_draw > batch_count)
+	{
+		uint32_t first_base_draw = std::max(first_draw, batch_count) - batch_count;
+		GeometrySubpass::draw_range(command_buffer, first_base_draw, end_draw - batch_count - first_base_draw, thread_index);
+	}
+}
+
+void IndirectGeometrySubpass::draw_batch(CommandBuffer &command_buffer, const Batch &batch, const FrameBuffers &frame,
+                                         const core::Buffer &commands, const core::Buffer &visible_instances, bool depth_only)
+{
+	prepare_pipeline_state(command_buffer, batch.front_face, batch.sub_mesh->get_material()->double_sided);
+
+	MultisampleState multisample_state{};
+	multisample_state.rasterization_samples = sample_count;
+	command_buffer.set_multisample_state(multisample_state);
+
+	// Only the vertex shader is needed to draw depth, textures and push constants are then not in the layout
+	auto &pipeline_layout = prepare_pipeline_layout(command_buffer, depth_only ? batch.depth_shader_modules : batch.draw_state.shader_modules);
+
+	command_buffer.bind_pipeline_layout(pipeline_layout);
+
+	uint32_t push_constant_size = bindless_materials ? sizeof(uint32_t) : sizeof(PBRMaterialUniform);
+	if (pipeline_layout.get_push_constant_range_stage(push_constant_size) != 0)
+	{
+		prepare_push_constants(command_buffer, *batch.sub_mesh);
+	}
+
+	bind_material_textures(command_buffer, pipeline_layout.get_descriptor_set_layout(0), *batch.sub_mesh->get_material());
+
+	command_buffer.bind_buffer(*instance_buffer, 0, instance_buffer->get_size(), 0, 2, 0);
+	command_buffer.bind_buffer(visible_instances, 0, visible_instances.get_size(), 0, 3, 0);
+	command_buffer.bind_buffer(*command_position_buffer, 0, command_position_buffer->get_size(), 0, 4, 0);
+
+	// All the submeshes of the batch share the vertex streams of the submesh, drawn from their start
+	command_buffer.set_vertex_input_state(batch.draw_state.vertex_input_state);
+
+	if (!batch.draw_state.buffers.empty())
+	{
+		command_buffer.bind_vertex_buffers(0, batch.draw_state.buffers, batch.draw_state.offsets);
+	}
+
+	command_buffer.bind_index_buffer(*batch.sub_mesh->index_buffer, 0, batch.index_type);
+
+	uint32_t     stride = sizeof(VkDrawIndexedIndirectCommand);
+	VkDeviceSize offset = batch.first_command * stride;
+
+	if (multi_draw_indirect)
+	{
+		command_buffer.draw_indexed_indirect(commands, offset, batch.command_count, stride);
+	}
+	else
+	{
+		for (uint32_t i = 0; i < batch.command_count; i++)
+		{
+			command_buffer.draw_indexed_indirect(commands, offset + i * stride, 1, stride);
+		}
+	}
+}
+
+uint32_t IndirectGeometrySubpass::get_batch_count() const
+{
+	return to_u32(batches.size());
+}
+}        // namespace vkb
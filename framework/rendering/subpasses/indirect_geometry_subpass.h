@@ -0,0 +1,243 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "rendering/subpasses/geometry_subpass.h"
+
+namespace vkb
+{
+class HiZPyramid;
+
+/**
+ * @brief Renders the opaque meshes of a Scene with GPU-driven indirect draws.
+ *        The submeshes are drawn from the geometry buffers of the scene, those of the
+ *        same vertex layout sharing their vertex streams, and a compute pass culls every
+ *        mesh instance against the culling planes, writing the instance counts of one
+ *        indirect command per submesh and level of detail. The level of every instance is
+ *        selected from its projected error, as set by set_lod_error.
+ *        Quantized positions are restored with the scale and offset of the command drawing them.
+ *        The world matrices of the instances stay in device local memory, in which a compute
+ *        pass writes those the last scene update changed, so static instances cost nothing. One indirect draw is
+ *        then issued per pipeline state and material, so the CPU cost does not grow
+ *        with the number of instances.
+ *        Transparent meshes, and meshes whose vertex data cannot be shared, are drawn
+ *        by the GeometrySubpass path.
+ *
+ *        With a HiZPyramid, the instances are also culled by occlusion in two phases. The
+ *        instances visible in the previous frame are culled and drawn as occluders into a
+ *        depth image first, from which the pyramid is built. Then every instance is tested
+ *        against the pyramid, so that instances disoccluded this frame are drawn immediately.
+ */
+class IndirectGeometrySubpass : public GeometrySubpass
+{
+  public:
+	/**
+	 * @brief Constructs a subpass drawing the scene through indirect commands
+	 * @param render_context Render context
+	 * @param vertex_shader Vertex shader source, which reads the model matrices when INDIRECT_DRAW is defined
+	 * @param fragment_shader Fragment shader source
+	 * @param cull_shader Compute shader source culling the instances into the indirect commands
+	 * @param scatter_shader Compute shader source writing the changed world matrices into the instance buffer
+	 * @param scene Scene to render on this subpass
+	 * @param camera Camera used to look at the scene
+	 */
+	IndirectGeometrySubpass(RenderContext &render_context, ShaderSource &&vertex_shader, ShaderSource &&fragment_shader, ShaderSource &&cull_shader, ShaderSource &&scatter_shader, sg::Scene &scene, sg::Camera &camera);
+
+	virtual ~IndirectGeometrySubpass() = default;
+
+	virtual void prepare() override;
+
+	/**
+	 * @brief Enables occlusion culling against a pyramid built from the depth of the occluders
+	 */
+	void set_hiz_pyramid(HiZPyramid *pyramid);
+
+	/**
+	 * @brief Records the culling of the occluders, the instances in the frustum which were visible
+	 *        in the previous frame. Must be called before cull when a pyramid is set.
+	 */
+	void cull_occluders(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Records the depth-only draws of the occluders, in the render pass of the depth image
+	 *        the pyramid is built from. Alpha masked occluders are skipped, as their depth has holes.
+	 */
+	void draw_occluders(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Records the culling of the instances into the indirect commands of the active frame.
+	 *        Compute work cannot be recorded in a render pass, so this must be called before
+	 *        the render pass of this subpass begins. With a pyramid, the pyramid must have been
+	 *        built from the depth of the occluders.
+	 */
+	void cull(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Prepares the draws of the meshes which could not be packed, and gathers the culling stats
+	 */
+	virtual void prepare_draw() override;
+
+	/**
+	 * @return Number of indirect batches, followed by the draws prepared by GeometrySubpass
+	 */
+	virtual uint32_t get_draw_count() const override;
+
+	virtual void draw_range(CommandBuffer &command_buffer, uint32_t first_draw, uint32_t draw_count, size_t thread_index) override;
+
+	/**
+	 * @return Number of batches, each drawn with a single indirect draw if multiDrawIndirect is enabled
+	 */
+	uint32_t get_batch_count() const;
+
+  private:
+	/**
+	 * @brief Indirect commands drawn with the same pipeline state and material
+	 */
+	struct Batch
+	{
+		/// Submesh providing the material, shader variant and vertex streams
+		sg::SubMesh *sub_mesh;
+
+		ShaderVariant shader_variant;
+
+		VkFrontFace front_face;
+
+		VkIndexType index_type;
+
+		/// Shader modules and streams of the submesh, bound at the start of the streams of its vertex layout
+		SubMeshDrawState draw_state;
+
+		/// Vertex shader module alone, drawing the occluders
+		std::vector<ShaderModule *> depth_shader_modules;
+
+		uint32_t first_command;
+
+		uint32_t command_count;
+	};
+
+	/**
+	 * @brief Buffers written during a frame, one set per frame in flight
+	 */
+	struct FrameBuffers
+	{
+		std::unique_ptr<core::Buffer> commands;
+
+		std::unique_ptr<core::Buffer> visible_instances;
+
+		std::unique_ptr<core::Buffer> occluder_commands;
+
+		std::unique_ptr<core::Buffer> occluder_visible_instances;
+
+		/// Culling counters, read back when the frame is reused
+		std::unique_ptr<core::Buffer> stats;
+	};
+
+	/**
+	 * @return Whether all the submeshes of the mesh are opaque and can be drawn from the streams they share
+	 */
+	static bool is_packable(const sg::Mesh &mesh);
+
+	/**
+	 * @brief Gathers the instances of the indirect meshes and groups their submeshes into batches of commands,
+	 *        drawing submeshes of the same vertex layout and index type from the geometry buffers of the scene
+	 */
+	void prepare_commands();
+
+	/**
+	 * @brief World matrix of an instance written by the scatter shader, in its layout
+	 */
+	struct alignas(16) InstanceUpdate
+	{
+		glm::mat4 model;
+
+		uint32_t instance;
+	};
+
+	/**
+	 * @brief Records the writes of the world matrices which changed during the last scene update into the instance buffer.
+	 *        All of them are written if updates were missed, or if the scene does not propagate its transforms.
+	 */
+	void update_instances(CommandBuffer &command_buffer);
+
+	void dispatch_cull(CommandBuffer &command_buffer, FrameBuffers &frame, const ShaderVariant &variant, core::Buffer &commands, core::Buffer &visible_instances);
+
+	void bind_global_uniform(CommandBuffer &command_buffer, size_t thread_index);
+
+	void draw_batch(CommandBuffer &command_buffer, const Batch &batch, const FrameBuffers &frame, const core::Buffer &commands, const core::Buffer &visible_instances, bool depth_only);
+
+	ShaderSource cull_shader;
+
+	ShaderSource scatter_shader;
+
+	/// Meshes drawn by the indirect path, the others remain in meshes
+	std::vector<sg::Mesh *> indirect_meshes;
+
+	std::vector<Batch> batches;
+
+	/// Node of every instance
+	std::vector<sg::Node *> instance_nodes;
+
+	/// Instance of every node in instance_nodes
+	std::unordered_map<const sg::Node *, uint32_t> node_instances;
+
+	/// World matrices of the instances, shared by the frames in flight
+	std::unique_ptr<core::Buffer> instance_buffer;
+
+	/// Scene world update whose changes the instance buffer holds
+	uint32_t instance_update_count{0};
+
+	std::vector<InstanceUpdate> instance_updates;
+
+	/// Commands with a zero instance count, copied to the frame commands before culling
+	std::unique_ptr<core::Buffer> command_template;
+
+	std::unique_ptr<core::Buffer> instance_info_buffer;
+
+	std::unique_ptr<core::Buffer> mesh_bounds_buffer;
+
+	std::unique_ptr<core::Buffer> command_reference_buffer;
+
+	/// Level of detail of every command
+	std::unique_ptr<core::Buffer> command_lod_buffer;
+
+	/// Scale and offset of the quantized positions of every command
+	std::unique_ptr<core::Buffer> command_position_buffer;
+
+	/// Sum of the instance counts of all the commands
+	uint32_t visible_instance_capacity{0};
+
+	std::vector<FrameBuffers> frame_buffers;
+
+	HiZPyramid *hiz_pyramid{nullptr};
+
+	/// Whether every instance was visible in the previous frame, shared by the frames in flight
+	std::unique_ptr<core::Buffer> instance_visibility_buffer;
+
+	ShaderVariant occluder_cull_variant;
+
+	ShaderVariant occlusion_cull_variant;
+
+	/// Culling counters of the indirect path in the last completed use of the active frame
+	CullingStats indirect_stats;
+
+	bool multi_draw_indirect{false};
+
+	uint32_t work_group_size{64};
+};
+
+}        // namespace vkb
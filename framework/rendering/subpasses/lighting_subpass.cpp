@@ -29,6 +29,9 @@ LightingSubpass::LightingSubpass(RenderContext &render_context, ShaderSource &&v
     camera{cam},
     scene{scene_}
 {
+	// The uniforms are allocated every frame, dynamic offsets let the frames reuse their descriptor sets
+	resource_mode_map["GlobalUniform"] = ShaderResourceMode::Dynamic;
+	resource_mode_map["LightsInfo"]    = ShaderResourceMode::Dynamic;
 }
 
 void LightingSubpass::prepare()
@@ -38,8 +41,8 @@ void LightingSubpass::prepare()
 	lighting_variant.add_definitions(light_type_definitions);
 	// Build all shaders upfront
 	auto &resource_cache = render_context.get_device().get_resource_cache();
-	resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), lighting_variant);
-	resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), lighting_variant);
+	apply_resource_modes(resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), lighting_variant));
+	apply_resource_modes(resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), lighting_variant));
 }
 
 void LightingSubpass::draw(CommandBuffer &command_buffer)
@@ -0,0 +1,205 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "rendering/transient_attachment_allocator.h"
+
+#include <unordered_set>
+
+#include "common/logging.h"
+#include "core/device.h"
+
+namespace vkb
+{
+TransientAttachmentAllocator::AliasedMemory::AliasedMemory(Device const &device, const VkMemoryRequirements &requirements) :
+    device{device}
+{
+	VmaAllocationCreateInfo memory_info{};
+	memory_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+	VmaAllocationInfo allocation_info{};
+	VK_CHECK(vmaAllocateMemory(device.get_memory_allocator(), &requirements, &memory_info, &allocation, &allocation_info));
+
+	size        = allocation_info.size;
+	memory_type = allocation_info.memoryType;
+}
+
+TransientAttachmentAllocator::AliasedMemory::~AliasedMemory()
+{
+	vmaFreeMemory(device.get_memory_allocator(), allocation);
+}
+
+TransientAttachmentAllocator::TransientAttachmentAllocator(Device const &device) :
+    device{device}
+{
+	const auto &memory_properties = device.get_gpu().get_memory_properties();
+	for (uint32_t i = 0; i < memory_properties.memoryTypeCount; i++)
+	{
+		if (memory_properties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+		{
+			lazy_allocation_supported = true;
+		}
+	}
+}
+
+std::shared_ptr<core::Image> TransientAttachmentAllocator::request_image(const std::string &name,
+                                                                         const VkExtent3D  &extent,
+                                                                         VkFormat           format,
+                                                                         VkImageUsageFlags  usage,
+                                                                         const std::string &alias_group)
+{
+	auto &attachment = attachments[name];
+
+	auto image = attachment.image.lock();
+	if (image && attachment.extent.width == extent.width && attachment.extent.height == extent.height &&
+	    attachment.extent.depth == extent.depth && attachment.format == format && attachment.usage == usage &&
+	    attachment.alias_group == alias_group)
+	{
+		return image;
+	}
+
+	// The previous image, if any, stays alive until the render targets referring to it are replaced
+	attachment             = AttachmentImage{};
+	attachment.extent      = extent;
+	attachment.format      = format;
+	attachment.usage       = usage;
+	attachment.alias_group = alias_group;
+
+	bool transient = (usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) != 0;
+
+	// Lazily allocated memory is not worth aliasing, it is only committed for the attachments which are stored
+	if (alias_group.empty() || (transient && lazy_allocation_supported))
+	{
+		// Transient images prefer lazily allocated memory
+		image = std::make_shared<core::Image>(device, extent, format, usage, VMA_MEMORY_USAGE_GPU_ONLY);
+
+		VmaAllocationInfo allocation_info{};
+		vmaGetAllocationInfo(device.get_memory_allocator(), image->get_memory(), &allocation_info);
+
+		const auto &memory_type = device.get_gpu().get_memory_properties().memoryTypes[allocation_info.memoryType];
+
+		attachment.size = allocation_info.size;
+		attachment.lazy = (memory_type.propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+	}
+	else
+	{
+		image = create_aliased_image(attachment);
+	}
+
+	attachment.image = image;
+
+	return image;
+}
+
+std::shared_ptr<core::Image> TransientAttachmentAllocator::create_aliased_image(AttachmentImage &attachment)
+{
+	VkImageCreateInfo image_info{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+	image_info.imageType   = VK_IMAGE_TYPE_2D;
+	image_info.format      = attachment.format;
+	image_info.extent      = attachment.extent;
+	image_info.mipLevels   = 1;
+	image_info.arrayLayers = 1;
+	image_info.samples     = VK_SAMPLE_COUNT_1_BIT;
+	image_info.tiling      = VK_IMAGE_TILING_OPTIMAL;
+	image_info.usage       = attachment.usage;
+
+	VkImage handle{VK_NULL_HANDLE};
+	VK_CHECK(vkCreateImage(device.get_handle(), &image_info, nullptr, &handle));
+
+	VkMemoryRequirements requirements{};
+	vkGetImageMemoryRequirements(device.get_handle(), handle, &requirements);
+
+	// Images are bound at the start of the memory, which is aligned for any of them
+	auto memory = alias_groups[attachment.alias_group].lock();
+	if (!memory || memory->size < requirements.size || !(requirements.memoryTypeBits & (1u << memory->memory_type)))
+	{
+		LOGD("Allocating {} bytes of memory for alias group {}", requirements.size, attachment.alias_group);
+
+		try
+		{
+			memory = std::make_shared<AliasedMemory>(device, requirements);
+		}
+		catch (...)
+		{
+			vkDestroyImage(device.get_handle(), handle, nullptr);
+			throw;
+		}
+
+		alias_groups[attachment.alias_group] = memory;
+	}
+
+	VkResult result = vmaBindImageMemory(device.get_memory_allocator(), memory->allocation, handle);
+	if (result != VK_SUCCESS)
+	{
+		vkDestroyImage(device.get_handle(), handle, nullptr);
+		throw VulkanException{result, "Cannot bind aliased image memory"};
+	}
+
+	attachment.size           = requirements.size;
+	attachment.aliased_memory = memory;
+
+	// The image does not own its handle, the deleter destroys it before releasing the memory it is bound to
+	auto image = new core::Image{device, handle, attachment.extent, attachment.format, attachment.usage};
+
+	return std::shared_ptr<core::Image>(image, [device_handle = device.get_handle(), handle, memory](core::Image *image) {
+		delete image;
+		vkDestroyImage(device_handle, handle, nullptr);
+	});
+}
+
+bool TransientAttachmentAllocator::is_lazy_allocation_supported() const
+{
+	return lazy_allocation_supported;
+}
+
+TransientAttachmentStats TransientAttachmentAllocator::get_stats() const
+{
+	TransientAttachmentStats stats;
+
+	std::unordered_set<const AliasedMemory *> counted_memory;
+
+	for (auto &it : attachments)
+	{
+		auto &attachment = it.second;
+		if (attachment.image.expired())
+		{
+			continue;
+		}
+
+		stats.image_count++;
+		stats.frame_memory_size += attachment.size;
+
+		if (auto memory = attachment.aliased_memory.lock())
+		{
+			if (counted_memory.insert(memory.get()).second)
+			{
+				stats.memory_size += memory->size;
+			}
+		}
+		else
+		{
+			stats.memory_size += attachment.size;
+
+			if (attachment.lazy)
+			{
+				stats.lazy_memory_size += attachment.size;
+			}
+		}
+	}
+
+	return stats;
+}
+}        // namespace vkb
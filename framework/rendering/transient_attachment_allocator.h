@@ -0,0 +1,150 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "common/helpers.h"
+#include "common/vk_common.h"
+#include "core/image.h"
+
+namespace vkb
+{
+class Device;
+
+/**
+ * @brief Memory of the attachments of a TransientAttachmentAllocator
+ */
+struct TransientAttachmentStats
+{
+	/// Images in use by render targets
+	uint32_t image_count{0};
+
+	/// Device memory bound to the images, memory aliased by several images counted once
+	VkDeviceSize memory_size{0};
+
+	/// Part of memory_size which is lazily allocated, only committed for the attachments which are stored
+	VkDeviceSize lazy_memory_size{0};
+
+	/// Memory of the images with an allocation each, what every frame in flight took before they were shared
+	VkDeviceSize frame_memory_size{0};
+};
+
+/**
+ * @brief Creates the images of attachments whose contents do not outlive the frame, such as G-buffers.
+ *
+ *        An image is shared by the render targets of all the frames in flight: requesting an attachment
+ *        returns the image already in use for it, as long as its description matches. The frames are
+ *        submitted to the same queue, so the first use of the image in a frame only has to wait for its
+ *        uses by the previous frame, with a barrier from the stages which use it.
+ *
+ *        Transient attachments are created in lazily allocated memory when the device has some, the tiles
+ *        are then only backed by memory if the attachment is stored. Otherwise images of the same alias
+ *        group are bound to the same memory, their uses in a frame must not overlap, and the first use of
+ *        each must also wait for the uses of the others, discarding the contents with an undefined layout.
+ */
+class TransientAttachmentAllocator
+{
+  public:
+	explicit TransientAttachmentAllocator(Device const &device);
+
+	TransientAttachmentAllocator(const TransientAttachmentAllocator &) = delete;
+
+	TransientAttachmentAllocator(TransientAttachmentAllocator &&) = delete;
+
+	~TransientAttachmentAllocator() = default;
+
+	TransientAttachmentAllocator &operator=(const TransientAttachmentAllocator &) = delete;
+
+	TransientAttachmentAllocator &operator=(TransientAttachmentAllocator &&) = delete;
+
+	/**
+	 * @brief Requests the image of an attachment, created if the attachment has no image in use yet or
+	 *        if its description changed. The image lives as long as the render targets referring to it
+	 * @param name Name of the attachment, attachments used at the same time must have different names
+	 * @param alias_group Images of the same non-empty group may alias their memory
+	 */
+	std::shared_ptr<core::Image> request_image(const std::string &name,
+	                                           const VkExtent3D  &extent,
+	                                           VkFormat           format,
+	                                           VkImageUsageFlags  usage,
+	                                           const std::string &alias_group = {});
+
+	/**
+	 * @return Whether transient attachments are created in lazily allocated memory
+	 */
+	bool is_lazy_allocation_supported() const;
+
+	TransientAttachmentStats get_stats() const;
+
+  private:
+	/// Memory bound to the images of an alias group
+	struct AliasedMemory
+	{
+		AliasedMemory(Device const &device, const VkMemoryRequirements &requirements);
+
+		~AliasedMemory();
+
+		Device const &device;
+
+		VmaAllocation allocation{VK_NULL_HANDLE};
+
+		VkDeviceSize size{0};
+
+		uint32_t memory_type{0};
+	};
+
+	struct AttachmentImage
+	{
+		std::weak_ptr<core::Image> image;
+
+		VkExtent3D extent{};
+
+		VkFormat format{VK_FORMAT_UNDEFINED};
+
+		VkImageUsageFlags usage{0};
+
+		std::string alias_group;
+
+		/// Size of the memory the image requires
+		VkDeviceSize size{0};
+
+		bool lazy{false};
+
+		/// Memory the image is bound to, if it aliases the memory of its group
+		std::weak_ptr<AliasedMemory> aliased_memory;
+	};
+
+	/**
+	 * @brief Creates an image bound to the memory of its alias group, the memory is replaced by a larger one
+	 *        if it cannot hold the image, and kept alive by the images bound to it
+	 */
+	std::shared_ptr<core::Image> create_aliased_image(AttachmentImage &attachment);
+
+	Device const &device;
+
+	bool lazy_allocation_supported{false};
+
+	std::unordered_map<std::string, AttachmentImage> attachments;
+
+	/// Memory the next images of every alias group are bound to
+	std::unordered_map<std::string, std::weak_ptr<AliasedMemory>> alias_groups;
+};
+}        // namespace vkb
@@ -17,13 +17,38 @@
 
 #include "resource_binding_state.h"
 
+#include <algorithm>
+#include <tuple>
+
+#include "common/helpers.h"
+
 namespace vkb
 {
+namespace
+{
+size_t hash_resource(uint32_t binding, uint32_t array_element, const ResourceInfo &resource_info)
+{
+	size_t hash = 0;
+	hash_combine(hash, binding);
+	hash_combine(hash, array_element);
+	hash_combine(hash, resource_info.buffer ? resource_info.buffer->get_handle() : VK_NULL_HANDLE);
+	hash_combine(hash, resource_info.range);
+	hash_combine(hash, resource_info.image_view ? resource_info.image_view->get_handle() : VK_NULL_HANDLE);
+	hash_combine(hash, resource_info.sampler ? resource_info.sampler->get_handle() : VK_NULL_HANDLE);
+
+	// The offset is combined separately, so that it can be removed for dynamic buffers
+	return hash ^ ResourceSet::hash_offset(binding, array_element, resource_info.offset);
+}
+}        // namespace
+
 void ResourceBindingState::reset()
 {
 	clear_dirty();
 
-	resource_sets.clear();
+	for (auto &resource_set : resource_sets)
+	{
+		resource_set.reset();
+	}
 }
 
 bool ResourceBindingState::is_dirty()
@@ -38,47 +63,62 @@ void ResourceBindingState::clear_dirty()
 
 void ResourceBindingState::clear_dirty(uint32_t set)
 {
-	resource_sets[set].clear_dirty();
+	get_resource_set(set).clear_dirty();
 }
 
 void ResourceBindingState::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_buffer(buffer, offset, range, binding, array_element);
+	get_resource_set(set).bind_buffer(buffer, offset, range, binding, array_element);
 
 	dirty = true;
 }
 
 void ResourceBindingState::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_image(image_view, sampler, binding, array_element);
+	get_resource_set(set).bind_image(image_view, sampler, binding, array_element);
 
 	dirty = true;
 }
 
 void ResourceBindingState::bind_image(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_image(image_view, binding, array_element);
+	get_resource_set(set).bind_image(image_view, binding, array_element);
 
 	dirty = true;
 }
 
 void ResourceBindingState::bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_input(image_view, binding, array_element);
+	get_resource_set(set).bind_input(image_view, binding, array_element);
 
 	dirty = true;
 }
 
-const std::unordered_map<uint32_t, ResourceSet> &ResourceBindingState::get_resource_sets()
+const std::array<ResourceSet, max_bound_descriptor_sets> &ResourceBindingState::get_resource_sets()
 {
 	return resource_sets;
 }
 
+ResourceSet &ResourceBindingState::get_resource_set(uint32_t set)
+{
+	assert(set < max_bound_descriptor_sets && "Descriptor set index is out of bounds");
+
+	return resource_sets[set];
+}
+
 void ResourceSet::reset()
 {
 	clear_dirty();
 
-	resource_bindings.clear();
+	// Only the bound bindings are cleared, which keeps resetting cheap
+	for (uint32_t mask = bound_bindings; mask != 0; mask &= mask - 1)
+	{
+		bindings[get_lowest_bit(mask)] = {};
+	}
+
+	bound_bindings = 0;
+	array_elements.clear();
+	hash = 0;
 }
 
 bool ResourceSet::is_dirty() const
@@ -91,50 +131,111 @@ void ResourceSet::clear_dirty()
 	dirty = false;
 }
 
-void ResourceSet::clear_dirty(uint32_t binding, uint32_t array_element)
+bool ResourceSet::empty() const
 {
-	resource_bindings[binding][array_element].dirty = false;
+	return bound_bindings == 0 && array_elements.empty();
 }
 
 void ResourceSet::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding, uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty  = true;
-	resource_bindings[binding][array_element].buffer = &buffer;
-	resource_bindings[binding][array_element].offset = offset;
-	resource_bindings[binding][array_element].range  = range;
-
-	dirty = true;
+	auto &resource_info  = begin_bind(binding, array_element);
+	resource_info.buffer = &buffer;
+	resource_info.offset = offset;
+	resource_info.range  = range;
+	end_bind(binding, array_element, resource_info);
 }
 
 void ResourceSet::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t binding, uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty      = true;
-	resource_bindings[binding][array_element].image_view = &image_view;
-	resource_bindings[binding][array_element].sampler    = &sampler;
-
-	dirty = true;
+	auto &resource_info      = begin_bind(binding, array_element);
+	resource_info.image_view = &image_view;
+	resource_info.sampler    = &sampler;
+	end_bind(binding, array_element, resource_info);
 }
 
 void ResourceSet::bind_image(const core::ImageView &image_view, uint32_t binding, uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty      = true;
-	resource_bindings[binding][array_element].image_view = &image_view;
-	resource_bindings[binding][array_element].sampler    = nullptr;
-
-	dirty = true;
+	auto &resource_info      = begin_bind(binding, array_element);
+	resource_info.image_view = &image_view;
+	resource_info.sampler    = nullptr;
+	end_bind(binding, array_element, resource_info);
 }
 
 void ResourceSet::bind_input(const core::ImageView &image_view, const uint32_t binding, const uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty      = true;
-	resource_bindings[binding][array_element].image_view = &image_view;
+	auto &resource_info      = begin_bind(binding, array_element);
+	resource_info.image_view = &image_view;
+	end_bind(binding, array_element, resource_info);
+}
+
+size_t ResourceSet::get_hash() const
+{
+	return hash;
+}
 
-	dirty = true;
+size_t ResourceSet::hash_offset(uint32_t binding, uint32_t array_element, VkDeviceSize offset)
+{
+	size_t hash = 0;
+	hash_combine(hash, offset);
+	hash_combine(hash, binding);
+	hash_combine(hash, array_element);
+	return hash;
 }
 
-const BindingMap<ResourceInfo> &ResourceSet::get_resource_bindings() const
+uint32_t ResourceSet::get_lowest_bit(uint32_t mask)
 {
-	return resource_bindings;
+	uint32_t index = 0;
+	while ((mask & 1u) == 0)
+	{
+		mask >>= 1;
+		index++;
+	}
+	return index;
 }
 
+ResourceInfo &ResourceSet::begin_bind(uint32_t binding, uint32_t array_element)
+{
+	dirty = true;
+
+	ResourceInfo *resource_info = nullptr;
+	bool          bound         = false;
+
+	if (binding < max_set_bindings && array_element == 0)
+	{
+		uint32_t bit = 1u << binding;
+
+		bound         = (bound_bindings & bit) != 0;
+		resource_info = &bindings[binding];
+
+		bound_bindings |= bit;
+	}
+	else
+	{
+		auto it = std::lower_bound(array_elements.begin(), array_elements.end(), std::make_pair(binding, array_element),
+		                           [](const ArrayElement &element, const std::pair<uint32_t, uint32_t> &key) {
+			                           return std::tie(element.binding, element.array_element) < std::tie(key.first, key.second);
+		                           });
+
+		bound = it != array_elements.end() && it->binding == binding && it->array_element == array_element;
+		if (!bound)
+		{
+			it = array_elements.insert(it, {binding, array_element, {}});
+		}
+
+		resource_info = &it->resource_info;
+	}
+
+	// The hashes of the resources are combined with a xor, so that a resource can be removed from the hash
+	if (bound)
+	{
+		hash ^= hash_resource(binding, array_element, *resource_info);
+	}
+
+	return *resource_info;
+}
+
+void ResourceSet::end_bind(uint32_t binding, uint32_t array_element, const ResourceInfo &resource_info)
+{
+	hash ^= hash_resource(binding, array_element, resource_info);
+}
 }        // namespace vkb
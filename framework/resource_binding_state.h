@@ -17,6 +17,9 @@
 
 #pragma once
 
+#include <array>
+#include <vector>
+
 #include "common/vk_common.h"
 #include "core/buffer.h"
 #include "core/image_view.h"
@@ -24,6 +27,12 @@
 
 namespace vkb
 {
+/// Descriptor sets tracked by a command buffer, the least every device supports
+constexpr uint32_t max_bound_descriptor_sets = 4;
+
+/// Bindings of a set whose first array element is tracked in a fixed-size array, others are kept sorted aside
+constexpr uint32_t max_set_bindings = 32;
+
 /**
  * @brief A resource info is a struct containing the actual resource data.
  *
@@ -31,8 +40,6 @@ namespace vkb
  */
 struct ResourceInfo
 {
-	bool dirty{false};
-
 	const core::Buffer *buffer{nullptr};
 
 	VkDeviceSize offset{0};
@@ -48,7 +55,9 @@ struct ResourceInfo
  * @brief A resource set is a set of bindings containing resources that were bound 
  *        by a command buffer.
  *
- * The ResourceSet has a one to one mapping with a DescriptorSet.
+ * The ResourceSet has a one to one mapping with a DescriptorSet. The first array element of the
+ * low bindings lives in a fixed-size array, and the hash of the bound resources is updated on
+ * every bind, so that neither binding nor looking the descriptor set up allocates or rehashes.
  */
 class ResourceSet
 {
@@ -59,7 +68,7 @@ class ResourceSet
 
 	void clear_dirty();
 
-	void clear_dirty(uint32_t binding, uint32_t array_element);
+	bool empty() const;
 
 	void bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding, uint32_t array_element);
 
@@ -69,12 +78,82 @@ class ResourceSet
 
 	void bind_input(const core::ImageView &image_view, uint32_t binding, uint32_t array_element);
 
-	const BindingMap<ResourceInfo> &get_resource_bindings() const;
+	/**
+	 * @return Hash of the bound resources, independent of the order they were bound in
+	 */
+	size_t get_hash() const;
+
+	/**
+	 * @brief Part of the hash of a binding depending on its offset, a xor removes it from the hash of the set,
+	 *        so that the buffers bound with dynamic offsets map to the same descriptor set whatever their offset
+	 */
+	static size_t hash_offset(uint32_t binding, uint32_t array_element, VkDeviceSize offset);
+
+	/**
+	 * @brief Calls func(binding, array_element, resource_info) for every bound resource, ordered by binding then array element
+	 */
+	template <class Func>
+	void for_each_binding(Func &&func) const
+	{
+		auto element_it = array_elements.begin();
+
+		for (uint32_t mask = bound_bindings; mask != 0; mask &= mask - 1)
+		{
+			uint32_t binding = get_lowest_bit(mask);
+
+			// Elements kept aside of the bindings before this one, then the array elements of this one
+			for (; element_it != array_elements.end() && element_it->binding < binding; ++element_it)
+			{
+				func(element_it->binding, element_it->array_element, element_it->resource_info);
+			}
+
+			func(binding, 0u, bindings[binding]);
+
+			for (; element_it != array_elements.end() && element_it->binding == binding; ++element_it)
+			{
+				func(element_it->binding, element_it->array_element, element_it->resource_info);
+			}
+		}
+
+		for (; element_it != array_elements.end(); ++element_it)
+		{
+			func(element_it->binding, element_it->array_element, element_it->resource_info);
+		}
+	}
 
   private:
+	struct ArrayElement
+	{
+		uint32_t binding;
+
+		uint32_t array_element;
+
+		ResourceInfo resource_info;
+	};
+
+	static uint32_t get_lowest_bit(uint32_t mask);
+
+	/**
+	 * @brief Gets the resource of a binding, removing it from the hash until the binding is done
+	 */
+	ResourceInfo &begin_bind(uint32_t binding, uint32_t array_element);
+
+	/**
+	 * @brief Adds the updated resource of a binding to the hash
+	 */
+	void end_bind(uint32_t binding, uint32_t array_element, const ResourceInfo &resource_info);
+
 	bool dirty{false};
 
-	BindingMap<ResourceInfo> resource_bindings;
+	size_t hash{0};
+
+	/// Bindings whose first array element is bound
+	uint32_t bound_bindings{0};
+
+	std::array<ResourceInfo, max_set_bindings> bindings;
+
+	/// Other array elements and bindings, sorted by binding then array element
+	std::vector<ArrayElement> array_elements;
 };
 
 /**
@@ -102,11 +181,13 @@ class ResourceBindingState
 
 	void bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element);
 
-	const std::unordered_map<uint32_t, ResourceSet> &get_resource_sets();
+	const std::array<ResourceSet, max_bound_descriptor_sets> &get_resource_sets();
 
   private:
+	ResourceSet &get_resource_set(uint32_t set);
+
 	bool dirty{false};
 
-	std::unordered_map<uint32_t, ResourceSet> resource_sets;
+	std::array<ResourceSet, max_bound_descriptor_sets> resource_sets;
 };
 }        // namespace vkb
@@ -25,12 +25,24 @@ namespace vkb
 namespace
 {
 template <class T, class... A>
-T &request_resource(Device &device, ResourceRecord &recorder, std::mutex &resource_mutex, std::unordered_map<std::size_t, T> &resources, A &... args)
+T &request_resource(Device &device, ResourceRecord &recorder, std::mutex &resource_mutex, std::unordered_map<std::size_t, T> &resources, ConcurrentLookupTable<T> &lookup, A &... args)
 {
+	std::size_t hash{0U};
+	hash_param(hash, args...);
+
+	// Cache hits do not lock, which would serialize the threads recording command buffers
+	if (T *res = lookup.find(hash))
+	{
+		return *res;
+	}
+
 	std::lock_guard<std::mutex> guard(resource_mutex);
 
 	auto &res = request_resource(device, &recorder, resources, args...);
 
+	// The map node is stable, it stays valid until the cache is cleared
+	lookup.insert(hash, &res);
+
 	return res;
 }
 }        // namespace
@@ -60,49 +72,51 @@ void ResourceCache::set_pipeline_cache(VkPipelineCache new_pipeline_cache)
 ShaderModule &ResourceCache::request_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant)
 {
 	std::string entry_point{"main"};
-	return request_resource(device, recorder, shader_module_mutex, state.shader_modules, stage, glsl_source, entry_point, shader_variant);
+	return request_resource(device, recorder, shader_module_mutex, state.shader_modules, lookup.shader_modules, stage, glsl_source, entry_point, shader_variant);
 }
 
 PipelineLayout &ResourceCache::request_pipeline_layout(const std::vector<ShaderModule *> &shader_modules)
 {
-	return request_resource(device, recorder, pipeline_layout_mutex, state.pipeline_layouts, shader_modules);
+	return request_resource(device, recorder, pipeline_layout_mutex, state.pipeline_layouts, lookup.pipeline_layouts, shader_modules);
 }
 
 DescriptorSetLayout &ResourceCache::request_descriptor_set_layout(const uint32_t                     set_index,
                                                                   const std::vector<ShaderModule *> &shader_modules,
                                                                   const std::vector<ShaderResource> &set_resources)
 {
-	return request_resource(device, recorder, descriptor_set_layout_mutex, state.descriptor_set_layouts, set_index, shader_modules, set_resources);
+	return request_resource(device, recorder, descriptor_set_layout_mutex, state.descriptor_set_layouts, lookup.descriptor_set_layouts, set_index, shader_modules, set_resources);
 }
 
 GraphicsPipeline &ResourceCache::request_graphics_pipeline(PipelineState &pipeline_state)
 {
-	return request_resource(device, recorder, graphics_pipeline_mutex, state.graphics_pipelines, pipeline_cache, pipeline_state);
+	return request_resource(device, recorder, graphics_pipeline_mutex, state.graphics_pipelines, lookup.graphics_pipelines, pipeline_cache, pipeline_state);
 }
 
 ComputePipeline &ResourceCache::request_compute_pipeline(PipelineState &pipeline_state)
 {
-	return request_resource(device, recorder, compute_pipeline_mutex, state.compute_pipelines, pipeline_cache, pipeline_state);
+	return request_resource(device, recorder, compute_pipeline_mutex, state.compute_pipelines, lookup.compute_pipelines, pipeline_cache, pipeline_state);
 }
 
 DescriptorSet &ResourceCache::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos)
 {
-	auto &descriptor_pool = request_resource(device, recorder, descriptor_set_mutex, state.descriptor_pools, descriptor_set_layout);
-	return request_resource(device, recorder, descriptor_set_mutex, state.descriptor_sets, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+	auto &descriptor_pool = request_resource(device, recorder, descriptor_set_mutex, state.descriptor_pools, lookup.descriptor_pools, descriptor_set_layout);
+	return request_resource(device, recorder, descriptor_set_mutex, state.descriptor_sets, lookup.descriptor_sets, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
 }
 
 RenderPass &ResourceCache::request_render_pass(const std::vector<Attachment> &attachments, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<SubpassInfo> &subpasses)
 {
-	return request_resource(device, recorder, render_pass_mutex, state.render_passes, attachments, load_store_infos, subpasses);
+	return request_resource(device, recorder, render_pass_mutex, state.render_passes, lookup.render_passes, attachments, load_store_infos, subpasses);
 }
 
 Framebuffer &ResourceCache::request_framebuffer(const RenderTarget &render_target, const RenderPass &render_pass)
 {
-	return request_resource(device, recorder, framebuffer_mutex, state.framebuffers, render_target, render_pass);
+	return request_resource(device, recorder, framebuffer_mutex, state.framebuffers, lookup.framebuffers, render_target, render_pass);
 }
 
 void ResourceCache::clear_pipelines()
 {
+	lookup.graphics_pipelines.clear();
+	lookup.compute_pipelines.clear();
 	state.graphics_pipelines.clear();
 	state.compute_pipelines.clear();
 }
@@ -175,6 +189,12 @@ void ResourceCache::update_descriptor_sets(const std::vector<core::ImageView> &o
 		                       0, nullptr);
 	}
 
+	// The moved descriptor sets are looked up again from the state
+	if (!matches.empty())
+	{
+		lookup.descriptor_sets.clear();
+	}
+
 	// Delete old entries (moved out descriptor sets)
 	for (auto &match : matches)
 	{
@@ -194,11 +214,17 @@ void ResourceCache::update_descriptor_sets(const std::vector<core::ImageView> &o
 
 void ResourceCache::clear_framebuffers()
 {
+	lookup.framebuffers.clear();
 	state.framebuffers.clear();
 }
 
 void ResourceCache::clear()
 {
+	lookup.shader_modules.clear();
+	lookup.pipeline_layouts.clear();
+	lookup.descriptor_sets.clear();
+	lookup.descriptor_set_layouts.clear();
+	lookup.render_passes.clear();
 	state.shader_modules.clear();
 	state.pipeline_layouts.clear();
 	state.descriptor_sets.clear();
@@ -21,6 +21,8 @@
 #include <unordered_map>
 #include <vector>
 
+#include <core/util/concurrent_lookup_table.hpp>
+
 #include "common/helpers.h"
 #include "core/descriptor_pool.h"
 #include "core/descriptor_set.h"
@@ -64,6 +66,30 @@ struct ResourceCacheState
 	std::unordered_map<std::size_t, Framebuffer> framebuffers;
 };
 
+/**
+ * @brief Lock-free lookup tables of the objects of the Resource Cache, keyed by the same hashes as its state
+ */
+struct ResourceCacheLookup
+{
+	ConcurrentLookupTable<ShaderModule> shader_modules;
+
+	ConcurrentLookupTable<PipelineLayout> pipeline_layouts;
+
+	ConcurrentLookupTable<DescriptorSetLayout> descriptor_set_layouts;
+
+	ConcurrentLookupTable<DescriptorPool> descriptor_pools;
+
+	ConcurrentLookupTable<RenderPass> render_passes;
+
+	ConcurrentLookupTable<GraphicsPipeline> graphics_pipelines;
+
+	ConcurrentLookupTable<ComputePipeline> compute_pipelines;
+
+	ConcurrentLookupTable<DescriptorSet> descriptor_sets;
+
+	ConcurrentLookupTable<Framebuffer> framebuffers;
+};
+
 /**
  * @brief Cache all sorts of Vulkan objects specific to a Vulkan device.
  * Supports serialization and deserialization of cached resources.
@@ -75,6 +101,10 @@ struct ResourceCacheState
  * the cache on app startup by creating all necessary objects.
  * The cache holds pointers to objects and has a mapping from such pointers to hashes.
  * It can only be destroyed in bulk, single elements cannot be removed.
+ *
+ * Requests of objects which are already cached do not lock: they are looked up in lock-free tables,
+ * and only the creation of new objects is serialized per type of object. Clearing the cache must not
+ * run concurrently with requests.
  */
 class ResourceCache
 {
@@ -142,6 +172,8 @@ class ResourceCache
 
 	ResourceCacheState state;
 
+	ResourceCacheLookup lookup;
+
 	std::mutex descriptor_set_mutex;
 
 	std::mutex pipeline_layout_mutex;
@@ -0,0 +1,73 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "component_pool.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace vkb
+{
+namespace sg
+{
+uint32_t get_component_type_id(const std::type_index &type)
+{
+	static std::mutex                                   ids_mutex;
+	static std::unordered_map<std::type_index, uint32_t> ids;
+
+	std::lock_guard<std::mutex> lock{ids_mutex};
+
+	auto it = ids.find(type);
+	if (it == ids.end())
+	{
+		it = ids.emplace(type, static_cast<uint32_t>(ids.size())).first;
+	}
+
+	return it->second;
+}
+
+void ComponentPool::add(std::unique_ptr<Component> &&component)
+{
+	components.push_back(std::move(component));
+}
+
+void ComponentPool::reset(std::vector<std::unique_ptr<Component>> &&new_components)
+{
+	components = std::move(new_components);
+	generation++;
+}
+
+std::vector<std::unique_ptr<Component>> ComponentPool::release()
+{
+	generation++;
+
+	auto released = std::move(components);
+	components.clear();
+	return released;
+}
+
+const std::vector<std::unique_ptr<Component>> &ComponentPool::get_components() const
+{
+	return components;
+}
+
+uint32_t ComponentPool::get_generation() const
+{
+	return generation;
+}
+}        // namespace sg
+}        // namespace vkb
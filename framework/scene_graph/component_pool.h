@@ -0,0 +1,267 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <typeindex>
+#include <vector>
+
+#include "scene_graph/component.h"
+
+namespace vkb
+{
+namespace sg
+{
+/**
+ * @brief Gets the dense index of a component type, assigned on first use
+ * @param type The type returned by Component::get_type()
+ */
+uint32_t get_component_type_id(const std::type_index &type);
+
+/**
+ * @brief Dense index of a component type, looked up once per type
+ */
+template <class T>
+uint32_t get_component_type_id()
+{
+	static const uint32_t id = get_component_type_id(typeid(T));
+	return id;
+}
+
+/**
+ * @brief Refers to a component of a scene by its index in the pool of its type.
+ *        The generation of the pool is stamped in the handle, so that a handle
+ *        resolves to nothing once the pool has been replaced or cleared.
+ */
+template <class T>
+struct ComponentHandle
+{
+	uint32_t index{~0u};
+
+	uint32_t generation{0};
+};
+
+/**
+ * @brief Owns the components of one type, contiguous and in insertion order.
+ *        Appending keeps the existing indices, replacing the components starts a new generation.
+ *
+ *        The pool holds pointers to the components rather than the components themselves: a pool
+ *        holds the derived types of its type too (e.g. PerspectiveCamera and OrthographicCamera in
+ *        the Camera pool, the scripts in the Script pool), and nodes and other components refer to
+ *        components through raw pointers, which must not move when the pool grows. Only the pointer
+ *        array is contiguous, which is what the views iterate without allocating.
+ */
+class ComponentPool
+{
+  public:
+	void add(std::unique_ptr<Component> &&component);
+
+	/**
+	 * @brief Replaces all the components of the pool, invalidating its handles
+	 */
+	void reset(std::vector<std::unique_ptr<Component>> &&components);
+
+	/**
+	 * @brief Moves all the components out of the pool, invalidating its handles
+	 */
+	std::vector<std::unique_ptr<Component>> release();
+
+	const std::vector<std::unique_ptr<Component>> &get_components() const;
+
+	uint32_t get_generation() const;
+
+  private:
+	std::vector<std::unique_ptr<Component>> components;
+
+	uint32_t generation{1};
+};
+
+/**
+ * @brief Non-owning view of the components of a pool, cast to their type without RTTI.
+ *        Every component of a pool has the type of the pool or derives from it.
+ *        Like an iterator, a view is invalidated when components of its type are added or replaced.
+ */
+template <class T>
+class ComponentView
+{
+  public:
+	class Iterator
+	{
+	  public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type        = T *;
+		using difference_type   = std::ptrdiff_t;
+		using pointer           = T *const *;
+		using reference         = T *;
+
+		Iterator() = default;
+
+		explicit Iterator(const std::unique_ptr<Component> *component) :
+		    component{component}
+		{}
+
+		T *operator*() const
+		{
+			return static_cast<T *>(component->get());
+		}
+
+		T *operator[](difference_type offset) const
+		{
+			return static_cast<T *>(component[offset].get());
+		}
+
+		Iterator &operator++()
+		{
+			++component;
+			return *this;
+		}
+
+		Iterator operator++(int)
+		{
+			return Iterator{component++};
+		}
+
+		Iterator &operator--()
+		{
+			--component;
+			return *this;
+		}
+
+		Iterator operator--(int)
+		{
+			return Iterator{component--};
+		}
+
+		Iterator &operator+=(difference_type offset)
+		{
+			component += offset;
+			return *this;
+		}
+
+		Iterator &operator-=(difference_type offset)
+		{
+			component -= offset;
+			return *this;
+		}
+
+		Iterator operator+(difference_type offset) const
+		{
+			return Iterator{component + offset};
+		}
+
+		Iterator operator-(difference_type offset) const
+		{
+			return Iterator{component - offset};
+		}
+
+		difference_type operator-(const Iterator &other) const
+		{
+			return component - other.component;
+		}
+
+		bool operator==(const Iterator &other) const
+		{
+			return component == other.component;
+		}
+
+		bool operator!=(const Iterator &other) const
+		{
+			return component != other.component;
+		}
+
+		bool operator<(const Iterator &other) const
+		{
+			return component < other.component;
+		}
+
+		bool operator>(const Iterator &other) const
+		{
+			return component > other.component;
+		}
+
+		bool operator<=(const Iterator &other) const
+		{
+			return component <= other.component;
+		}
+
+		bool operator>=(const Iterator &other) const
+		{
+			return component >= other.component;
+		}
+
+	  private:
+		const std::unique_ptr<Component> *component{nullptr};
+	};
+
+	ComponentView() = default;
+
+	explicit ComponentView(const std::vector<std::unique_ptr<Component>> &components) :
+	    first{components.data()},
+	    count{components.size()}
+	{}
+
+	Iterator begin() const
+	{
+		return Iterator{first};
+	}
+
+	Iterator end() const
+	{
+		return Iterator{first + count};
+	}
+
+	size_t size() const
+	{
+		return count;
+	}
+
+	bool empty() const
+	{
+		return count == 0;
+	}
+
+	T *operator[](size_t index) const
+	{
+		assert(index < count);
+		return static_cast<T *>(first[index].get());
+	}
+
+	T *front() const
+	{
+		return (*this)[0];
+	}
+
+	/**
+	 * @brief Copies the pointers, for callers which keep them past the lifetime of the view
+	 */
+	std::vector<T *> to_vector() const
+	{
+		return std::vector<T *>(begin(), end());
+	}
+
+  private:
+	const std::unique_ptr<Component> *first{nullptr};
+
+	size_t count{0};
+};
+}        // namespace sg
+}        // namespace vkb
@@ -68,16 +68,19 @@ void AABB::update(const std::vector<glm::vec3> &vertex_data, const std::vector<u
 
 void AABB::transform(glm::mat4 &transform)
 {
-	min = max = glm::vec4(min, 1.0f) * transform;
-
-	// Update bounding box for the remaining 7 corners of the box
-	update(glm::vec4(min.x, min.y, max.z, 1.0f) * transform);
-	update(glm::vec4(min.x, max.y, min.z, 1.0f) * transform);
-	update(glm::vec4(min.x, max.y, max.z, 1.0f) * transform);
-	update(glm::vec4(max.x, min.y, min.z, 1.0f) * transform);
-	update(glm::vec4(max.x, min.y, max.z, 1.0f) * transform);
-	update(glm::vec4(max.x, max.y, min.z, 1.0f) * transform);
-	update(glm::vec4(max, 1.0f) * transform);
+	// Transform the center and project the half extents onto the new axes,
+	// which yields the same box as transforming all 8 corners
+	glm::vec3 center  = transform * glm::vec4(get_center(), 1.0f);
+	glm::vec3 extents = (max - min) * 0.5f;
+
+	glm::mat3 abs_basis{glm::abs(glm::vec3(transform[0])),
+	                    glm::abs(glm::vec3(transform[1])),
+	                    glm::abs(glm::vec3(transform[2]))};
+
+	glm::vec3 world_extents = abs_basis * extents;
+
+	min = center - world_extents;
+	max = center + world_extents;
 }
 
 glm::vec3 AABB::get_scale() const
@@ -0,0 +1,49 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <typeinfo>
+
+#include "core/buffer.h"
+#include "scene_graph/component.h"
+
+namespace vkb
+{
+namespace sg
+{
+/**
+ * @brief Device local buffer holding the vertices or the indices of many submeshes of a scene,
+ *        each of which refers to its ranges of the buffer
+ */
+class GeometryBuffer : public Component
+{
+  public:
+	GeometryBuffer(const std::string &name, core::Buffer &&buffer);
+
+	GeometryBuffer(GeometryBuffer &&other) = default;
+
+	virtual ~GeometryBuffer() = default;
+
+	virtual std::type_index get_type() override;
+
+	core::Buffer buffer;
+};
+}        // namespace sg
+}        // namespace vkb
@@ -92,6 +92,21 @@ void SubMesh::compute_shader_variant()
 		std::transform(attrib_name.begin(), attrib_name.end(), attrib_name.begin(), ::toupper);
 		shader_variant.add_define("HAS_" + attrib_name);
 	}
+
+	// Attributes packed at load time are decoded by the vertex shaders
+	VertexAttribute attribute;
+	if (get_attribute("position", attribute) && attribute.format == quantized_position_format)
+	{
+		shader_variant.add_define("QUANTIZED_POSITION");
+	}
+	if (get_attribute("normal", attribute) && attribute.format == octahedral_normal_format)
+	{
+		shader_variant.add_define("OCTAHEDRAL_NORMAL");
+	}
+	if (get_attribute("tangent", attribute) && attribute.format == octahedral_tangent_format)
+	{
+		shader_variant.add_define("OCTAHEDRAL_TANGENT");
+	}
 }
 
 ShaderVariant &SubMesh::get_mut_shader_variant()
@@ -23,6 +23,12 @@
 #include <unordered_map>
 #include <vector>
 
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
 #include "common/vk_common.h"
 #include "core/buffer.h"
 #include "core/shader_module.h"
@@ -34,6 +40,15 @@ namespace sg
 {
 class Material;
 
+/// Formats of the attributes packed at load time, the shader variant of a submesh selects their decoding
+constexpr VkFormat quantized_position_format = VK_FORMAT_R16G16B16A16_UNORM;
+
+/// Octahedral encoding of the normals, see encode_octahedral
+constexpr VkFormat octahedral_normal_format = VK_FORMAT_R16G16_SNORM;
+
+/// Octahedral encoding of the tangents, followed by their handedness
+constexpr VkFormat octahedral_tangent_format = VK_FORMAT_R16G16B16A16_SNORM;
+
 struct VertexAttribute
 {
 	VkFormat format = VK_FORMAT_UNDEFINED;
@@ -43,6 +58,33 @@ struct VertexAttribute
 	std::uint32_t offset = 0;
 };
 
+/**
+ * @brief Range of a buffer holding geometry of a submesh
+ */
+struct BufferRange
+{
+	const core::Buffer *buffer = nullptr;
+
+	/// Offset in bytes of the first value of the submesh in the buffer
+	VkDeviceSize offset = 0;
+
+	VkDeviceSize size = 0;
+};
+
+/**
+ * @brief Simplified version of a submesh, indexing the same vertices
+ */
+struct SubMeshLod
+{
+	/// Offset in bytes of the first index in the index buffer of the submesh
+	std::uint32_t index_offset = 0;
+
+	std::uint32_t index_count = 0;
+
+	/// Deviation of the simplified surface from the full detail one, in model space
+	float error = 0.0f;
+};
+
 class SubMesh : public Component
 {
   public:
@@ -54,15 +96,33 @@ class SubMesh : public Component
 
 	VkIndexType index_type{};
 
+	/// Offset in bytes of the first index of the submesh in the index buffer
 	std::uint32_t index_offset = 0;
 
 	std::uint32_t vertices_count = 0;
 
 	std::uint32_t vertex_indices = 0;
 
-	std::unordered_map<std::string, core::Buffer> vertex_buffers;
+	/// Index of the first vertex of the submesh in the streams it shares with the submeshes of the same vertex layout,
+	/// the base vertex drawing it from the start of those streams
+	std::uint32_t vertex_offset = 0;
+
+	/// Vertices of every attribute, usually in a buffer shared by the submeshes of the scene
+	std::unordered_map<std::string, BufferRange> vertex_buffers;
+
+	/// Index buffer, usually shared by the submeshes of the scene
+	const core::Buffer *index_buffer{nullptr};
+
+	/// Buffers holding the geometry of this submesh alone, the shared ones are owned by the scene
+	std::vector<std::unique_ptr<core::Buffer>> buffers;
+
+	/// Simplified levels of detail in order of decreasing detail, level 0 (full detail) excluded
+	std::vector<SubMeshLod> lods;
+
+	/// Scale and offset restoring the positions stored in quantized_position_format, within the bounds of the submesh
+	glm::vec3 position_scale{1.0f};
 
-	std::unique_ptr<core::Buffer> index_buffer;
+	glm::vec3 position_offset{0.0f};
 
 	void set_attribute(const std::string &name, const VertexAttribute &attribute);
 
@@ -104,7 +104,23 @@ glm::mat4 Transform::get_world_matrix()
 
 void Transform::invalidate_world_matrix()
 {
-	update_world_matrix = true;
+	update_world_matrix  = true;
+	world_matrix_changed = true;
+}
+
+bool Transform::propagate_world_matrix(const glm::mat4 &parent_world_matrix, bool parent_changed)
+{
+	if (!parent_changed && !world_matrix_changed)
+	{
+		return false;
+	}
+
+	world_matrix = parent_world_matrix * get_matrix();
+
+	update_world_matrix  = false;
+	world_matrix_changed = false;
+
+	return true;
 }
 
 void Transform::update_world_transform()
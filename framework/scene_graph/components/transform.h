@@ -73,6 +73,16 @@ class Transform : public Component
 	 */
 	void invalidate_world_matrix();
 
+	/**
+	 * @brief Recomputes the world matrix from the parent world matrix if this transform
+	 *        or one of its ancestors changed since the last call. Used by the scene to
+	 *        update every transform in a single pass, parents before children.
+	 * @param parent_world_matrix The up to date world matrix of the parent
+	 * @param parent_changed Whether the parent world matrix changed in this pass
+	 * @return True if the world matrix was recomputed
+	 */
+	bool propagate_world_matrix(const glm::mat4 &parent_world_matrix, bool parent_changed);
+
   private:
 	Node &node;
 
@@ -86,6 +96,9 @@ class Transform : public Component
 
 	bool update_world_matrix = false;
 
+	/// Set when the local transform changes, cleared by propagate_world_matrix
+	bool world_matrix_changed = false;
+
 	void update_world_transform();
 };
 
@@ -17,16 +17,33 @@
 
 #include "scene.h"
 
+#include <numeric>
 #include <queue>
 
 #include "component.h"
+#include "components/aabb.h"
+#include "components/mesh.h"
 #include "components/sub_mesh.h"
+#include "components/transform.h"
 #include "node.h"
 
 namespace vkb
 {
 namespace sg
 {
+namespace
+{
+AABB get_world_bounds(const MeshInstance &instance)
+{
+	AABB bounds{instance.mesh->get_bounds().get_min(), instance.mesh->get_bounds().get_max()};
+
+	glm::mat4 world_matrix = instance.node->get_transform().get_world_matrix();
+	bounds.transform(world_matrix);
+
+	return bounds;
+}
+}        // namespace
+
 Scene::Scene(const std::string &name) :
     name{name}
 {}
@@ -59,7 +76,7 @@ void Scene::add_child(Node &child)
 
 std::unique_ptr<Component> Scene::get_model(uint32_t index)
 {
-	auto meshes = std::move(components.at(typeid(SubMesh)));
+	auto meshes = get_pool(typeid(SubMesh)).release();
 
 	assert(index < meshes.size());
 	return std::move(meshes[index]);
@@ -71,7 +88,7 @@ void Scene::add_component(std::unique_ptr<Component> &&component, Node &node)
 
 	if (component)
 	{
-		components[component->get_type()].push_back(std::move(component));
+		get_pool(component->get_type()).add(std::move(component));
 	}
 }
 
@@ -79,24 +96,35 @@ void Scene::add_component(std::unique_ptr<Component> &&component)
 {
 	if (component)
 	{
-		components[component->get_type()].push_back(std::move(component));
+		get_pool(component->get_type()).add(std::move(component));
 	}
 }
 
 void Scene::set_components(const std::type_index &type_info, std::vector<std::unique_ptr<Component>> &&new_components)
 {
-	components[type_info] = std::move(new_components);
+	get_pool(type_info).reset(std::move(new_components));
 }
 
 const std::vector<std::unique_ptr<Component>> &Scene::get_components(const std::type_index &type_info) const
 {
-	return components.at(type_info);
+	return component_pools.at(get_component_type_id(type_info)).get_components();
 }
 
 bool Scene::has_component(const std::type_index &type_info) const
 {
-	auto component = components.find(type_info);
-	return (component != components.end() && !component->second.empty());
+	auto pool = find_pool(get_component_type_id(type_info));
+	return pool && !pool->get_components().empty();
+}
+
+ComponentPool &Scene::get_pool(const std::type_index &type_info)
+{
+	uint32_t type_id = get_component_type_id(type_info);
+	if (type_id >= component_pools.size())
+	{
+		component_pools.resize(type_id + 1);
+	}
+
+	return component_pools[type_id];
 }
 
 Node *Scene::find_node(const std::string &node_name)
@@ -135,5 +163,198 @@ Node &Scene::get_root_node()
 {
 	return *root;
 }
+
+void Scene::build_transform_order()
+{
+	constexpr uint32_t no_parent = ~0u;
+
+	// Sort the nodes by their depth in the hierarchy, which guarantees parents
+	// come first. Parents are followed through the parent pointers, as some nodes
+	// (e.g. lights attached to a node) are listed as children of the root instead.
+	std::vector<uint32_t> depths(nodes.size(), 0);
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		for (auto parent = nodes[i]->get_parent(); parent; parent = parent->get_parent())
+		{
+			depths[i]++;
+		}
+	}
+
+	std::vector<uint32_t> order(nodes.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&depths](uint32_t a, uint32_t b) { return depths[a] < depths[b]; });
+
+	std::unordered_map<const Node *, uint32_t> node_indices;
+	for (uint32_t i = 0; i < order.size(); i++)
+	{
+		node_indices[nodes[order[i]].get()] = i;
+	}
+
+	transform_order.resize(order.size());
+	transform_parents.resize(order.size());
+	world_matrices.resize(order.size());
+	world_matrix_changed.assign(order.size(), 0);
+
+	for (uint32_t i = 0; i < order.size(); i++)
+	{
+		auto &node = *nodes[order[i]];
+
+		transform_order[i] = &node.get_transform();
+		world_matrices[i]  = node.get_transform().get_world_matrix();
+
+		auto parent_it       = node.get_parent() ? node_indices.find(node.get_parent()) : node_indices.end();
+		transform_parents[i] = parent_it != node_indices.end() ? parent_it->second : no_parent;
+	}
+
+	ordered_node_count = nodes.size();
+
+	if (bvh_built)
+	{
+		map_instance_transforms();
+	}
+}
+
+void Scene::map_instance_transforms()
+{
+	std::unordered_map<const Transform *, uint32_t> transform_indices;
+	for (uint32_t i = 0; i < transform_order.size(); i++)
+	{
+		transform_indices[transform_order[i]] = i;
+	}
+
+	instance_transforms.resize(mesh_instances.size());
+	for (size_t i = 0; i < mesh_instances.size(); i++)
+	{
+		instance_transforms[i] = transform_indices.at(&mesh_instances[i].node->get_transform());
+	}
+}
+
+void Scene::update_world_transforms()
+{
+	constexpr uint32_t no_parent = ~0u;
+
+	if (ordered_node_count != nodes.size())
+	{
+		build_transform_order();
+	}
+
+	const glm::mat4 identity{1.0f};
+
+	changed_nodes.clear();
+	world_update_count++;
+
+	for (size_t i = 0; i < transform_order.size(); i++)
+	{
+		uint32_t parent = transform_parents[i];
+
+		bool parent_changed = parent != no_parent && world_matrix_changed[parent];
+
+		const glm::mat4 &parent_world_matrix = parent != no_parent ? world_matrices[parent] : identity;
+
+		bool changed = transform_order[i]->propagate_world_matrix(parent_world_matrix, parent_changed);
+
+		if (changed)
+		{
+			world_matrices[i] = transform_order[i]->get_world_matrix();
+			changed_nodes.push_back(&transform_order[i]->get_node());
+		}
+
+		world_matrix_changed[i] = changed;
+	}
+
+	if (bvh_built)
+	{
+		refit_bvh();
+	}
+}
+
+void Scene::build_bvh()
+{
+	mesh_instances.clear();
+
+	if (has_component<Mesh>())
+	{
+		for (auto mesh : get_components<Mesh>())
+		{
+			for (auto node : mesh->get_nodes())
+			{
+				mesh_instances.push_back({node, mesh});
+			}
+		}
+	}
+
+	std::vector<glm::vec3> mins(mesh_instances.size());
+	std::vector<glm::vec3> maxs(mesh_instances.size());
+
+	for (size_t i = 0; i < mesh_instances.size(); i++)
+	{
+		AABB bounds = get_world_bounds(mesh_instances[i]);
+
+		mins[i] = bounds.get_min();
+		maxs[i] = bounds.get_max();
+	}
+
+	bvh.build(mins, maxs);
+
+	bvh_built = true;
+
+	if (ordered_node_count != nodes.size())
+	{
+		build_transform_order();
+	}
+	else
+	{
+		map_instance_transforms();
+	}
+}
+
+void Scene::refit_bvh()
+{
+	bool refit = false;
+
+	for (size_t i = 0; i < mesh_instances.size(); i++)
+	{
+		if (!world_matrix_changed[instance_transforms[i]])
+		{
+			continue;
+		}
+
+		AABB bounds = get_world_bounds(mesh_instances[i]);
+
+		bvh.set_item_bounds(static_cast<uint32_t>(i), bounds.get_min(), bounds.get_max());
+
+		refit = true;
+	}
+
+	if (refit)
+	{
+		bvh.refit();
+	}
+}
+
+const std::vector<Node *> &Scene::get_changed_nodes() const
+{
+	return changed_nodes;
+}
+
+uint32_t Scene::get_world_update_count() const
+{
+	return world_update_count;
+}
+
+bool Scene::has_bvh() const
+{
+	return bvh_built;
+}
+
+const BVH &Scene::get_bvh() const
+{
+	return bvh;
+}
+
+const std::vector<MeshInstance> &Scene::get_mesh_instances() const
+{
+	return mesh_instances;
+}
 }        // namespace sg
 }        // namespace vkb
\ No newline at end of file
@@ -24,6 +24,15 @@
 #include <unordered_map>
 #include <vector>
 
+#include "common/error.h"
+
+VKBP_DISABLE_WARNINGS()
+#include "common/glm_common.h"
+VKBP_ENABLE_WARNINGS()
+
+#include "geometry/bvh.h"
+
+#include "scene_graph/component_pool.h"
 #include "scene_graph/components/light.h"
 #include "scene_graph/components/texture.h"
 
@@ -33,7 +42,17 @@ namespace sg
 {
 class Node;
 class Component;
+class Mesh;
 class SubMesh;
+class Transform;
+
+/// @brief A mesh drawn by one node, the items of the scene bounding volume hierarchy
+struct MeshInstance
+{
+	Node *node;
+
+	Mesh *mesh;
+};
 
 /// @brief A collection of nodes organized in a tree structure.
 ///		   It can contain more than one root node.
@@ -91,24 +110,17 @@ class Scene
 	}
 
 	/**
-	 * @return List of pointers to components casted to the given template type
+	 * @return View of the components of the given template type, which neither allocates nor casts with RTTI
 	 */
 	template <class T>
-	std::vector<T *> get_components() const
+	ComponentView<T> get_components() const
 	{
-		std::vector<T *> result;
-		if (has_component(typeid(T)))
+		if (auto pool = find_pool(get_component_type_id<T>()))
 		{
-			auto &scene_components = get_components(typeid(T));
-
-			result.resize(scene_components.size());
-			std::transform(scene_components.begin(), scene_components.end(), result.begin(),
-			               [](const std::unique_ptr<Component> &component) -> T * {
-				               return dynamic_cast<T *>(component.get());
-			               });
+			return ComponentView<T>{pool->get_components()};
 		}
 
-		return result;
+		return {};
 	}
 
 	/**
@@ -116,10 +128,55 @@ class Scene
 	 */
 	const std::vector<std::unique_ptr<Component>> &get_components(const std::type_index &type_info) const;
 
+	/**
+	 * @return Handle to the component at the given index of the components of the template type,
+	 *         which stays valid until those components are replaced or cleared
+	 */
+	template <class T>
+	ComponentHandle<T> get_component_handle(uint32_t index) const
+	{
+		ComponentHandle<T> handle{};
+
+		auto pool = find_pool(get_component_type_id<T>());
+		if (pool && index < pool->get_components().size())
+		{
+			handle.index      = index;
+			handle.generation = pool->get_generation();
+		}
+
+		return handle;
+	}
+
+	/**
+	 * @return The component the handle refers to, or nullptr if the handle is stale
+	 */
+	template <class T>
+	T *get_component(const ComponentHandle<T> &handle) const
+	{
+		auto pool = find_pool(get_component_type_id<T>());
+		if (!pool || pool->get_generation() != handle.generation || handle.index >= pool->get_components().size())
+		{
+			return nullptr;
+		}
+
+		return static_cast<T *>(pool->get_components()[handle.index].get());
+	}
+
+	/**
+	 * @return Generation of the components of the template type, which changes when they are replaced or cleared
+	 */
+	template <class T>
+	uint32_t get_component_generation() const
+	{
+		auto pool = find_pool(get_component_type_id<T>());
+		return pool ? pool->get_generation() : 0;
+	}
+
 	template <class T>
 	bool has_component() const
 	{
-		return has_component(typeid(T));
+		auto pool = find_pool(get_component_type_id<T>());
+		return pool && !pool->get_components().empty();
 	}
 
 	bool has_component(const std::type_index &type_info) const;
@@ -130,7 +187,66 @@ class Scene
 
 	Node &get_root_node();
 
+	/**
+	 * @brief Updates the world matrices of all the nodes whose transform, or the transform
+	 *        of one of their ancestors, changed since the last update. The nodes are kept in
+	 *        a flattened array ordered parents first, so this is a single linear pass.
+	 *        The order is rebuilt when nodes are added to the scene.
+	 */
+	void update_world_transforms();
+
+	/**
+	 * @return Nodes whose world matrix changed during the last update_world_transforms()
+	 */
+	const std::vector<Node *> &get_changed_nodes() const;
+
+	/**
+	 * @return Number of calls to update_world_transforms(), for readers of get_changed_nodes() to detect the updates they missed
+	 */
+	uint32_t get_world_update_count() const;
+
+	/**
+	 * @brief Builds a bounding volume hierarchy over the world bounds of every mesh instance.
+	 *        Once built, it is refitted by update_world_transforms() as nodes move.
+	 */
+	void build_bvh();
+
+	/**
+	 * @brief Updates the bounds of the instances whose world matrix changed during the last
+	 *        update and refits the hierarchy, which keeps its topology
+	 */
+	void refit_bvh();
+
+	bool has_bvh() const;
+
+	/**
+	 * @return The hierarchy, whose item indices refer to get_mesh_instances()
+	 */
+	const BVH &get_bvh() const;
+
+	const std::vector<MeshInstance> &get_mesh_instances() const;
+
   private:
+	/**
+	 * @return The pool of the components of a type, or nullptr if none was ever added
+	 */
+	const ComponentPool *find_pool(uint32_t type_id) const
+	{
+		return type_id < component_pools.size() ? &component_pools[type_id] : nullptr;
+	}
+
+	ComponentPool &get_pool(const std::type_index &type_info);
+
+	/**
+	 * @brief Flattens the node hierarchy into an array where every parent precedes its children
+	 */
+	void build_transform_order();
+
+	/**
+	 * @brief Finds the index in transform_order of the node of every mesh instance
+	 */
+	void map_instance_transforms();
+
 	std::string name;
 
 	/// List of all the nodes
@@ -138,7 +254,37 @@ class Scene
 
 	Node *root{nullptr};
 
-	std::unordered_map<std::type_index, std::vector<std::unique_ptr<Component>>> components;
+	/// Components of every type, indexed by get_component_type_id()
+	std::vector<ComponentPool> component_pools;
+
+	/// Transforms of all the nodes, every parent before its children
+	std::vector<Transform *> transform_order;
+
+	/// Index in transform_order of the parent of each transform
+	std::vector<uint32_t> transform_parents;
+
+	/// World matrices in the same order, read by the children during the update
+	std::vector<glm::mat4> world_matrices;
+
+	/// Whether each world matrix changed during the last update
+	std::vector<uint8_t> world_matrix_changed;
+
+	/// Nodes of the world matrices which changed during the last update
+	std::vector<Node *> changed_nodes;
+
+	uint32_t world_update_count{0};
+
+	/// Number of nodes in the scene when the order was built
+	size_t ordered_node_count{0};
+
+	bool bvh_built{false};
+
+	BVH bvh;
+
+	std::vector<MeshInstance> mesh_instances;
+
+	/// Index in transform_order of the node of each mesh instance
+	std::vector<uint32_t> instance_transforms;
 };
 }        // namespace sg
 }        // namespace vkb
\ No newline at end of file
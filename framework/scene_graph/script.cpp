@@ -38,13 +38,18 @@ void Script::resize(uint32_t /*width*/, uint32_t /*height*/)
 {
 }
 
+bool Script::get_update_nodes(std::vector<Node *> & /*nodes*/) const
+{
+	return false;
+}
+
 NodeScript::NodeScript(Node &node, const std::string &name) :
     Script{name},
     node{node}
 {
 }
 
-Node &NodeScript::get_node()
+Node &NodeScript::get_node() const
 {
 	return node;
 }
@@ -50,6 +50,14 @@ class Script : public Component
 	virtual void input_event(const InputEvent &input_event);
 
 	virtual void resize(uint32_t width, uint32_t height);
+
+	/**
+	 * @brief Gets the nodes whose transforms the update writes, if the update touches nothing else.
+	 *        Such scripts may be updated in parallel with the scripts of other nodes.
+	 * @param nodes Appended with the nodes of the script
+	 * @return False if the update may touch any state, and has to run alone on the main thread
+	 */
+	virtual bool get_update_nodes(std::vector<Node *> &nodes) const;
 };
 
 class NodeScript : public Script
@@ -59,7 +67,7 @@ class NodeScript : public Script
 
 	virtual ~NodeScript() = default;
 
-	Node &get_node();
+	Node &get_node() const;
 
   private:
 	Node &node;
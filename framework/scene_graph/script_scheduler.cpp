@@ -0,0 +1,182 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scene_graph/script_scheduler.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+#include <core/util/job_system.hpp>
+
+#include "common/helpers.h"
+#include "scene_graph/scene.h"
+#include "scene_graph/script.h"
+#include "scene_graph/scripts/animation.h"
+
+namespace vkb
+{
+namespace sg
+{
+namespace
+{
+/// Tasks per worker, so that uneven groups still balance across the threads
+constexpr size_t tasks_per_thread = 4;
+
+size_t find_group(std::vector<size_t> &parents, size_t index)
+{
+	while (parents[index] != index)
+	{
+		parents[index] = parents[parents[index]];
+		index          = parents[index];
+	}
+
+	return index;
+}
+}        // namespace
+
+void ScriptScheduler::schedule(Scene &scene)
+{
+	scheduled_scene      = &scene;
+	script_generation    = scene.get_component_generation<Script>();
+	animation_generation = scene.get_component_generation<Animation>();
+
+	serial_scripts.clear();
+	parallel_scripts.clear();
+	tasks.clear();
+
+	// Scripts before animations, the order of the serial update
+	std::vector<Script *> scripts;
+	if (scene.has_component<Script>())
+	{
+		auto script_components = scene.get_components<Script>();
+		scripts.insert(scripts.end(), script_components.begin(), script_components.end());
+	}
+	script_count = scripts.size();
+
+	if (scene.has_component<Animation>())
+	{
+		auto animations = scene.get_components<Animation>();
+		scripts.insert(scripts.end(), animations.begin(), animations.end());
+	}
+	animation_count = scripts.size() - script_count;
+
+	// Join the scripts writing a common node into one group
+	std::vector<Script *>              candidates;
+	std::vector<size_t>                parents;
+	std::unordered_map<Node *, size_t> node_owners;
+	std::vector<Node *>                nodes;
+
+	for (auto script : scripts)
+	{
+		nodes.clear();
+		if (!script->get_update_nodes(nodes))
+		{
+			serial_scripts.push_back(script);
+			continue;
+		}
+
+		size_t index = candidates.size();
+		candidates.push_back(script);
+		parents.push_back(index);
+
+		for (auto node : nodes)
+		{
+			auto it = node_owners.emplace(node, index).first;
+			if (it->second != index)
+			{
+				parents[find_group(parents, index)] = find_group(parents, it->second);
+			}
+		}
+	}
+
+	// Lay the groups out contiguously, keeping the update order within a group
+	std::vector<size_t> order(candidates.size());
+	std::iota(order.begin(), order.end(), 0);
+
+	std::vector<size_t> groups(candidates.size());
+	for (size_t index = 0; index < candidates.size(); index++)
+	{
+		groups[index] = find_group(parents, index);
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&groups](size_t a, size_t b) { return groups[a] < groups[b]; });
+
+	for (auto index : order)
+	{
+		parallel_scripts.push_back(candidates[index]);
+	}
+
+	// Split at group boundaries into about the target number of tasks, the waiting thread runs tasks too
+	size_t thread_count = JobSystem::get().get_worker_count() + 1;
+	size_t target_size  = std::max<size_t>(1, parallel_scripts.size() / (thread_count * tasks_per_thread));
+
+	size_t task_begin = 0;
+	for (size_t position = 1; position <= order.size(); position++)
+	{
+		bool group_end = position == order.size() || groups[order[position]] != groups[order[position - 1]];
+		if (group_end && position - task_begin >= target_size)
+		{
+			tasks.emplace_back(task_begin, position);
+			task_begin = position;
+		}
+	}
+
+	if (task_begin < order.size())
+	{
+		tasks.emplace_back(task_begin, order.size());
+	}
+}
+
+void ScriptScheduler::update(Scene &scene, float delta_time)
+{
+	size_t current_script_count    = scene.has_component<Script>() ? scene.get_components<Script>().size() : 0;
+	size_t current_animation_count = scene.has_component<Animation>() ? scene.get_components<Animation>().size() : 0;
+
+	if (scheduled_scene != &scene ||
+	    script_generation != scene.get_component_generation<Script>() ||
+	    animation_generation != scene.get_component_generation<Animation>() ||
+	    script_count != current_script_count ||
+	    animation_count != current_animation_count)
+	{
+		schedule(scene);
+	}
+
+	for (auto script : serial_scripts)
+	{
+		script->update(delta_time);
+	}
+
+	if (tasks.empty())
+	{
+		return;
+	}
+
+	// One job per task, the calling thread takes a share of the work instead of idling until the barrier
+	JobSystem::get().parallel_for(to_u32(tasks.size()), 1, [this, delta_time](uint32_t begin, uint32_t end) {
+		for (uint32_t task_index = begin; task_index < end; task_index++)
+		{
+			auto &task = tasks[task_index];
+			for (size_t index = task.first; index < task.second; index++)
+			{
+				parallel_scripts[index]->update(delta_time);
+			}
+		}
+	});
+}
+}        // namespace sg
+}        // namespace vkb
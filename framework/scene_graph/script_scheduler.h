@@ -0,0 +1,83 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace vkb
+{
+namespace sg
+{
+class Scene;
+class Script;
+
+/**
+ * @brief Updates the scripts and animations of a scene over a thread pool.
+ *
+ *        Scripts which report the nodes they write (see Script::get_update_nodes) are grouped
+ *        so that scripts sharing a node stay in one task and keep their relative order.
+ *        Other scripts run first, alone on the calling thread. The update returns once every
+ *        task is done, so the world transforms can be propagated right after.
+ */
+class ScriptScheduler
+{
+  public:
+	ScriptScheduler() = default;
+
+	~ScriptScheduler() = default;
+
+	ScriptScheduler(const ScriptScheduler &) = delete;
+
+	ScriptScheduler(ScriptScheduler &&) = delete;
+
+	ScriptScheduler &operator=(const ScriptScheduler &) = delete;
+
+	ScriptScheduler &operator=(ScriptScheduler &&) = delete;
+
+	/**
+	 * @brief Updates every script and animation of the scene on the job system, the schedule is rebuilt when they change
+	 * @param scene Scene to update
+	 * @param delta_time Time passed since the last update
+	 */
+	void update(Scene &scene, float delta_time);
+
+  private:
+	void schedule(Scene &scene);
+
+	/// Scene and pool generations the schedule was built for
+	const Scene *scheduled_scene{nullptr};
+
+	uint32_t script_generation{0};
+
+	uint32_t animation_generation{0};
+
+	size_t script_count{0};
+
+	size_t animation_count{0};
+
+	/// Scripts which may touch any state
+	std::vector<Script *> serial_scripts;
+
+	/// Independent scripts, each task updates its range in order
+	std::vector<Script *> parallel_scripts;
+
+	std::vector<std::pair<size_t, size_t>> tasks;
+};
+}        // namespace sg
+}        // namespace vkb
@@ -165,6 +165,16 @@ void Animation::update(float delta_time)
 	}
 }
 
+bool Animation::get_update_nodes(std::vector<Node *> &nodes) const
+{
+	for (auto &channel : channels)
+	{
+		nodes.push_back(&channel.node);
+	}
+
+	return true;
+}
+
 void Animation::update_times(float new_start_time, float new_end_time)
 {
 	if (new_start_time < start_time)
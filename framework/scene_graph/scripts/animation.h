@@ -71,6 +71,11 @@ class Animation : public Script
 
 	virtual void update(float delta_time) override;
 
+	/**
+	 * @brief Gets the nodes targeted by the channels, the update writes nothing else
+	 */
+	virtual bool get_update_nodes(std::vector<Node *> &nodes) const override;
+
 	void update_times(float start_time, float end_time);
 
 	void add_channel(Node &node, const AnimationTarget &target, const AnimationSampler &sampler);
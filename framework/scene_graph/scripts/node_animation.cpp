@@ -47,6 +47,12 @@ void NodeAnimation::update(float delta_time)
 	}
 }
 
+bool NodeAnimation::get_update_nodes(std::vector<Node *> &nodes) const
+{
+	nodes.push_back(&get_node());
+	return true;
+}
+
 void NodeAnimation::set_animation(TransformAnimFn handle)
 {
 	animation_fn = handle;
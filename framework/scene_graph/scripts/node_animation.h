@@ -45,6 +45,11 @@ class NodeAnimation : public NodeScript
 
 	virtual void update(float delta_time) override;
 
+	/**
+	 * @brief Gets the node of the script, as the animation function is only given its transform
+	 */
+	virtual bool get_update_nodes(std::vector<Node *> &nodes) const override;
+
 	void set_animation(TransformAnimFn handle);
 
 	void clear_animation();
@@ -0,0 +1,82 @@
+/* Copyright (c) 2023, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render_frame_stats_provider.h"
+
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+RenderFrameStatsProvider::RenderFrameStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context) :
+    render_context{render_context}
+{
+	for (auto index : {StatIndex::descriptor_set_allocations,
+	                   StatIndex::descriptor_set_cache_hits,
+	                   StatIndex::descriptor_set_evictions,
+	                   StatIndex::descriptor_sets_cached})
+	{
+		if (requested_stats.erase(index) > 0)
+		{
+			stat_indices.insert(index);
+		}
+	}
+}
+
+bool RenderFrameStatsProvider::is_available(StatIndex index) const
+{
+	return stat_indices.count(index) > 0;
+}
+
+StatsProvider::Counters RenderFrameStatsProvider::sample(float delta_time)
+{
+	Counters res;
+
+	auto &frames = render_context.get_render_frames();
+	if (frames.empty())
+	{
+		return res;
+	}
+
+	// Samples may be taken while a frame is recorded, the last rendered frame is complete
+	auto &frame = *frames[render_context.get_last_rendered_frame_index() % frames.size()];
+
+	auto descriptor_set_stats = frame.get_descriptor_set_cache_stats();
+
+	for (auto index : stat_indices)
+	{
+		switch (index)
+		{
+			case StatIndex::descriptor_set_allocations:
+				res[index].result = descriptor_set_stats.misses;
+				break;
+			case StatIndex::descriptor_set_cache_hits:
+				res[index].result = descriptor_set_stats.hits;
+				break;
+			case StatIndex::descriptor_set_evictions:
+				res[index].result = descriptor_set_stats.evictions;
+				break;
+			case StatIndex::descriptor_sets_cached:
+				res[index].result = descriptor_set_stats.cached;
+				break;
+			default:
+				break;
+		}
+	}
+
+	return res;
+}
+}        // namespace vkb
@@ -21,6 +21,7 @@
 
 #include "frame_time_stats_provider.h"
 #include "hwcpipe_stats_provider.h"
+#include "render_frame_stats_provider.h"
 #include "vulkan_stats_provider.h"
 
 namespace vkb
@@ -63,6 +64,7 @@ void Stats::request_stats(const std::set<StatIndex> &wanted_stats,
 	// All supported stats will be removed from the given 'stats' set by the provider's constructor
 	// so subsequent providers only see requests for stats that aren't already supported.
 	providers.emplace_back(std::make_unique<FrameTimeStatsProvider>(stats));
+	providers.emplace_back(std::make_unique<RenderFrameStatsProvider>(stats, render_context));
 	providers.emplace_back(std::make_unique<HWCPipeStatsProvider>(stats));
 	providers.emplace_back(std::make_unique<VulkanStatsProvider>(stats, sampling_config, render_context));
 
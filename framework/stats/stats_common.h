@@ -63,6 +63,11 @@ enum class StatIndex
 	gpu_ext_read_bytes,
 	gpu_ext_write_bytes,
 	gpu_tex_cycles,
+
+	descriptor_set_allocations,
+	descriptor_set_cache_hits,
+	descriptor_set_evictions,
+	descriptor_sets_cached,
 };
 
 struct StatIndexHash
@@ -54,6 +54,11 @@ std::map<StatIndex, StatGraphData> StatsProvider::default_graph_map{
     {StatIndex::gpu_ext_write_stalls,  {"External Write Stalls",                       "{:4.1f} M/s",   static_cast<float>(1e-6)}},
     {StatIndex::gpu_ext_read_bytes,    {"External Read Bytes",                         "{:4.1f} MiB/s", 1.0f / (1024.0f * 1024.0f)}},
     {StatIndex::gpu_ext_write_bytes,   {"External Write Bytes",                        "{:4.1f} MiB/s", 1.0f / (1024.0f * 1024.0f)}},
+
+    {StatIndex::descriptor_set_allocations, {"Descriptor Set Allocations",            "{:4.0f}/frame"}},
+    {StatIndex::descriptor_set_cache_hits,  {"Descriptor Set Cache Hits",             "{:4.0f}/frame"}},
+    {StatIndex::descriptor_set_evictions,   {"Descriptor Set Evictions",              "{:4.0f}/frame"}},
+    {StatIndex::descriptor_sets_cached,     {"Cached Descriptor Sets",                "{:4.0f}"}},
     // clang-format on
 };
 
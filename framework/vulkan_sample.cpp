@@ -151,10 +151,24 @@ bool VulkanSample::prepare(const ApplicationOptions &options)
 	{
 		gpu.get_mutable_requested_features().depthClamp = VK_TRUE;
 	}
+	// Siho GPU-driven geometry requests multi draw indirect with per command first instances
+	if (gpu.get_features().multiDrawIndirect)
+	{
+		gpu.get_mutable_requested_features().multiDrawIndirect = VK_TRUE;
+	}
+	if (gpu.get_features().drawIndirectFirstInstance)
+	{
+		gpu.get_mutable_requested_features().drawIndirectFirstInstance = VK_TRUE;
+	}
 	if(gpu.get_features().samplerAnisotropy)
 	{
 		gpu.get_mutable_requested_features().samplerAnisotropy = VK_TRUE;
 	}
+	// Siho bindless materials index an array of all the material textures
+	if (gpu.get_features().shaderSampledImageArrayDynamicIndexing)
+	{
+		gpu.get_mutable_requested_features().shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+	}
 	
 	// Request sample required GPU features
 	request_gpu_features(gpu);
@@ -170,6 +184,9 @@ bool VulkanSample::prepare(const ApplicationOptions &options)
 		}
 	}
 
+	// Per-draw uniforms are pushed when supported, instead of bound with dynamic offsets
+	add_device_extension(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME, /*optional=*/true);
+
 #ifdef VKB_VULKAN_DEBUG
 	if (!debug_utils)
 	{
@@ -257,27 +274,11 @@ void VulkanSample::update_scene(float delta_time)
 {
 	if (scene)
 	{
-		// Update scripts
-		if (scene->has_component<sg::Script>())
-		{
-			auto scripts = scene->get_components<sg::Script>();
+		// Update scripts and animations, independent ones in parallel
+		script_scheduler.update(*scene, delta_time);
 
-			for (auto script : scripts)
-			{
-				script->update(delta_time);
-			}
-		}
-
-		// Update animations
-		if (scene->has_component<sg::Animation>())
-		{
-			auto animations = scene->get_components<sg::Animation>();
-
-			for (auto animation : animations)
-			{
-				animation->update(delta_time);
-			}
-		}
+		// Propagate the transform changes to the world matrices of the whole hierarchy
+		scene->update_world_transforms();
 	}
 }
 
@@ -545,9 +546,10 @@ void VulkanSample::set_viewport_and_scissor(vkb::CommandBuffer &command_buffer,
 	command_buffer.set_scissor(0, {scissor});
 }
 
-void VulkanSample::load_scene(const std::string &path)
+void VulkanSample::load_scene(const std::string &path, bool quantize_positions)
 {
 	GLTFLoader loader{*device};
+	loader.set_quantize_positions(quantize_positions);
 
 	scene = loader.read_scene_from_file(path);
 
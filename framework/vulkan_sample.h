@@ -26,6 +26,7 @@
 #include "rendering/render_pipeline.h"
 #include "scene_graph/node.h"
 #include "scene_graph/scene.h"
+#include "scene_graph/script_scheduler.h"
 #include "scene_graph/scripts/node_animation.h"
 #include "stats/stats.h"
 
@@ -95,7 +96,7 @@ namespace vkb
  * - RenderPipeline
  * - ShaderModule
  * - ResourceCache
- * - BufferPool
+ * - BufferRing
  * - Core classes: Classes in vkb::core wrap Vulkan objects for indexing and hashing.
  */
 
@@ -138,8 +139,9 @@ class VulkanSample : public Application
 	 * @brief Loads the scene
 	 *
 	 * @param path The path of the glTF file
+	 * @param quantize_positions Whether the positions are quantized, see GLTFLoader::set_quantize_positions
 	 */
-	void load_scene(const std::string &path);
+	void load_scene(const std::string &path, bool quantize_positions = false);
 
 	VkSurfaceKHR get_surface();
 
@@ -188,6 +190,11 @@ class VulkanSample : public Application
 	 */
 	std::unique_ptr<sg::Scene> scene{nullptr};
 
+	/**
+	 * @brief Updates the scripts and animations of the scene, the transform writes complete before it returns
+	 */
+	sg::ScriptScheduler script_scheduler;
+
 	std::unique_ptr<Gui> gui{nullptr};
 
 	std::unique_ptr<Stats> stats{nullptr};
@@ -19,7 +19,24 @@
 
 precision highp float;
 
-#ifdef HAS_BASE_COLOR_TEXTURE
+#ifdef BINDLESS_MATERIALS
+struct Material
+{
+    vec4 base_color_factor;
+    float metallic_factor;
+    float roughness_factor;
+    // Index in textures, ~0 if the material has none
+    uint base_color_texture;
+};
+
+#ifdef BINDLESS_TEXTURE_COUNT
+layout (set=1, binding=0) uniform sampler2D textures[BINDLESS_TEXTURE_COUNT];
+#endif
+
+layout(std430, set = 1, binding = 1) readonly buffer MaterialBuffer {
+    Material materials[];
+} material_buffer;
+#elif defined(HAS_BASE_COLOR_TEXTURE)
 layout (set=0, binding=0) uniform sampler2D base_color_texture;
 #endif
 
@@ -36,11 +53,17 @@ layout(set = 0, binding = 1) uniform GlobalUniform {
     vec3 camera_position;
 } global_uniform;
 
+#ifdef BINDLESS_MATERIALS
+layout(push_constant, std430) uniform MaterialIndex {
+    uint index;
+} material_index;
+#else
 layout(push_constant, std430) uniform PBRMaterialUniform {
     vec4 base_color_factor;
     float metallic_factor;
     float roughness_factor;
 } pbr_material_uniform;
+#endif
 
 void main(void)
 {
@@ -50,7 +73,17 @@ void main(void)
 
     vec4 base_color = vec4(1.0, 0.0, 0.0, 1.0);
 
-#ifdef HAS_BASE_COLOR_TEXTURE
+#ifdef BINDLESS_MATERIALS
+    // The index is the same for the whole draw, so the texture array is indexed uniformly
+    Material material = material_buffer.materials[material_index.index];
+    base_color = material.base_color_factor;
+#ifdef BINDLESS_TEXTURE_COUNT
+    if (material.base_color_texture != 0xFFFFFFFFu)
+    {
+        base_color = texture(textures[material.base_color_texture], in_uv);
+    }
+#endif
+#elif defined(HAS_BASE_COLOR_TEXTURE)
     base_color = texture(base_color_texture, in_uv);
 #else
     base_color = pbr_material_uniform.base_color_factor;
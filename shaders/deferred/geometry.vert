@@ -16,27 +16,78 @@
  * limitations under the License.
  */
 
+#include "vertex_packing.h"
+
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec2 texcoord_0;
+#ifdef OCTAHEDRAL_NORMAL
+layout(location = 2) in vec2 normal;
+#else
 layout(location = 2) in vec3 normal;
+#endif
 
 layout(set = 0, binding = 1) uniform GlobalUniform {
     mat4 model;
     mat4 view_proj;
     vec3 camera_position;
+    vec4 position_scale;
+    vec4 position_offset;
 } global_uniform;
 
+#if defined(INDIRECT_DRAW) || defined(INSTANCING)
+layout(std430, set = 0, binding = 2) readonly buffer InstanceBuffer {
+    mat4 models[];
+} instance_buffer;
+#endif
+
+#ifdef INDIRECT_DRAW
+// Instance and draw command of the instances which passed culling, indexed from the first instance of the draw command
+layout(std430, set = 0, binding = 3) readonly buffer VisibleInstances {
+    uvec2 indices[];
+} visible_instances;
+
+#ifdef QUANTIZED_POSITION
+// Scale and offset of the positions of the submesh of every draw command
+layout(std430, set = 0, binding = 4) readonly buffer CommandPositions {
+    vec4 transforms[];
+} command_positions;
+#endif
+#endif
+
 layout (location = 0) out vec4 o_pos;
 layout (location = 1) out vec2 o_uv;
 layout (location = 2) out vec3 o_normal;
 
 void main(void)
 {
-    o_pos = global_uniform.model * vec4(position, 1.0);
+#ifdef INDIRECT_DRAW
+    uvec2 visible_instance = visible_instances.indices[gl_InstanceIndex];
+    mat4  model            = instance_buffer.models[visible_instance.x];
+#elif defined(INSTANCING)
+    mat4 model = instance_buffer.models[gl_InstanceIndex];
+#else
+    mat4 model = global_uniform.model;
+#endif
+
+#if defined(QUANTIZED_POSITION) && defined(INDIRECT_DRAW)
+    // The submeshes of an indirect draw are restored with the bounds of their own command
+    vec3 local_position = position * command_positions.transforms[2u * visible_instance.y].xyz + command_positions.transforms[2u * visible_instance.y + 1u].xyz;
+#elif defined(QUANTIZED_POSITION)
+    // Positions are normalized over the bounds of the submesh
+    vec3 local_position = position * global_uniform.position_scale.xyz + global_uniform.position_offset.xyz;
+#else
+    vec3 local_position = position;
+#endif
+
+    o_pos = model * vec4(local_position, 1.0);
 
     o_uv = texcoord_0;
 
-    o_normal = mat3(global_uniform.model) * normal;
+#ifdef OCTAHEDRAL_NORMAL
+    o_normal = mat3(model) * decode_octahedral(normal);
+#else
+    o_normal = mat3(model) * normal;
+#endif
 
     gl_Position = global_uniform.view_proj * o_pos;
 }
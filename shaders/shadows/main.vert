@@ -16,14 +16,22 @@
  * limitations under the License.
  */
 
+#include "vertex_packing.h"
+
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec2 texcoord_0;
+#ifdef OCTAHEDRAL_NORMAL
+layout(location = 2) in vec2 normal;
+#else
 layout(location = 2) in vec3 normal;
+#endif
 
 layout(set = 0, binding = 1) uniform GlobalUniform {
     mat4 model;
     mat4 view_proj;
     vec3 camera_position;
+    vec4 position_scale;
+    vec4 position_offset;
 } global_uniform;
 
 layout (location = 0) out vec4 o_pos;
@@ -32,11 +40,21 @@ layout (location = 2) out vec3 o_normal;
 
 void main(void)
 {
-    o_pos = global_uniform.model * vec4(position, 1.0);
+#ifdef QUANTIZED_POSITION
+    vec3 local_position = position * global_uniform.position_scale.xyz + global_uniform.position_offset.xyz;
+#else
+    vec3 local_position = position;
+#endif
+
+    o_pos = global_uniform.model * vec4(local_position, 1.0);
 
     o_uv = texcoord_0;
 
+#ifdef OCTAHEDRAL_NORMAL
+    o_normal = mat3(global_uniform.model) * decode_octahedral(normal);
+#else
     o_normal = mat3(global_uniform.model) * normal;
+#endif
 
     gl_Position = global_uniform.view_proj * o_pos;
 }
@@ -22,10 +22,31 @@ layout(set = 0, binding = 1) uniform GlobalUniform {
     mat4 model;
     mat4 view_proj;
     vec3 camera_position;
+    vec4 position_scale;
+    vec4 position_offset;
 } global_uniform;
 
+#ifdef INSTANCING
+layout(std430, set = 0, binding = 2) readonly buffer InstanceBuffer {
+    mat4 models[];
+} instance_buffer;
+#endif
+
 void main(void)
 {
-    vec4 pos = global_uniform.model * vec4(position, 1.0);
+#ifdef INSTANCING
+    mat4 model = instance_buffer.models[gl_InstanceIndex];
+#else
+    mat4 model = global_uniform.model;
+#endif
+
+#ifdef QUANTIZED_POSITION
+    // Positions are normalized over the bounds of the submesh
+    vec3 local_position = position * global_uniform.position_scale.xyz + global_uniform.position_offset.xyz;
+#else
+    vec3 local_position = position;
+#endif
+
+    vec4 pos = model * vec4(local_position, 1.0);
     gl_Position = global_uniform.view_proj * pos;
 }
@@ -1,5 +1,7 @@
 #include "main_pass.h"
 
+#include <algorithm>
+
 #include "rendering/subpass.h"
 
 namespace 
@@ -7,6 +9,10 @@ namespace
 	VkFormat          albedo_format{ VK_FORMAT_R8G8B8A8_UNORM };
 	VkFormat          normal_format{ VK_FORMAT_A2B10G10R10_UNORM_PACK32 };
 	VkImageUsageFlags rt_usage_flags{ VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT };
+
+	// Stages of the main pass using the G-buffer: written as attachments, read as input attachments by the lighting
+	VkPipelineStageFlags gbuffer_stage_mask{ VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT };
 }
 namespace siho
 {
@@ -17,6 +23,7 @@ namespace siho
 		:vkb::LightingSubpass(render_context, std::move(vertex_shader), std::move(fragment_shader), camera, scene),
 		shadow_render_pass_(shadow_render_pass)
 	{
+		resource_mode_map["ShadowUniform"] = get_per_draw_resource_mode();
 	}
 
 	void LightingSubpass::prepare()
@@ -39,18 +46,39 @@ namespace siho
 		vkb::LightingSubpass::draw(command_buffer);
 	}
 
+	OccluderSubpass::OccluderSubpass(vkb::RenderContext& render_context, vkb::ShaderSource&& vertex_shader,
+		vkb::ShaderSource&& fragment_shader, vkb::IndirectGeometrySubpass& geometry_subpass)
+		:vkb::Subpass(render_context, std::move(vertex_shader), std::move(fragment_shader)),
+		geometry_subpass_(geometry_subpass)
+	{
+	}
+
+	void OccluderSubpass::prepare()
+	{
+		// The occluders are drawn with the shaders of the geometry subpass
+	}
+
+	void OccluderSubpass::draw(vkb::CommandBuffer& command_buffer)
+	{
+		geometry_subpass_.draw_occluders(command_buffer);
+	}
+
 	void MainPass::init(vkb::RenderContext& render_context, vkb::sg::Scene& scene, vkb::sg::Camera& camera,
-		siho::ShadowRenderPass& shadow_render_pass, FxComputePass& fx_compute_pass)
+		siho::ShadowRenderPass& shadow_render_pass, FxComputePass& fx_compute_pass, size_t first_thread_index, uint32_t thread_count)
 	{
 		render_context_ = &render_context;
+		first_thread_index_ = first_thread_index;
+		thread_count_ = std::max(thread_count, 1u);
 		shadow_render_pass_ = &shadow_render_pass;
 		fx_compute_pass_ = &fx_compute_pass;
 		create_render_pipeline(camera, scene);
+		create_occluder_pipeline();
 	}
 
-	void MainPass::draw(vkb::CommandBuffer& command_buffer)
+	void MainPass::record(vkb::CommandBuffer& command_buffer)
 	{
-		auto& render_target = render_context_->get_active_frame().get_render_target();
+		auto& render_frame = render_context_->get_active_frame();
+		auto& render_target = render_frame.get_render_target();
 		auto& extent = render_target.get_extent();
 
 		VkViewport viewport{};
@@ -64,67 +92,114 @@ namespace siho
 		scissor.extent = extent;
 		command_buffer.set_scissor(0, { scissor });
 
+		// The instances are culled by compute passes, which have to be recorded outside of the render passes
+		if (geometry_subpass_->get_batch_count() > 0)
+		{
+			geometry_subpass_->cull_occluders(command_buffer);
+			draw_occluders(command_buffer);
+		}
+		geometry_subpass_->cull(command_buffer);
+
+		// The draws are split into contiguous chunks, executed in order so that the sorting of the draws is kept
+		geometry_subpass_->prepare_draw();
+
+		uint32_t draw_count = geometry_subpass_->get_draw_count();
+		uint32_t chunk_count = std::max(std::min(draw_count, thread_count_), 1u);
+
+		const auto& queue = render_context_->get_device().get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+		auto& job_system = vkb::JobSystem::get();
+
+		secondary_command_buffers_.clear();
+
+		for (uint32_t i = 0; i < chunk_count; i++)
+		{
+			size_t thread_index = first_thread_index_ + i;
+			auto& secondary_command_buffer = render_frame.request_command_buffer(queue, vkb::CommandBuffer::ResetMode::ResetPool,
+				VK_COMMAND_BUFFER_LEVEL_SECONDARY, thread_index);
+			secondary_command_buffers_.push_back(&secondary_command_buffer);
+
+			uint32_t first_draw = draw_count * i / chunk_count;
+			uint32_t end_draw = draw_count * (i + 1) / chunk_count;
+
+			job_system.schedule(record_counter_, [this, &secondary_command_buffer, &render_target, viewport, scissor, first_draw, end_draw, thread_index]()
+				{
+					render_pipeline_->begin_secondary(secondary_command_buffer, render_target);
+					secondary_command_buffer.set_viewport(0, { viewport });
+					secondary_command_buffer.set_scissor(0, { scissor });
+					geometry_subpass_->draw_range(secondary_command_buffer, first_draw, end_draw - first_draw, thread_index);
+					secondary_command_buffer.end();
+				});
+		}
+	}
+
+	void MainPass::draw(vkb::CommandBuffer& command_buffer)
+	{
+		auto& render_target = render_context_->get_active_frame().get_render_target();
+
 		record_image_memory_barriers(command_buffer);
-		render_pipeline_->draw(command_buffer, render_target);
+
+		vkb::JobSystem::get().wait(record_counter_);
+
+		render_pipeline_->draw(command_buffer, render_target, secondary_command_buffers_);
 	}
 
 	std::unique_ptr<vkb::RenderTarget> MainPass::create_render_target(vkb::core::Image&& swapchain_image)
 	{
 		auto& device = swapchain_image.get_device();
 		auto& extent = swapchain_image.get_extent();
+
+		if (!attachment_allocator_)
+		{
+			attachment_allocator_ = std::make_unique<vkb::TransientAttachmentAllocator>(device);
+		}
+
 		// G-Buffer should fit 128-bit budget for buffer color storage
 		// in order to enable subpasses merging by the driver
 		// Light (swapchain_image) RGBA8_UNORM   (32-bit)
 		// Albedo                  RGBA8_UNORM   (32-bit)
 		// Normal                  RGB10A2_UNORM (32-bit)
-		vkb::core::Image depth_image{ device,extent,
-			vkb::get_suitable_depth_format(swapchain_image.get_device().get_gpu().get_handle()),
+		// The G-buffer does not outlive the main pass, the frames in flight share it, see record_image_memory_barriers.
+		// The depth aliases the occluder depth, used before the main pass
+		std::vector<std::shared_ptr<vkb::core::Image>> gbuffer_images;
+
+		// Attachment 1
+		gbuffer_images.push_back(attachment_allocator_->request_image("depth", extent,
+			vkb::get_suitable_depth_format(device.get_gpu().get_handle()),
 			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | rt_usage_flags,
-			VMA_MEMORY_USAGE_GPU_ONLY
-		};
+			"depth"));
 
-		vkb::core::Image albedo_image{ device,extent,
+		// Attachment 2
+		gbuffer_images.push_back(attachment_allocator_->request_image("albedo", extent,
 			albedo_format,
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | rt_usage_flags,
-			VMA_MEMORY_USAGE_GPU_ONLY
-		};
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | rt_usage_flags));
 
-		vkb::core::Image normal_image{ device,extent,
+		// Attachment 3
+		gbuffer_images.push_back(attachment_allocator_->request_image("normal", extent,
 			normal_format,
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | rt_usage_flags,
-			VMA_MEMORY_USAGE_GPU_ONLY
-		};
-
-		vkb::core::Image light_image{ device,extent,
-			albedo_format,
-			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | rt_usage_flags,
-			VMA_MEMORY_USAGE_GPU_ONLY
-		};
-
-		vkb::core::Image depth_image2{ device,extent,
-			vkb::get_suitable_depth_format(swapchain_image.get_device().get_gpu().get_handle()),
-			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | rt_usage_flags,
-			VMA_MEMORY_USAGE_GPU_ONLY
-		};
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | rt_usage_flags));
 
 		std::vector<vkb::core::Image> images;
 
 		// Attachment 0
 		images.push_back(std::move(swapchain_image));
 
-		// Attachment 1
-		images.push_back(std::move(depth_image));
-
-		// Attachment 2
-		images.push_back(std::move(albedo_image));
-
-		// Attachment 3
-		images.push_back(std::move(normal_image));
+		return std::make_unique<vkb::RenderTarget>(std::move(images), std::move(gbuffer_images));
+	}
 
-		// images.push_back(std::move(light_image));
+	vkb::TransientAttachmentStats MainPass::get_attachment_stats() const
+	{
+		return attachment_allocator_ ? attachment_allocator_->get_stats() : vkb::TransientAttachmentStats{};
+	}
 
+	const vkb::CullingStats& MainPass::get_culling_stats() const
+	{
+		return geometry_subpass_->get_culling_stats();
+	}
 
-		return std::make_unique<vkb::RenderTarget>(std::move(images));
+	uint32_t MainPass::get_indirect_batch_count() const
+	{
+		return geometry_subpass_->get_batch_count();
 	}
 
 	void MainPass::create_render_pipeline(vkb::sg::Camera& camera, vkb::sg::Scene& scene)
@@ -132,10 +207,15 @@ namespace siho
 		// Geometry subpass
 		auto geometry_vs = vkb::ShaderSource{ "deferred/geometry.vert" };
 		auto geometry_fs = vkb::ShaderSource{ "deferred/geometry.frag" };
-		auto scene_subpass = std::make_unique<vkb::GeometrySubpass>(*render_context_, std::move(geometry_vs), std::move(geometry_fs), scene, camera);
+		auto cull_cs = vkb::ShaderSource{ "indirect/cull_instances.comp" };
+		auto scatter_cs = vkb::ShaderSource{ "indirect/scatter_instances.comp" };
+		auto scene_subpass = std::make_unique<vkb::IndirectGeometrySubpass>(*render_context_, std::move(geometry_vs), std::move(geometry_fs), std::move(cull_cs), std::move(scatter_cs), scene, camera);
 
+		// Material switches only push an index into the bindless material tables
+		scene_subpass->set_bindless_materials(true);
 		// Outputs are depth, albedo, normal
 		scene_subpass->set_output_attachments({ 1, 2, 3 });
+		geometry_subpass_ = scene_subpass.get();
 
 		auto lighting_vs = vkb::ShaderSource{ "deferred/lighting.vert" };
 		auto lighting_fs = vkb::ShaderSource{ "deferred/lighting.frag" };
@@ -164,6 +244,78 @@ namespace siho
 		render_pipeline_->set_clear_value(vkb::gbuffer::get_clear_value());
 	}
 
+	void MainPass::create_occluder_pipeline()
+	{
+		hiz_pyramid_ = std::make_unique<vkb::HiZPyramid>(*render_context_, vkb::ShaderSource{ "hiz/downsample.comp" });
+		geometry_subpass_->set_hiz_pyramid(hiz_pyramid_.get());
+
+		auto occluder_subpass = std::make_unique<OccluderSubpass>(*render_context_,
+			vkb::ShaderSource{ "deferred/geometry.vert" }, vkb::ShaderSource{ "deferred/geometry.frag" }, *geometry_subpass_);
+		// Depth only
+		occluder_subpass->set_output_attachments({});
+
+		occluder_pipeline_ = std::make_unique<vkb::RenderPipeline>();
+		occluder_pipeline_->add_subpass(std::move(occluder_subpass));
+
+		occluder_pipeline_->set_load_store({ { VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE } });
+
+		VkClearValue depth_clear_value{};
+		depth_clear_value.depthStencil = { 0.0f, ~0U };
+		occluder_pipeline_->set_clear_value({ depth_clear_value });
+
+		occluder_render_targets_.resize(render_context_->get_render_frames().size());
+	}
+
+	void MainPass::draw_occluders(vkb::CommandBuffer& command_buffer)
+	{
+		auto frame_index = render_context_->get_active_frame_index();
+		auto& extent = render_context_->get_active_frame().get_render_target().get_extent();
+
+		auto& occluder_render_target = occluder_render_targets_[frame_index];
+		if (!occluder_render_target || occluder_render_target->get_extent().width != extent.width || occluder_render_target->get_extent().height != extent.height)
+		{
+			// The frame is not in flight, its previous render target is unused
+			auto& device = render_context_->get_device();
+
+			std::vector<std::shared_ptr<vkb::core::Image>> images;
+			images.push_back(attachment_allocator_->request_image("occluder_depth", { extent.width, extent.height, 1 },
+				vkb::get_suitable_depth_format(device.get_gpu().get_handle(), true),
+				VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+				"depth"));
+			occluder_render_target = std::make_unique<vkb::RenderTarget>(std::vector<vkb::core::Image>{}, std::move(images));
+		}
+
+		auto& depth_view = occluder_render_target->get_views()[0];
+		{
+			// The depth image is shared by the frames, and aliases the G-buffer depth:
+			// wait for the main pass and the Hi-Z build of the previous frame
+			vkb::ImageMemoryBarrier memory_barrier{};
+			memory_barrier.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			memory_barrier.new_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			memory_barrier.src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			memory_barrier.dst_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			memory_barrier.src_stage_mask = gbuffer_stage_mask | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			memory_barrier.dst_stage_mask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			command_buffer.image_memory_barrier(depth_view, memory_barrier);
+		}
+
+		occluder_pipeline_->draw(command_buffer, *occluder_render_target);
+		command_buffer.end_render_pass();
+
+		{
+			vkb::ImageMemoryBarrier memory_barrier{};
+			memory_barrier.old_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			memory_barrier.new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			memory_barrier.src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			memory_barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+			memory_barrier.src_stage_mask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			memory_barrier.dst_stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+			command_buffer.image_memory_barrier(depth_view, memory_barrier);
+		}
+
+		hiz_pyramid_->build(command_buffer, depth_view);
+	}
+
 	void MainPass::record_image_memory_barriers(vkb::CommandBuffer& command_buffer)
 	{
 		auto& views = render_context_->get_active_frame().get_render_target().get_views();
@@ -178,6 +330,18 @@ namespace siho
 
 			assert(swapchain_attachment_index < views.size());
 			command_buffer.image_memory_barrier(views[swapchain_attachment_index], memory_barrier);
+		}
+
+		// The G-buffer is shared by the frames, its first use waits for its uses by the previous frame
+		{
+			vkb::ImageMemoryBarrier memory_barrier{};
+			memory_barrier.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			memory_barrier.new_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			memory_barrier.src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			memory_barrier.dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			memory_barrier.src_stage_mask = gbuffer_stage_mask;
+			memory_barrier.dst_stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
 			// Skip 1 as it is handled later as a depth-stencil attachment
 			for (size_t i = 2; i < views.size(); ++i)
 			{
@@ -186,18 +350,17 @@ namespace siho
 		}
 
 		{
+			// The depth also aliases the occluder depth of this frame, read by the Hi-Z build
 			vkb::ImageMemoryBarrier memory_barrier{};
 			memory_barrier.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
 			memory_barrier.new_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-			memory_barrier.src_access_mask = 0;
+			memory_barrier.src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 			memory_barrier.dst_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-			memory_barrier.src_stage_mask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			memory_barrier.src_stage_mask = gbuffer_stage_mask | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 			memory_barrier.dst_stage_mask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
 
 			assert(1 < views.size());
 			command_buffer.image_memory_barrier(views[1], memory_barrier);
-			// command_buffer.image_memory_barrier(views[2], memory_barrier);
-
 		}
 
 		{
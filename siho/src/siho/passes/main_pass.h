@@ -1,7 +1,9 @@
 #pragma once
-#include "ctpl_stl.h"
 #include "shadow_pass.h"
 #include "particles_pass.h"
+#include "rendering/hiz_pyramid.h"
+#include "rendering/transient_attachment_allocator.h"
+#include "rendering/subpasses/indirect_geometry_subpass.h"
 #include "rendering/subpasses/lighting_subpass.h"
 
 namespace siho
@@ -22,30 +24,93 @@ namespace siho
 		ShadowRenderPass& shadow_render_pass_;
 	};
 
+	/**
+	 * @brief Draws the depth of the occluders of the geometry subpass
+	 */
+	class OccluderSubpass : public vkb::Subpass
+	{
+	public:
+		OccluderSubpass(vkb::RenderContext& render_context,
+			vkb::ShaderSource&& vertex_shader,
+			vkb::ShaderSource&& fragment_shader,
+			vkb::IndirectGeometrySubpass& geometry_subpass);
+		void prepare() override;
+		void draw(vkb::CommandBuffer& command_buffer) override;
+	private:
+		vkb::IndirectGeometrySubpass& geometry_subpass_;
+	};
+
 	class MainPass
 	{
 	public:
 		MainPass() = default;
 
-		void init(vkb::RenderContext& render_context, vkb::sg::Scene& scene, vkb::sg::Camera& camera, siho::ShadowRenderPass& shadow_render_pass, FxComputePass& fx_compute_pass);
+		/**
+		 * @param first_thread_index Render frame thread index of the first chunk of the geometry subpass
+		 * @param thread_count Largest number of chunks the geometry subpass is split into
+		 */
+		void init(vkb::RenderContext& render_context, vkb::sg::Scene& scene, vkb::sg::Camera& camera, siho::ShadowRenderPass& shadow_render_pass, FxComputePass& fx_compute_pass,
+			size_t first_thread_index, uint32_t thread_count);
 
+		/**
+		 * @brief Records the culling, which cannot be recorded in the render pass, then starts recording the draws
+		 *        of the geometry subpass, split into chunks, into secondary command buffers as jobs of the job system
+		 */
+		void record(vkb::CommandBuffer& command_buffer);
+
+		/**
+		 * @brief Waits for the chunks started by record, and records the render pass executing them
+		 */
 		void draw(vkb::CommandBuffer& command_buffer);
 
-		static std::unique_ptr<vkb::RenderTarget> create_render_target(vkb::core::Image&& swapchain_image);
+		/**
+		 * @brief Creates the render target of a frame, the G-buffer images are shared by the frames
+		 */
+		std::unique_ptr<vkb::RenderTarget> create_render_target(vkb::core::Image&& swapchain_image);
+
+		/**
+		 * @return Memory of the G-buffer and occluder depth images, shared by the frames in flight
+		 */
+		vkb::TransientAttachmentStats get_attachment_stats() const;
+
+		const vkb::CullingStats& get_culling_stats() const;
+
+		uint32_t get_indirect_batch_count() const;
 
 	private:
 		void create_render_pipeline(vkb::sg::Camera& camera, vkb::sg::Scene& scene);
 
+		void create_occluder_pipeline();
+
+		/**
+		 * @brief Draws the occluders into the depth image of the active frame and builds the Hi-Z pyramid from it
+		 */
+		void draw_occluders(vkb::CommandBuffer& command_buffer);
+
 		void record_image_memory_barriers(vkb::CommandBuffer& command_buffer);
 
 	private:
 		std::unique_ptr<vkb::RenderPipeline> render_pipeline_{};
+		vkb::IndirectGeometrySubpass* geometry_subpass_{};
+
+		// Two-phase occlusion culling: the instances visible in the previous frame are drawn into
+		// a depth image, and every instance is tested against the pyramid built from it
+		std::unique_ptr<vkb::RenderPipeline> occluder_pipeline_{};
+		std::vector<std::unique_ptr<vkb::RenderTarget>> occluder_render_targets_;
+		std::unique_ptr<vkb::HiZPyramid> hiz_pyramid_{};
+
+		// Created with the first render target, before init
+		std::unique_ptr<vkb::TransientAttachmentAllocator> attachment_allocator_{};
 
 		vkb::RenderContext* render_context_{};
 		ShadowRenderPass* shadow_render_pass_;
 		FxComputePass* fx_compute_pass_;
 
-		ctpl::thread_pool thread_pool{ 1 };
+		size_t first_thread_index_{ 0 };
+		uint32_t thread_count_{ 1 };
+		std::vector<vkb::CommandBuffer*> secondary_command_buffers_;
+		vkb::JobCounter record_counter_;
+
 		uint32_t swapchain_attachment_index{ 0 };
 		uint32_t depth_attachment_index{ 1 };
 
@@ -104,14 +104,15 @@ namespace siho
 		: Subpass(render_context, std::move(vertex_shader), std::move(fragment_shader)),
 		camera_(camera)
 	{
+		resource_mode_map["GlobalUniform"] = vkb::ShaderResourceMode::Dynamic;
 	}
 
 	void FxGraphSubpass::prepare()
 	{
 		num_particles_ = 6* kParticleCount;
 		auto& resource_cache = render_context.get_device().get_resource_cache();
-		resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader());
-		resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader());
+		apply_resource_modes(resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader()));
+		apply_resource_modes(resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader()));
 		vertex_input_state_.bindings = {
 			vkb::initializers::vertex_input_binding_description(0,sizeof(Particle),VK_VERTEX_INPUT_RATE_VERTEX)
 		};
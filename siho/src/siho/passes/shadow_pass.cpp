@@ -1,6 +1,10 @@
 #include "shadow_pass.h"
 
+#include "geometry/frustum.h"
+#include "rendering/render_context.h"
+#include "scene_graph/components/mesh.h"
 #include "scene_graph/components/orthographic_camera.h"
+#include "scene_graph/components/sub_mesh.h"
 #include "rendering/subpass.h"
 
 namespace
@@ -65,8 +69,6 @@ namespace siho
 		assert(!shader_modules.empty());
 		auto vertex_shader_module = shader_modules[0];
 
-		vertex_shader_module->set_resource_mode("GlobalUniform", vkb::ShaderResourceMode::Dynamic);
-
 		return command_buffer.get_device().get_resource_cache().request_pipeline_layout({ vertex_shader_module });
 	}
 
@@ -76,6 +78,91 @@ namespace siho
 		return;
 	}
 
+	void ShadowSubpass::set_covered_plane(const glm::vec4& plane)
+	{
+		covered_plane_ = plane;
+		has_covered_plane_ = true;
+	}
+
+	glm::vec3 ShadowSubpass::get_light_direction() const
+	{
+		return -glm::normalize(glm::vec3(camera.get_node()->get_transform().get_world_matrix()[2]));
+	}
+
+	void ShadowSubpass::get_culling_planes(std::vector<glm::vec4>& planes)
+	{
+		vkb::Frustum frustum;
+		frustum.update(vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view());
+
+		glm::vec3 light_direction = get_light_direction();
+
+		// Drop the plane facing the light, extruding the cascade volume towards it.
+		// Casters in front of the near plane still shadow the cascade, as depth clamp keeps them.
+		auto& frustum_planes = frustum.get_planes();
+		size_t light_facing_plane = 0;
+		for (size_t i = 1; i < frustum_planes.size(); i++)
+		{
+			if (glm::dot(glm::vec3(frustum_planes[i]), light_direction) > glm::dot(glm::vec3(frustum_planes[light_facing_plane]), light_direction))
+			{
+				light_facing_plane = i;
+			}
+		}
+
+		for (size_t i = 0; i < frustum_planes.size(); i++)
+		{
+			if (i != light_facing_plane)
+			{
+				planes.push_back(frustum_planes[i]);
+			}
+		}
+	}
+
+	void ShadowSubpass::cull_instances(const vkb::AABBBatch& bounds, std::vector<uint8_t>& visibility)
+	{
+		GeometrySubpass::cull_instances(bounds, visibility);
+
+		if (!has_covered_plane_ || bounds.size() == 0)
+		{
+			return;
+		}
+
+		// Receivers of this cascade lie within the extruded volume, so they are among the
+		// instances tested, and a shadow cannot be cast further along the light direction
+		// than their furthest corner
+		glm::vec3 light_direction = get_light_direction();
+		glm::vec3 abs_direction = glm::abs(light_direction);
+		float shadow_end = -FLT_MAX;
+		for (size_t i = 0; i < bounds.size(); i++)
+		{
+			shadow_end = std::max(shadow_end, glm::dot(bounds.get_center(i), light_direction) + glm::dot(bounds.get_extents(i), abs_direction));
+		}
+
+		// Sweep every caster along the light direction up to that distance. If the swept box
+		// lies entirely in the part of the view covered by finer cascades, every receiver it
+		// can shadow samples a finer cascade and this cascade does not need the caster.
+		swept_bounds_.clear();
+		swept_bounds_.reserve(bounds.size());
+		for (size_t i = 0; i < bounds.size(); i++)
+		{
+			glm::vec3 center = bounds.get_center(i);
+			glm::vec3 extents = bounds.get_extents(i);
+
+			float shadow_start = glm::dot(center, light_direction) - glm::dot(extents, abs_direction);
+			glm::vec3 sweep = light_direction * std::max(shadow_end - shadow_start, 0.0f);
+
+			glm::vec3 min_bounds = center - extents;
+			glm::vec3 max_bounds = center + extents;
+			swept_bounds_.add(glm::min(min_bounds, min_bounds + sweep), glm::max(max_bounds, max_bounds + sweep));
+		}
+
+		swept_bounds_.contain(&covered_plane_, 1, covered_);
+
+		for (size_t i = 0; i < visibility.size(); i++)
+		{
+			visibility[i] = visibility[i] && !covered_[i];
+		}
+	}
+
 	ShadowRenderPass::ShadowRenderPass()
 		= default;
 
@@ -98,29 +185,76 @@ namespace siho
 		{
 			update_light_camera(*cascades_[i].light_camera, *main_camera_, i);
 		}
+
+		// Cascade i starts where the finer cascades end, at clip depth cascade_splits_[i].
+		// With reversed depth, points closer to the camera satisfy z - split * w >= 0.
+		glm::mat4 view_projection = main_camera_->get_projection() * main_camera_->get_view();
+		glm::vec4 row_z{ view_projection[0][2], view_projection[1][2], view_projection[2][2], view_projection[3][2] };
+		glm::vec4 row_w{ view_projection[0][3], view_projection[1][3], view_projection[2][3], view_projection[3][3] };
+
+		for (uint32_t i = 1; i < cascades_.size(); i++)
+		{
+			glm::vec4 plane = row_z - cascade_splits_[i] * row_w;
+			plane /= glm::length(glm::vec3(plane));
+			cascades_[i].shadow_subpass->set_covered_plane(plane);
+		}
+	}
+
+	void ShadowRenderPass::record()
+	{
+		auto& job_system = vkb::JobSystem::get();
+		auto& render_frame = render_context_->get_active_frame();
+		const auto& queue = render_context_->get_device().get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);
+
+		for (uint32_t i = 0; i < cascades_.size(); i++)
+		{
+			auto& cascade = cascades_[i];
+			auto& render_target = *cascade.shadow_render_targets[render_context_->get_active_frame_index()];
+
+			// Command buffers are requested on this thread, as the render frame creates its command pools lazily
+			cascade.command_buffer = &render_frame.request_command_buffer(queue, vkb::CommandBuffer::ResetMode::ResetPool,
+				VK_COMMAND_BUFFER_LEVEL_SECONDARY, kShadowThreadIndex + i);
+
+			job_system.schedule(record_counter_, [&cascade, &render_target]()
+				{
+					auto& command_buffer = *cascade.command_buffer;
+					cascade.shadow_render_pipeline->begin_secondary(command_buffer, render_target);
+
+					auto& extent = render_target.get_extent();
+
+					VkViewport viewport{};
+					viewport.width = static_cast<float>(extent.width);
+					viewport.height = static_cast<float>(extent.height);
+					viewport.minDepth = 0.0f;
+					viewport.maxDepth = 1.0f;
+					command_buffer.set_viewport(0, { viewport });
+
+					VkRect2D scissor{};
+					scissor.extent = extent;
+					command_buffer.set_scissor(0, { scissor });
+
+					cascade.shadow_subpass->draw(command_buffer);
+					command_buffer.end();
+				});
+		}
 	}
 
 	void ShadowRenderPass::draw(vkb::CommandBuffer& command_buffer)
 	{
+		vkb::JobSystem::get().wait(record_counter_);
+
 		for (auto& cascade : cascades_)
 		{
 			auto& render_target = *cascade.shadow_render_targets[render_context_->get_active_frame_index()];
-			auto& extent = render_target.get_extent();
-
-			VkViewport viewport{};
-			viewport.width = static_cast<float>(extent.width);
-			viewport.height = static_cast<float>(extent.height);
-			viewport.minDepth = 0.0f;
-			viewport.maxDepth = 1.0f;
-			command_buffer.set_viewport(0, { viewport });
 
-			VkRect2D scissor{};
-			scissor.extent = extent;
-			command_buffer.set_scissor(0, { scissor });
+			assert(cascade.command_buffer && "The cascades must be recorded before they are drawn");
+			std::vector<vkb::CommandBuffer*> secondary_command_buffers{ cascade.command_buffer };
 
 			record_image_memory_barriers(command_buffer, render_target);
-			cascade.shadow_render_pipeline->draw(command_buffer, render_target);
+			cascade.shadow_render_pipeline->draw(command_buffer, render_target, secondary_command_buffers);
 			command_buffer.end_render_pass();
+
+			cascade.command_buffer = nullptr;
 		}
 	}
 
@@ -134,6 +268,11 @@ namespace siho
 		return uniform;
 	}
 
+	const vkb::CullingStats& ShadowRenderPass::get_culling_stats(uint32_t cascade_index) const
+	{
+		return cascades_[cascade_index].shadow_subpass->get_culling_stats();
+	}
+
 	const vkb::core::ImageView& ShadowRenderPass::get_shadowmaps_view() const
 	{
 		return *shadowmap_array_image_views_[render_context_->get_active_frame_index()];
@@ -277,14 +416,21 @@ namespace siho
 
 	void ShadowRenderPass::create_shadow_render_pipelines(vkb::sg::Scene& scene)
 	{
-		for (auto& cascade : cascades_)
+		for (uint32_t i = 0; i < cascades_.size(); i++)
 		{
+			auto& cascade = cascades_[i];
 
 			auto shadowmap_vs = vkb::ShaderSource{ "shadows/shadowmap.vert" };
 			auto shadowmap_fs = vkb::ShaderSource{ "shadows/shadowmap.frag" };
 			auto scene_subpass = std::make_unique<ShadowSubpass>(*render_context_, std::move(shadowmap_vs), std::move(shadowmap_fs), scene, *
 				cascade.light_camera);
 
+			// Levels of detail are selected for the resolution of the shadow map
+			scene_subpass->set_lod_error(1.0f, shadowmap_resolution_);
+
+			// Every cascade is recorded on its own thread
+			scene_subpass->set_thread_index(kShadowThreadIndex + i);
+
 			cascade.shadow_subpass = scene_subpass.get();
 
 			auto shadowmap_render_pipeline = std::make_unique<vkb::RenderPipeline>();
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <core/util/job_system.hpp>
+
 #include "rendering/subpasses/geometry_subpass.h"
 #include "rendering/render_pipeline.h"
 #include "scene_graph/components/orthographic_camera.h"
@@ -7,6 +9,9 @@
 
 constexpr uint32_t kCascadeCount = 3;
 
+// Render frame thread index of the first cascade, the next cascades record with the following ones
+constexpr uint32_t kShadowThreadIndex = 1;
+
 namespace siho
 {
 	struct alignas(16) ShadowUniform
@@ -22,6 +27,13 @@ namespace siho
 			vkb::ShaderSource&& fragment_source,
 			vkb::sg::Scene& scene,
 			vkb::sg::Camera& camera);
+
+		/**
+		 * @brief Sets the plane bounding the part of the view already shadowed by finer cascades,
+		 *        facing towards the camera. Casters whose shadows cannot reach past it are skipped.
+		 */
+		void set_covered_plane(const glm::vec4& plane);
+
 	protected:
 		void prepare_pipeline_state(vkb::CommandBuffer& command_buffer, VkFrontFace front_face, bool double_sided_material) override;
 
@@ -29,6 +41,21 @@ namespace siho
 
 		void prepare_push_constants(vkb::CommandBuffer& command_buffer, vkb::sg::SubMesh& sub_mesh) override;
 
+		void cull_instances(const vkb::AABBBatch& bounds, std::vector<uint8_t>& visibility) override;
+
+		void get_culling_planes(std::vector<glm::vec4>& planes) override;
+
+	private:
+		/**
+		 * @brief Direction the light travels in, the forward axis of the light camera
+		 */
+		glm::vec3 get_light_direction() const;
+
+		bool has_covered_plane_{ false };
+		glm::vec4 covered_plane_{};
+
+		vkb::AABBBatch swept_bounds_;
+		std::vector<uint8_t> covered_;
 	};
 
 	struct Cascade
@@ -37,6 +64,7 @@ namespace siho
 		std::vector<std::unique_ptr<vkb::RenderTarget>> shadow_render_targets;
 		ShadowSubpass* shadow_subpass{};
 		std::unique_ptr<vkb::RenderPipeline> shadow_render_pipeline{};
+		vkb::CommandBuffer* command_buffer{};
 	};
 
 	class ShadowRenderPass
@@ -48,6 +76,14 @@ namespace siho
 
 		void update();
 
+		/**
+		 * @brief Starts recording every cascade into its own secondary command buffer, as jobs of the job system
+		 */
+		void record();
+
+		/**
+		 * @brief Waits for the cascades started by record, and records their render passes executing them
+		 */
 		void draw(vkb::CommandBuffer& command_buffer);
 
 		vkb::sg::Camera& get_light_camera(uint32_t cascade_index) const
@@ -62,6 +98,8 @@ namespace siho
 
 		ShadowUniform get_shadow_uniform() const;
 
+		const vkb::CullingStats& get_culling_stats(uint32_t cascade_index) const;
+
 		const vkb::core::ImageView& get_shadowmaps_view() const;
 
 		static std::unique_ptr<vkb::core::Sampler> create_shadowmap_sampler(vkb::RenderContext& render_context);
@@ -86,5 +124,6 @@ namespace siho
 		//std::unique_ptr<vkb::RenderPipeline> shadow_render_pipeline_{};
 		const uint32_t shadowmap_resolution_{ 2048 };
 		std::array<Cascade, kCascadeCount> cascades_;
+		vkb::JobCounter record_counter_;
 	};
 }
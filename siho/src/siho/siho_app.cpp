@@ -1,4 +1,7 @@
 #include "siho_app.h"
+
+#include <core/util/job_system.hpp>
+
 #include "common/vk_common.h"
 #include "glm/gtc/type_ptr.hpp"
 
@@ -23,7 +26,8 @@ namespace siho
 			VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT };
 		get_render_context().update_swapchain(usage);
 
-		load_scene("scenes/sponza/Sponza01.gltf");
+		// The geometry and shadow shaders restore the quantized positions, in both the direct and indirect paths
+		load_scene("scenes/sponza/Sponza01.gltf", true);
 
 		scene->clear_components<vkb::sg::Light>();
 
@@ -67,9 +71,10 @@ namespace siho
 
 		fx_compute_pass_.init(get_render_context());
 
-		main_pass_.init(get_render_context(), *scene, *camera, shadow_render_pass_, fx_compute_pass_);
+		main_pass_.init(get_render_context(), *scene, *camera, shadow_render_pass_, fx_compute_pass_,
+			kShadowThreadIndex + kCascadeCount, geometry_thread_count_);
 
-		stats->request_stats({ vkb::StatIndex::frame_times });
+		stats->request_stats({ vkb::StatIndex::frame_times, vkb::StatIndex::descriptor_set_allocations, vkb::StatIndex::descriptor_sets_cached });
 
 		gui = std::make_unique<vkb::Gui>(*this, *window, stats.get());
 
@@ -106,7 +111,7 @@ namespace siho
 	void SihoApplication::draw_gui()
 	{
 		const bool landscape = camera->get_aspect_ratio() > 1.0f;
-		uint32_t lines = 2;
+		uint32_t lines = 7;
 
 
 		gui->show_options_window(
@@ -129,32 +134,54 @@ namespace siho
 				}
 
 				ImGui::PopItemWidth();
+
+				const auto& culling_stats = main_pass_.get_culling_stats();
+				ImGui::Text("Visible: %u / Culled: %u", culling_stats.visible, culling_stats.culled);
+				uint32_t tested = culling_stats.visible + culling_stats.occluded;
+				ImGui::Text("Occluded: %u (%.1f%% of the instances in view)", culling_stats.occluded,
+					tested > 0 ? 100.0f * static_cast<float>(culling_stats.occluded) / static_cast<float>(tested) : 0.0f);
+				ImGui::Text("Indirect batches: %u", main_pass_.get_indirect_batch_count());
+				ImGui::Text("Shadow casters: %u / %u / %u",
+					shadow_render_pass_.get_culling_stats(0).visible,
+					shadow_render_pass_.get_culling_stats(1).visible,
+					shadow_render_pass_.get_culling_stats(2).visible);
+
+				// The attachments are shared by the frames in flight, which each had their own before
+				const auto attachment_stats = main_pass_.get_attachment_stats();
+				const float mib = 1.0f / (1024.0f * 1024.0f);
+				ImGui::Text("Attachments: %.1f MiB (%.1f MiB lazy), %.1f MiB per frame before",
+					static_cast<float>(attachment_stats.memory_size) * mib,
+					static_cast<float>(attachment_stats.lazy_memory_size) * mib,
+					static_cast<float>(attachment_stats.frame_memory_size) * mib);
 			},
 			lines);
 	}
 
 	void SihoApplication::prepare_render_context()
 	{
-		get_render_context().prepare(2, [this](vkb::core::Image&& swapchain_image)
+		// The main thread records the primary command buffer, while the cascades and the chunks of the
+		// geometry subpass are recorded into secondary command buffers as jobs, one chunk per thread running jobs
+		geometry_thread_count_ = vkb::JobSystem::get().get_worker_count() + 1;
+
+		// Every secondary command buffer recorded concurrently uses its own render frame pools
+		get_render_context().prepare(kShadowThreadIndex + kCascadeCount + geometry_thread_count_, [this](vkb::core::Image&& swapchain_image)
 			{
-				return MainPass::create_render_target(std::move(swapchain_image));
+				return main_pass_.create_render_target(std::move(swapchain_image));
 			});
 	}
 
 	std::vector<vkb::CommandBuffer*> SihoApplication::record_command_buffers(vkb::CommandBuffer& main_command_buffer)
 	{
-		/*auto reset_mode = vkb::CommandBuffer::ResetMode::ResetPool;
-		const auto& queue = device->get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0);*/
-
 		std::vector<vkb::CommandBuffer*> command_buffers;
-		// shadow_subpass->set_thread_index(1);
 
-		// auto& scene_command_buffer = render_context->get_active_frame().request_command_buffer(queue, reset_mode, VK_COMMAND_BUFFER_LEVEL_SECONDARY, 0);
-		// auto& shadow_command_buffer = render_context->get_active_frame().request_command_buffer(queue, reset_mode, VK_COMMAND_BUFFER_LEVEL_SECONDARY, 1);
+		// The cascades and the chunks of the geometry subpass are recorded by the job system,
+		// while the culling of the main pass is recorded into the primary command buffer
+		shadow_render_pass_.record();
 
 		main_command_buffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+		main_pass_.record(main_command_buffer);
+
 		shadow_render_pass_.draw(main_command_buffer);
-		// draw_main_pass(main_command_buffer);
 		main_pass_.draw(main_command_buffer);
 		if (gui)
 		{
@@ -1,6 +1,5 @@
 #pragma once
 
-#include "ctpl_stl.h"
 #include "platform/application.h"
 #include "vulkan_sample.h"
 #include "scene_graph/components/perspective_camera.h"
@@ -33,7 +32,7 @@ namespace siho
 	private:
 		vkb::sg::PerspectiveCamera* camera{};
 
-		ctpl::thread_pool thread_pool{ 1 };
+		uint32_t geometry_thread_count_{ 1 };
 		uint32_t swapchain_attachment_index{ 0 };
 
 		ShadowRenderPass shadow_render_pass_;